@@ -0,0 +1,386 @@
+/*
+ * analyser.c - round-trip latency / response / THD+N analyser
+ * 10-19-26 E. Brombaugh
+ *
+ * Plays a stimulus on both outputs and records the left input:
+ *
+ *   silence | log-sine sweep | silence | 997Hz sine
+ *
+ * Once the capture is complete the main thread deconvolves the sweep
+ * section against the stimulus with pffft to get the round-trip impulse
+ * response. Its peak gives the latency (ALSA buffering included) and its
+ * spectrum the magnitude / phase response. The tone section is windowed
+ * and transformed to get THD+N. Results go to stderr and optionally CSV.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "pffft.h"
+#include "analyser.h"
+
+/* THD+N test tone and analysis length */
+#define ANA_TONE 997.0
+#define ANA_TONE_N 16384
+
+/* main lobe half-width of the THD+N window in bins */
+#define ANA_LOBE 6
+
+/* response points per octave */
+#define ANA_PPO 6
+
+/* sweep fade in/out */
+#define ANA_FADE_SECS 0.005
+
+/* stimulus layout */
+static uint32_t ana_lead, ana_swp_len, ana_tail, ana_tone_start, ana_total;
+static int ana_rate, ana_chls;
+static double ana_f0, ana_f1;
+static const char *ana_csv;
+
+/* stimulus out / capture in */
+static int16_t *ana_out;
+static float *ana_ref, *ana_cap;
+static volatile uint32_t ana_pos;
+static uint8_t ana_done;
+
+/*
+ * next power of 2
+ */
+static uint32_t ana_pow2(uint32_t n)
+{
+	uint32_t p = 32;
+	while(p < n)
+		p <<= 1;
+	return p;
+}
+
+/*
+ * set up stimulus and capture buffers
+ */
+int32_t ana_init(float amp, float freq, float freq_end, float sweep_secs,
+	const char *csvfile, int chls, int rate)
+{
+	double th, k, L, g, fade;
+	uint32_t i, nfade;
+
+	if(freq <= 0.0F || freq_end <= freq || freq_end > 0.5F*rate || sweep_secs <= 0.0F)
+	{
+		fprintf(stderr, "ana_init: sweep must satisfy 0 < f < F <= rate/2\n");
+		return 1;
+	}
+
+	ana_rate = rate;
+	ana_chls = chls;
+	ana_f0 = freq;
+	ana_f1 = freq_end;
+	ana_csv = csvfile;
+
+	/* layout - the tail bounds the latency that can be measured */
+	ana_lead = rate / 4;
+	ana_swp_len = sweep_secs * rate;
+	ana_tail = rate / 2;
+	ana_tone_start = ana_lead + ana_swp_len + ana_tail;
+	ana_total = ana_tone_start + rate + ANA_TONE_N;
+
+	ana_out = (int16_t *)malloc(ana_total * sizeof(int16_t));
+	ana_ref = (float *)malloc(ana_total * sizeof(float));
+	ana_cap = (float *)malloc(ana_total * sizeof(float));
+	if(!ana_out || !ana_ref || !ana_cap)
+	{
+		fprintf(stderr, "ana_init: out of memory\n");
+		ana_close();
+		return 1;
+	}
+
+	/* exponential sweep - phase from the closed form so it's exact */
+	memset(ana_ref, 0, ana_total * sizeof(float));
+	memset(ana_cap, 0, ana_total * sizeof(float));
+	L = (double)ana_swp_len / log(ana_f1 / ana_f0);
+	k = 2.0 * M_PI * ana_f0 * L / rate;
+	nfade = ANA_FADE_SECS * rate;
+	for(i=0;i<ana_swp_len;i++)
+	{
+		th = k * (exp((double)i / L) - 1.0);
+		g = 1.0;
+		if(i < nfade)
+			g = 0.5 - 0.5*cos(M_PI * i / nfade);
+		else if(i >= ana_swp_len - nfade)
+			g = 0.5 - 0.5*cos(M_PI * (ana_swp_len - 1 - i) / nfade);
+		ana_ref[ana_lead + i] = amp * g * sin(th);
+	}
+
+	/* THD+N tone */
+	for(i=ana_tone_start;i<ana_total;i++)
+	{
+		fade = (i - ana_tone_start) < nfade ?
+			0.5 - 0.5*cos(M_PI * (i - ana_tone_start) / nfade) : 1.0;
+		ana_ref[i] = amp * fade * sin(2.0 * M_PI * ANA_TONE * (i - ana_tone_start) / rate);
+	}
+
+	for(i=0;i<ana_total;i++)
+		ana_out[i] = floor(ana_ref[i] * 32767.0F + 0.5F);
+
+	ana_pos = 0;
+	ana_done = 0;
+
+	fprintf(stderr, "ana_init: %.1f - %.1f Hz sweep over %.2f s, %.2f s total\n",
+		ana_f0, ana_f1, (double)ana_swp_len / rate, (double)ana_total / rate);
+
+	return 0;
+}
+
+/*
+ * free buffers
+ */
+void ana_close(void)
+{
+	free(ana_out);
+	free(ana_ref);
+	free(ana_cap);
+	ana_out = NULL;
+	ana_ref = ana_cap = NULL;
+}
+
+/*
+ * play stimulus & record - dst and src may be the same buffer
+ */
+void ana_process(int16_t *dst, int16_t *src, int inframes)
+{
+	uint32_t pos = ana_pos;
+	int i, c;
+	int16_t s;
+
+	for(i=0;i<inframes;i++)
+	{
+		s = 0;
+		if(pos < ana_total)
+		{
+			ana_cap[pos] = (float)src[0] * (1.0F/32768.0F);
+			s = ana_out[pos++];
+		}
+		for(c=0;c<ana_chls;c++)
+			*dst++ = s;
+		src += ana_chls;
+	}
+
+	__atomic_store_n(&ana_pos, pos, __ATOMIC_RELEASE);
+}
+
+/*
+ * Y = Y.conj(X) / (|X|^2 + eps) on ordered pffft spectra
+ */
+static void ana_deconvolve(float *Y, const float *X, uint32_t N)
+{
+	double xr, xi, yr, yi, d, eps = 0.0;
+	uint32_t k;
+
+	/* regularise relative to the mean stimulus power */
+	for(k=1;k<N/2;k++)
+		eps += X[2*k]*X[2*k] + X[2*k+1]*X[2*k+1];
+	eps = 1e-4 * eps / (N/2);
+
+	/* DC & Nyquist are packed into bin 0 - the sweep has neither */
+	Y[0] = Y[1] = 0.0F;
+	for(k=1;k<N/2;k++)
+	{
+		xr = X[2*k]; xi = X[2*k+1];
+		yr = Y[2*k]; yi = Y[2*k+1];
+		d = xr*xr + xi*xi + eps;
+		Y[2*k] = (yr*xr + yi*xi) / d;
+		Y[2*k+1] = (yi*xr - yr*xi) / d;
+	}
+}
+
+/*
+ * write or print the response at log-spaced points
+ */
+static void ana_response(FILE *f, const float *H, uint32_t N, int32_t lat)
+{
+	double fc, fl, fh, re, im, c, s, w, mag, ph;
+	uint32_t k, kl, kh, cnt;
+
+	fprintf(f, "freq_hz,mag_db,phase_deg\n");
+	for(fc=ana_f0;fc<=ana_f1*1.0001;fc*=pow(2.0, 1.0/ANA_PPO))
+	{
+		/* average over the band around the point */
+		fl = fc * pow(2.0, -0.5/ANA_PPO);
+		fh = fc * pow(2.0, 0.5/ANA_PPO);
+		kl = (uint32_t)ceil(fl * N / ana_rate);
+		kh = (uint32_t)floor(fh * N / ana_rate);
+		kl = kl < 1 ? 1 : kl;
+		kh = kh > N/2-1 ? N/2-1 : kh;
+		if(kh < kl)
+			kh = kl = (uint32_t)floor(fc * N / ana_rate + 0.5);
+
+		re = im = 0.0;
+		cnt = 0;
+		for(k=kl;k<=kh;k++)
+		{
+			/* take out the bulk delay so the phase is readable */
+			w = 2.0 * M_PI * k * lat / N;
+			c = cos(w);
+			s = sin(w);
+			re += H[2*k]*c - H[2*k+1]*s;
+			im += H[2*k]*s + H[2*k+1]*c;
+			cnt++;
+		}
+		re /= cnt;
+		im /= cnt;
+		mag = 10.0 * log10(re*re + im*im + 1e-20);
+		ph = atan2(im, re) * 180.0 / M_PI;
+		fprintf(f, "%.2f,%.3f,%.2f\n", fc, mag, ph);
+	}
+}
+
+/*
+ * THD+N of the tone section - returns ratio, level via pointer
+ */
+static double ana_thdn(PFFFT_Setup *s, float *buf, float *work, uint32_t start,
+	double *level)
+{
+	double w, sw2 = 0.0, p, fund = 0.0, tot = 0.0;
+	uint32_t i, k, kf, klo, khi;
+
+	/* 4-term Blackman-Harris */
+	for(i=0;i<ANA_TONE_N;i++)
+	{
+		w = 2.0 * M_PI * i / ANA_TONE_N;
+		w = 0.35875 - 0.48829*cos(w) + 0.14128*cos(2*w) - 0.01168*cos(3*w);
+		buf[i] = ana_cap[start + i] * w;
+		sw2 += w*w;
+	}
+	pffft_transform_ordered(s, buf, buf, work, PFFFT_FORWARD);
+
+	/* fundamental main lobe vs everything else in the audio band */
+	kf = (uint32_t)floor(ANA_TONE * ANA_TONE_N / ana_rate + 0.5);
+	klo = (uint32_t)ceil(20.0 * ANA_TONE_N / ana_rate);
+	khi = (uint32_t)floor(fmin(20000.0, 0.5*ana_rate) * ANA_TONE_N / ana_rate);
+	khi = khi > ANA_TONE_N/2-1 ? ANA_TONE_N/2-1 : khi;
+	for(k=klo;k<=khi;k++)
+	{
+		p = buf[2*k]*buf[2*k] + buf[2*k+1]*buf[2*k+1];
+		tot += p;
+		if(k + ANA_LOBE >= kf && k <= kf + ANA_LOBE)
+			fund += p;
+	}
+
+	/* one-sided Parseval for the sine amplitude */
+	*level = 20.0 * log10(sqrt(4.0 * fund / (ANA_TONE_N * sw2)) + 1e-20);
+
+	return fund > 0.0 ? sqrt((tot - fund) / fund) : 1.0;
+}
+
+/*
+ * run the analysis in the caller's thread once capture is done
+ */
+static void ana_analyse(void)
+{
+	PFFFT_Setup *s;
+	float *X, *Y, *work, pk, a, b, c, frac = 0.0F;
+	const char *pol;
+	uint32_t N, len, i, peak, start;
+	int32_t lat;
+	double thdn, level;
+	FILE *f;
+
+	/* sweep section plus the tail, padded so the correlation can't wrap */
+	len = ana_lead + ana_swp_len + ana_tail;
+	N = ana_pow2(2*len);
+	s = pffft_new_setup(N, PFFFT_REAL);
+	X = (float *)pffft_aligned_malloc(N * sizeof(float));
+	Y = (float *)pffft_aligned_malloc(N * sizeof(float));
+	work = (float *)pffft_aligned_malloc(N * sizeof(float));
+	if(!s || !X || !Y || !work)
+	{
+		fprintf(stderr, "ana_analyse: couldn't set up FFT of %u\n", N);
+		goto out;
+	}
+
+	memset(X, 0, N * sizeof(float));
+	memset(Y, 0, N * sizeof(float));
+	memcpy(X, ana_ref, len * sizeof(float));
+	memcpy(Y, ana_cap, len * sizeof(float));
+	pffft_transform_ordered(s, X, X, work, PFFFT_FORWARD);
+	pffft_transform_ordered(s, Y, Y, work, PFFFT_FORWARD);
+	ana_deconvolve(Y, X, N);
+
+	/* impulse response - keep H in X for the response plot */
+	memcpy(X, Y, N * sizeof(float));
+	pffft_transform_ordered(s, Y, Y, work, PFFFT_BACKWARD);
+
+	/* latency is the biggest peak - only causal lags are possible */
+	peak = 0;
+	pk = 0.0F;
+	for(i=0;i<N/2;i++)
+	{
+		if(fabsf(Y[i]) > pk)
+		{
+			pk = fabsf(Y[i]);
+			peak = i;
+		}
+	}
+	if(peak > 0 && peak < N/2-1)
+	{
+		a = fabsf(Y[peak-1]);
+		b = fabsf(Y[peak]);
+		c = fabsf(Y[peak+1]);
+		if(a - 2.0F*b + c != 0.0F)
+			frac = 0.5F * (a - c) / (a - 2.0F*b + c);
+	}
+	lat = peak;
+	pol = Y[peak] < 0.0F ? "inverted" : "normal";
+
+	fprintf(stderr, "latency: %.2f samples, %.3f ms, polarity %s, peak %.3f\n",
+		lat + frac, 1000.0 * (lat + frac) / ana_rate, pol, pk / N);
+
+	/* THD+N after the tone has settled */
+	pffft_destroy_setup(s);
+	s = pffft_new_setup(ANA_TONE_N, PFFFT_REAL);
+	start = ana_tone_start + lat + ana_rate / 4;
+	if(start + ANA_TONE_N > ana_total)
+		start = ana_total - ANA_TONE_N;
+	thdn = ana_thdn(s, Y, work, start, &level);
+	fprintf(stderr, "THD+N: %.2f dB (%.4f %%) at %.1f Hz, level %.2f dBFS\n",
+		20.0 * log10(thdn + 1e-20), 100.0 * thdn, ANA_TONE, level);
+
+	/* response to CSV or stdout */
+	f = stdout;
+	if(ana_csv && !(f = fopen(ana_csv, "w")))
+	{
+		fprintf(stderr, "ana_analyse: couldn't open %s\n", ana_csv);
+		f = stdout;
+	}
+	fprintf(f, "# rate %d, %d channels, buffer %d bytes, %u periods\n",
+		ana_rate, ana_chls, buffer_size, fragments);
+	fprintf(f, "# latency_samples %.2f, polarity %s, thdn_db %.2f, level_dbfs %.2f\n",
+		lat + frac, pol, 20.0 * log10(thdn + 1e-20), level);
+	ana_response(f, X, N, lat);
+	if(f != stdout)
+		fclose(f);
+
+out:
+	if(s)
+		pffft_destroy_setup(s);
+	pffft_aligned_free(X);
+	pffft_aligned_free(Y);
+	pffft_aligned_free(work);
+}
+
+/*
+ * check for end of capture - returns 1 once the analysis is finished
+ */
+int32_t ana_poll(void)
+{
+	if(ana_done)
+		return 1;
+
+	if(__atomic_load_n(&ana_pos, __ATOMIC_ACQUIRE) < ana_total)
+		return 0;
+
+	ana_analyse();
+	ana_done = 1;
+	return 1;
+}
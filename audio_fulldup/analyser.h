@@ -0,0 +1,17 @@
+/*
+ * analyser.h - round-trip latency / response / THD+N analyser
+ * 10-19-26 E. Brombaugh
+ */
+
+#ifndef __analyser__
+#define __analyser__
+
+#include <stdint.h>
+
+int32_t ana_init(float amp, float freq, float freq_end, float sweep_secs,
+	const char *csvfile, int chls, int rate);
+void ana_close(void);
+void ana_process(int16_t *dst, int16_t *src, int inframes);
+int32_t ana_poll(void);
+
+#endif
@@ -1,93 +1,199 @@
 /*
  * audio.c - audio processing routines for long delay
  * 08-20-20 E. Brombaugh
+ * 10-19-26 E. Brombaugh - reject empty or oversized delay buffers
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "main.h"
 #include "audio.h"
-
-/* stereo or mono */
-#define CHLS 2
+#include "dlyfile.h"
+#include "osc.h"
+#include "analyser.h"
 
 #define FADE_BITS 11
 #define FADE_MAX ((1<<FADE_BITS)-1)
 
-#define NUM_PT 3
-#define WAV_PHS 10
-#define WAV_LEN (1<<WAV_PHS)
-#define INTERP_BITS 10
-
-enum fadestate 
-{
-    FADE_OFF,
-    FADE_IN,
-    FADE_OUT,
-};
+#define NUM_PT 7
 
 uint32_t bufsz;
 int16_t *dlybuf, *wptr;
 uint32_t fadecnt;
-int32_t gain;
-uint8_t init, fadest, pt;
-int32_t frq, phs;
-int16_t sinetab[1024];
+uint8_t init, pt, dlydisk;
+int chls;
+
+/* block processing for the selected type */
+static void (*proc_fn)(int16_t *dst, int16_t *src, int inframes);
 
 /*
- * sine waveform interp
+ * fade in the start of the input - only touches frames while fading
  */
-int16_t sine_interp(uint32_t phs)
+static void Audio_Fade(int16_t *buf, int inframes)
 {
+	uint8_t chl;
 	
-	int32_t a, b, sum;
-	uint32_t ip, fp;
+	while(inframes-- && fadecnt)
+	{
+		for(chl=0;chl<chls;chl++)
+			buf[chl] = (buf[chl] * (FADE_MAX-fadecnt))>>FADE_BITS;
+		buf += chls;
+		fadecnt--;
+	}
+}
+
+/*
+ * test signals
+ */
+static void Audio_Proc_Osc(int16_t *dst, int16_t *src, int inframes)
+{
+	osc_render(dst, inframes);
+}
+
+/*
+ * immediate loopback - all but the left channel
+ */
+static void Audio_Proc_Loop(int16_t *dst, int16_t *src, int inframes)
+{
+	memcpy(dst, src, inframes*chls*sizeof(int16_t));
+	if(chls > 1)
+	{
+		while(inframes--)
+		{
+			*dst = 0;
+			dst += chls;
+		}
+	}
+}
+
+/*
+ * delayed loopback in RAM - at most two spans either side of the wrap
+ */
+static void Audio_Proc_Delay(int16_t *dst, int16_t *src, int inframes)
+{
+	uint32_t span, len = inframes*chls;
 	
-	ip = phs>>(32-WAV_PHS);
-	a = sinetab[ip];
-	b = sinetab[(ip + 1)&(WAV_LEN-1)];
+	/* only the start of the input needs the fade */
+	if(fadecnt)
+		Audio_Fade(src, inframes);
 	
-	fp = (phs & ((1<<(32-WAV_PHS))-1)) >> ((32-WAV_PHS)-INTERP_BITS);
-	sum = b * fp;
-	sum += a * (((1<<INTERP_BITS)-1)-fp);
+	while(len)
+	{
+		span = bufsz - (wptr-dlybuf);
+		span = span > len ? len : span;
+		
+		/* no output until buffer filled */
+		if(init)
+			memset(dst, 0, span*sizeof(int16_t));
+		else
+			memcpy(dst, wptr, span*sizeof(int16_t));
+		memcpy(wptr, src, span*sizeof(int16_t));
+		
+		dst += span;
+		src += span;
+		wptr += span;
+		len -= span;
+		
+		/* wrap pointer */
+		if((wptr-dlybuf) >= bufsz)
+		{
+			wptr = dlybuf;
+			init = 0;
+		}
+	}
+}
+
+/*
+ * delayed loopback on disk
+ */
+static void Audio_Proc_DelayDisk(int16_t *dst, int16_t *src, int inframes)
+{
+	if(fadecnt)
+		Audio_Fade(src, inframes);
 	
-	return sum >> INTERP_BITS; 
+	dlyfile_process(dst, src, inframes);
+}
+
+/*
+ * analyser plays stimulus & records
+ */
+static void Audio_Proc_Ana(int16_t *dst, int16_t *src, int inframes)
+{
+	ana_process(dst, src, inframes);
 }
 
 /*
  * init audio
  */
-int32_t Audio_Init(uint32_t dlysamp, uint8_t proc_typ, float amp, float freq)
+int32_t Audio_Init(uint32_t dlysamp, int num_chls, uint8_t proc_typ, float amp,
+	float freq, const char *dlyfile, uint8_t wave, uint8_t voices, float freq_end,
+	float sweep_secs, const char *csvfile)
 {
-	/* NCO */
-	phs = 0;
-	frq = (int32_t)floorf(freq * powf(2.0F, 32.0F) / 48000.0F);
+	/* processing type */
+	pt = proc_typ%NUM_PT;
+	chls = num_chls;
 	
-	/* build sinewave LUT */
-	float th = 0.0F, thinc = 6.2832F/((float)WAV_LEN);
-	for(int i=0;i<WAV_LEN;i++)
+	/* test signals come from the oscillator bank */
+	proc_fn = Audio_Proc_Osc;
+	switch(pt)
 	{
-		sinetab[i] = floorf(32767.0F * sinf(th) + 0.5F);
-		th += thinc;
+		case 0:
+			return osc_init(OSC_BANK, wave, 1, amp, freq, freq, 0.0F, chls, sample_rate);
+		
+		case 1:
+			return osc_init(OSC_BANK, OSC_SAW, 1, amp, freq, freq, 0.0F, chls, sample_rate);
+		
+		case 3:
+			proc_fn = Audio_Proc_Loop;
+			return 0;
+		
+		case 4:
+			return osc_init(OSC_BANK, wave, voices, amp, freq, freq_end, 0.0F, chls, sample_rate);
+		
+		case 5:
+			return osc_init(OSC_SWEEP, wave, 1, amp, freq, freq_end, sweep_secs, chls, sample_rate);
+		
+		case 6:
+			proc_fn = Audio_Proc_Ana;
+			return ana_init(amp, freq, freq_end, sweep_secs, csvfile, chls, sample_rate);
 	}
 	
-	/* processing type */
-	pt = proc_typ%NUM_PT;
+	/* delay buffer - at least one frame and its size in bytes must fit */
+	if(!dlysamp || (uint64_t)chls*dlysamp > UINT32_MAX ||
+		(uint64_t)chls*dlysamp > SIZE_MAX/sizeof(int16_t))
+	{
+		fprintf(stderr, "Audio_Init: bad delay length %u x %d chls\n",
+			dlysamp, chls);
+		return 1;
+	}
+    bufsz = chls*dlysamp;
+    dlybuf = NULL;
+    wptr = dlybuf;
+    init = 1;
+    fadecnt = FADE_MAX;
+	dlydisk = 0;
 	
-	/* output gain shift */
-	gain = amp * 32767.0F;
+	/* delay on disk if a file was given */
+	if(dlyfile)
+	{
+		if(dlyfile_init(dlyfile, dlysamp, chls))
+			return 1;
+		dlydisk = 1;
+		proc_fn = Audio_Proc_DelayDisk;
+		return 0;
+	}
 	
-	/* delay buffer */
-    bufsz = CHLS*dlysamp;
+	/* delay in RAM - touch it all now so page faults don't hit the audio */
+	proc_fn = Audio_Proc_Delay;
     dlybuf = (int16_t *)malloc(bufsz*sizeof(int16_t));
     wptr = dlybuf;
-    init = 1;
-    fadecnt = FADE_MAX;
-    fadest =  FADE_IN;
-    
     if(dlybuf)
+    {
+        memset(dlybuf, 0, bufsz*sizeof(int16_t));
         return 0;
+    }
     else
         return 1;
 }
@@ -99,90 +205,29 @@ void Audio_Close(void)
 {
     if(dlybuf)
         free(dlybuf);
+    if(dlydisk)
+        dlyfile_close();
+    if(pt == 6)
+        ana_close();
 }
 
 /*
  * process the audio
  */
-void Audio_Process(char *rdbuf, int inframes)
+void Audio_Process(char *wrbuf, char *rdbuf, int inframes)
 {
-	int16_t *src = (int16_t *)rdbuf;
-	int16_t *dst = src;
-	int16_t tbuf[CHLS];
-	uint16_t index;
-    int32_t tmpscl;
-    uint8_t chl;
-    
-	/* process I2S data */
-	for(index=0;index<inframes;index++)
-	{
-		if(pt == 2)
-		{
-			/* delayed loopback */
-			/* get output from buffer */
-			if(!init)
-			{
-				for(chl=0;chl<CHLS;chl++)
-					tbuf[chl] = *(wptr+chl);
-			}
-			else
-			{
-				/* no output until buffer filled */
-				for(chl=0;chl<CHLS;chl++)
-					tbuf[chl] = 0;
-			}
-			
-			/* save input in buffer */
-			for(chl=0;chl<CHLS;chl++)
-			{
-				tmpscl = *src++;
-				if(fadest == FADE_IN)
-					tmpscl = (tmpscl * (FADE_MAX-fadecnt))>>FADE_BITS;
-				
-				*wptr++ = tmpscl;
-				*dst++ = tbuf[chl];
-			}
-			
-			/* wrap pointer */
-			if((wptr-dlybuf) >= bufsz)
-			{
-				wptr = dlybuf;
-				//printf("%1d",init);
-				//fflush(stdout);
-				init = 0;
-			}
-			
-			/* update fader */
-			if(fadecnt)
-			{
-				fadecnt--;
-				if(fadecnt==0)
-					fadest = FADE_OFF;
-			}
-		}
-		else if(pt==3)
-		{
-			/* immediate loopback */
-			for(chl=0;chl<CHLS;chl++)
-				*dst++ = (*src++)*chl;
-		}
-		else if(pt==1)
-		{
-			/* sawtooth generation */
-			int32_t wav = (((int32_t)phs >> 16)*gain) >> 15;
-			*dst++ = wav;
-			*dst++ = -wav;
-			phs += frq;
-		}
-		else
-		{
-			/* sine generation */
-			int32_t wav = (sine_interp((uint32_t)phs)*gain)>>15;
-			*dst++ = wav;
-			*dst++ = -wav;
-			phs += frq;
-		}
-	}
+	proc_fn((int16_t *)wrbuf, (int16_t *)rdbuf, inframes);
+}
+
+/*
+ * check for a finished measurement - returns 1 when it's time to quit
+ */
+int32_t Audio_Poll(void)
+{
+	if(pt == 6)
+		return ana_poll();
+	
+	return 0;
 }
 
 /*
@@ -190,4 +235,6 @@ void Audio_Process(char *rdbuf, int inframes)
  */
 void Audio_Status(void)
 {
+	if(dlydisk)
+		dlyfile_status();
 }
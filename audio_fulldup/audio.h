@@ -6,9 +6,12 @@
 #ifndef __audio__
 #define __audio__
 
-int32_t Audio_Init(uint32_t dlysamp, uint8_t proc_typ, float amp, float freq);
+int32_t Audio_Init(uint32_t dlysamp, int num_chls, uint8_t proc_typ, float amp,
+	float freq, const char *dlyfile, uint8_t wave, uint8_t voices, float freq_end,
+	float sweep_secs, const char *csvfile);
 void Audio_Close(void);
-void Audio_Process(char *rdbuf, int inframes);
+void Audio_Process(char *wrbuf, char *rdbuf, int inframes);
+int32_t Audio_Poll(void);
 void Audio_Status(void);
 
 #endif
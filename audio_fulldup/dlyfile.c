@@ -0,0 +1,344 @@
+/*
+ * dlyfile.c - disk-backed delay line for long delay
+ * 10-19-26 E. Brombaugh
+ *
+ * The delay line lives in a file on disk. Only a small ring of chunk slots
+ * is held in RAM: a background I/O thread reads each chunk ahead of the
+ * audio position and writes it back once the audio thread has swapped the
+ * new input into it, so RSS stays constant no matter how long the delay.
+ * The audio thread never blocks on I/O - if a chunk isn't ready in time it
+ * outputs silence and counts an underrun.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include "dlyfile.h"
+
+/* I/O chunk size - must be a multiple of the O_DIRECT block size */
+#define DLYF_CHUNK (64*1024)
+
+/* number of chunks held in RAM for readahead / writeback */
+#define DLYF_NSLOT 16
+
+/* worker wakeup timeout */
+#define DLYF_WAIT_NS 5000000
+
+static int dlyf_fd = -1;
+static uint8_t dlyf_direct;
+static uint32_t dlyf_frmsz, dlyf_chunk_frames;
+static uint64_t dlyf_frames, dlyf_nchunks, dlyf_ahead;
+static int16_t *dlyf_slots;
+
+/* chunk counters - only ever increase */
+static volatile uint64_t dlyf_rd_done;	/* chunks read by the worker */
+static volatile uint64_t dlyf_au_done;	/* chunks consumed by the audio thread */
+static volatile uint64_t dlyf_wr_done;	/* chunks written by the worker */
+
+/* audio thread position */
+static uint32_t dlyf_au_pos;
+static uint64_t dlyf_au_total;
+
+/* worker */
+static pthread_t dlyf_thread;
+static sem_t dlyf_sem;
+static volatile uint8_t dlyf_quit;
+static uint8_t dlyf_running;
+
+/* statistics */
+static volatile uint32_t dlyf_underruns, dlyf_ioerrs;
+static volatile uint32_t dlyf_max_stall_us, dlyf_max_io_us;
+
+/*
+ * microsecond timestamp
+ */
+static uint64_t dlyfile_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * number of frames in a chunk - last one in the file may be short
+ */
+static uint32_t dlyfile_chunk_len(uint64_t chunk)
+{
+	if((chunk % dlyf_nchunks) == dlyf_nchunks-1)
+		return dlyf_frames - (dlyf_nchunks-1) * dlyf_chunk_frames;
+	else
+		return dlyf_chunk_frames;
+}
+
+/*
+ * address of the RAM slot holding a chunk
+ */
+static int16_t *dlyfile_slot(uint64_t chunk)
+{
+	return (int16_t *)((char *)dlyf_slots + (chunk % DLYF_NSLOT) * DLYF_CHUNK);
+}
+
+/*
+ * move one chunk between disk and its RAM slot
+ */
+static void dlyfile_io(uint64_t chunk, uint8_t wr)
+{
+	off_t ofs = (off_t)(chunk % dlyf_nchunks) * DLYF_CHUNK;
+	char *buf = (char *)dlyfile_slot(chunk);
+	size_t done = 0;
+	ssize_t n;
+	uint64_t t0 = dlyfile_us(), dt;
+
+	while(done < DLYF_CHUNK)
+	{
+		if(wr)
+			n = pwrite(dlyf_fd, buf + done, DLYF_CHUNK - done, ofs + done);
+		else
+			n = pread(dlyf_fd, buf + done, DLYF_CHUNK - done, ofs + done);
+
+		if(n < 0 && errno == EINTR)
+			continue;
+
+		if(n <= 0)
+		{
+			/* short read past end or error - don't play garbage */
+			if(!wr)
+				memset(buf + done, 0, DLYF_CHUNK - done);
+			dlyf_ioerrs++;
+			break;
+		}
+		done += n;
+	}
+
+	dt = dlyfile_us() - t0;
+	if(dt > dlyf_max_io_us)
+		dlyf_max_io_us = dt;
+}
+
+/*
+ * I/O thread - writeback has priority over readahead
+ */
+static void *dlyfile_thread_handler(void *ptr)
+{
+	struct timespec ts;
+	uint64_t au, rd, wr;
+
+	while(!dlyf_quit)
+	{
+		au = __atomic_load_n(&dlyf_au_done, __ATOMIC_ACQUIRE);
+		rd = dlyf_rd_done;
+		wr = dlyf_wr_done;
+
+		if(wr < au)
+		{
+			/* write back chunk the audio thread has finished with */
+			dlyfile_io(wr, 1);
+			__atomic_store_n(&dlyf_wr_done, wr+1, __ATOMIC_RELEASE);
+		}
+		else if(rd < wr + dlyf_ahead)
+		{
+			/* slot & file area free so read ahead - first pass is never played */
+			if(rd >= dlyf_nchunks)
+				dlyfile_io(rd, 0);
+			__atomic_store_n(&dlyf_rd_done, rd+1, __ATOMIC_RELEASE);
+		}
+		else
+		{
+			/* nothing to do until the audio thread finishes a chunk */
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_nsec += DLYF_WAIT_NS;
+			if(ts.tv_nsec >= 1000000000)
+			{
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000;
+			}
+			sem_timedwait(&dlyf_sem, &ts);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * open the delay file and start the I/O thread
+ */
+int32_t dlyfile_init(const char *path, uint64_t dlysamp, uint8_t chls)
+{
+	dlyf_frmsz = chls * sizeof(int16_t);
+	dlyf_chunk_frames = DLYF_CHUNK / dlyf_frmsz;
+	dlyf_frames = dlysamp;
+	dlyf_nchunks = (dlysamp + dlyf_chunk_frames - 1) / dlyf_chunk_frames;
+	if(!dlyf_nchunks)
+		return 1;
+
+	/* try direct I/O first so the page cache doesn't fill with old audio */
+	dlyf_direct = 1;
+	dlyf_fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+	if(dlyf_fd < 0)
+	{
+		dlyf_direct = 0;
+		dlyf_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	}
+	if(dlyf_fd < 0)
+	{
+		fprintf(stderr, "dlyfile_init: couldn't open %s\n", path);
+		return 1;
+	}
+
+	/* size the file - sparse until first written */
+	if(ftruncate(dlyf_fd, (off_t)dlyf_nchunks * DLYF_CHUNK))
+	{
+		fprintf(stderr, "dlyfile_init: couldn't size %s\n", path);
+		goto err_file;
+	}
+	if(!dlyf_direct)
+		posix_fadvise(dlyf_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	/* RAM slots - aligned for O_DIRECT, pre-faulted and locked */
+	if(posix_memalign((void **)&dlyf_slots, 4096, DLYF_NSLOT * DLYF_CHUNK))
+	{
+		dlyf_slots = NULL;
+		goto err_file;
+	}
+	memset(dlyf_slots, 0, DLYF_NSLOT * DLYF_CHUNK);
+	mlock(dlyf_slots, DLYF_NSLOT * DLYF_CHUNK);
+
+	/* reset state - first pass through the file needs no reads */
+	dlyf_ahead = DLYF_NSLOT < dlyf_nchunks ? DLYF_NSLOT : dlyf_nchunks;
+	dlyf_rd_done = dlyf_ahead;
+	dlyf_au_done = dlyf_wr_done = 0;
+	dlyf_au_pos = 0;
+	dlyf_au_total = 0;
+	dlyf_underruns = dlyf_ioerrs = 0;
+	dlyf_max_stall_us = dlyf_max_io_us = 0;
+
+	/* start I/O */
+	dlyf_quit = 0;
+	sem_init(&dlyf_sem, 0, 0);
+	if(pthread_create(&dlyf_thread, NULL, dlyfile_thread_handler, NULL))
+	{
+		fprintf(stderr, "dlyfile_init: couldn't start I/O thread\n");
+		goto err_thread;
+	}
+	dlyf_running = 1;
+
+	fprintf(stderr, "dlyfile_init: %llu chunks of %d bytes in %s (%s I/O)\n",
+		(unsigned long long)dlyf_nchunks, DLYF_CHUNK, path,
+		dlyf_direct ? "direct" : "buffered");
+
+	return 0;
+
+err_thread:
+	sem_destroy(&dlyf_sem);
+	munlock(dlyf_slots, DLYF_NSLOT * DLYF_CHUNK);
+	free(dlyf_slots);
+	dlyf_slots = NULL;
+err_file:
+	close(dlyf_fd);
+	dlyf_fd = -1;
+	return 1;
+}
+
+/*
+ * stop the I/O thread and free resources
+ */
+void dlyfile_close(void)
+{
+	if(dlyf_running)
+	{
+		dlyf_quit = 1;
+		sem_post(&dlyf_sem);
+		pthread_join(dlyf_thread, NULL);
+		sem_destroy(&dlyf_sem);
+		dlyf_running = 0;
+	}
+
+	if(dlyf_slots)
+	{
+		munlock(dlyf_slots, DLYF_NSLOT * DLYF_CHUNK);
+		free(dlyf_slots);
+		dlyf_slots = NULL;
+	}
+
+	if(dlyf_fd >= 0)
+	{
+		close(dlyf_fd);
+		dlyf_fd = -1;
+	}
+}
+
+/*
+ * swap input into the delay line and fetch delayed output - never blocks
+ */
+void dlyfile_process(int16_t *dst, int16_t *src, int inframes)
+{
+	uint64_t t0 = dlyfile_us(), dt;
+	uint32_t len, span, i;
+	int16_t *slot, tmp;
+	uint8_t mute;
+
+	while(inframes)
+	{
+		/* has the worker fetched the current chunk yet? */
+		if(dlyf_au_done >= __atomic_load_n(&dlyf_rd_done, __ATOMIC_ACQUIRE))
+		{
+			/* no - drop this block rather than wait on the disk */
+			memset(dst, 0, inframes * dlyf_frmsz);
+			dlyf_underruns++;
+			break;
+		}
+
+		/* swap as much as possible within this chunk */
+		len = dlyfile_chunk_len(dlyf_au_done);
+		span = len - dlyf_au_pos;
+		span = span > inframes ? inframes : span;
+		slot = dlyfile_slot(dlyf_au_done) + dlyf_au_pos * (dlyf_frmsz / sizeof(int16_t));
+
+		/* no output until the delay has filled once */
+		mute = dlyf_au_total < dlyf_frames;
+		for(i=0;i<span*(dlyf_frmsz/sizeof(int16_t));i++)
+		{
+			tmp = slot[i];
+			slot[i] = src[i];
+			dst[i] = mute ? 0 : tmp;
+		}
+
+		src += i;
+		dst += i;
+		inframes -= span;
+		dlyf_au_pos += span;
+		dlyf_au_total += span;
+
+		/* hand a finished chunk to the worker for writeback */
+		if(dlyf_au_pos == len)
+		{
+			dlyf_au_pos = 0;
+			__atomic_store_n(&dlyf_au_done, dlyf_au_done+1, __ATOMIC_RELEASE);
+			sem_post(&dlyf_sem);
+		}
+	}
+
+	/* track worst-case time spent in the audio thread */
+	dt = dlyfile_us() - t0;
+	if(dt > dlyf_max_stall_us)
+		dlyf_max_stall_us = dt;
+}
+
+/*
+ * print status
+ */
+void dlyfile_status(void)
+{
+	fprintf(stderr, "dly: %6llu/%6llu chunks, underruns %u, I/O errs %u, max stall %u us, max I/O %u us \r",
+		(unsigned long long)(dlyf_au_done % dlyf_nchunks),
+		(unsigned long long)dlyf_nchunks,
+		dlyf_underruns, dlyf_ioerrs, dlyf_max_stall_us, dlyf_max_io_us);
+}
@@ -0,0 +1,16 @@
+/*
+ * dlyfile.h - disk-backed delay line for long delay
+ * 10-19-26 E. Brombaugh
+ */
+
+#ifndef __dlyfile__
+#define __dlyfile__
+
+#include <stdint.h>
+
+int32_t dlyfile_init(const char *path, uint64_t dlysamp, uint8_t chls);
+void dlyfile_close(void);
+void dlyfile_process(int16_t *dst, int16_t *src, int inframes);
+void dlyfile_status(void);
+
+#endif
@@ -1,6 +1,10 @@
 /*
  * main.c - long delay based on full duplex audio in/out with low-level ALSA lib
  * 08-20-20 E. Brombaugh
+ * 10-19-26 E. Brombaugh - refill with silence after an underrun
+ * 10-19-26 E. Brombaugh - fail if in and out differ in channel count
+ * 10-19-26 E. Brombaugh - range check the delay time
+ * 10-19-26 E. Brombaugh - range check the voices and frequencies
  */
 
 #if 1
@@ -16,6 +20,7 @@
 #include <pthread.h>
 #include "main.h"
 #include "audio.h"
+#include "osc.h"
 
 /* version */
 const char *swVersionStr = "V0.1";
@@ -43,8 +48,11 @@ int 				bits = 16;
 int                 dlytime = 1;
 int 				err;
 int					exit_program = 0;
+int					verbose = 0;
+char				*dly_file = NULL;
+char				*csv_file = NULL;
 long				play_vol = 80;
-char				*rdbuf;
+char				*rdbuf, *wrbuf, *zbuf;
 unsigned int		fragments = 2;
 int					frame_size;
 snd_pcm_uframes_t   frames, inframes, outframes;
@@ -108,13 +116,21 @@ int configure_alsa_audio(snd_pcm_t *device, int channels)
 		sample_rate = tmp;
 	}
 	
-	if((err = snd_pcm_hw_params_set_channels(device, hw_params, channels)) < 0)
+	tmp = channels;
+	if((err = snd_pcm_hw_params_set_channels_near(device, hw_params, &tmp)) < 0)
 	{
 		fprintf (stderr, "cannot set channel count: %s\n",
 			snd_strerror(err));
 		return 1;
 	}
 	
+	if(tmp != channels)
+	{
+		fprintf(stderr, "Could not set requested channel count, %d != %d\n",
+			channels, tmp);
+		nchannels = channels = tmp;
+	}
+	
 	if((err = snd_pcm_hw_params_set_periods_near(device, hw_params,
 		&fragments, 0)) < 0)
 	{
@@ -159,6 +175,22 @@ void handle_signals(int s)
 	exit_program = 1;
 }
 
+/*
+ * playback underrun - recover and fill the output buffer with silence again
+ * as at startup, so the loop keeps the same latency
+ */
+int playback_recover(int err)
+{
+	unsigned int i;
+	int xrun = (err == -EPIPE || err == -ESTRPIPE);
+
+	if((err = snd_pcm_recover(playback_handle, err, 1)) || !xrun)
+		return err;
+	for(i = 0; i < fragments; i += 1)
+		snd_pcm_writei(playback_handle, zbuf, frames);
+	return 0;
+}
+
 /*
  * audio thread
  */
@@ -184,14 +216,14 @@ void *audio_thread_handler(void *ptr)
 				inframes, frames);
 
 		/* now processes the frames */
-		Audio_Process(rdbuf, inframes);
+		Audio_Process(wrbuf, rdbuf, inframes);
 
-		while((long)(outframes = snd_pcm_writei(playback_handle, rdbuf, inframes)) < 0)
+		while((long)(outframes = snd_pcm_writei(playback_handle, wrbuf, inframes)) < 0)
 		{
 			if (outframes == -EAGAIN)
 				continue;
 			
-			if((err = snd_pcm_recover(playback_handle, (int)outframes, 1)))
+			if((err = playback_recover((int)outframes)))
 				fprintf(stderr, "Output recover failed: %s\n",
 					snd_strerror(err));
 		}
@@ -244,13 +276,14 @@ int main(int argc, char **argv)
 	extern char *optarg;
 	int opt;
 	struct sigaction sigIntHandler;
-	int i, verbose = 0, proc = 0;
-	float amp = 0.6F, freq = 1000.0F;
-	int iret;
+	int i, proc = 0;
+	float amp = 0.6F, freq = 1000.0F, freq_end = 10000.0F, sweep = 10.0F;
+	int wave = 0, voices = 8;
+	int iret, cap_chls;
     uint64_t samples;
     
 	/* parse options */
-	while((opt = getopt(argc, argv, "a:b:i:o:p:r:t:vVh")) != EOF)
+	while((opt = getopt(argc, argv, "a:b:C:d:f:F:i:n:N:o:p:r:s:t:w:vVh")) != EOF)
 	{
 		switch(opt)
 		{
@@ -264,11 +297,41 @@ int main(int argc, char **argv)
 				buffer_size = atoi(optarg);
 				break;
 
+			case 'C':
+				/* analyser results */
+				csv_file = optarg;
+				break;
+
+			case 'd':
+				/* delay file */
+				dly_file = optarg;
+				break;
+
+			case 'f':
+				/* frequency */
+				freq = atof(optarg);
+				break;
+
+			case 'F':
+				/* end frequency for multitone / sweep */
+				freq_end = atof(optarg);
+				break;
+
 			case 'i':
 				/* input device */
 				snd_device_in = optarg;
 				break;
 
+			case 'n':
+				/* multitone voices */
+				voices = atoi(optarg);
+				break;
+
+			case 'N':
+				/* channels */
+				nchannels = atoi(optarg);
+				break;
+
 			case 'o':
 				/* output device */
 				snd_device_out = optarg;
@@ -294,11 +357,21 @@ int main(int argc, char **argv)
 				}
 				break;
             
+			case 's':
+				/* sweep time */
+				sweep = atof(optarg);
+				break;
+
             case 't':
                 /* time delay */
 				dlytime = atoi(optarg);
                 break;
 				
+			case 'w':
+				/* waveform */
+				wave = atoi(optarg);
+				break;
+				
 			case 'v':
 				verbose = 1;
 				break;
@@ -313,37 +386,40 @@ int main(int argc, char **argv)
 				fprintf(stderr, "Version %s, %s %s\n", swVersionStr, bdate, btime);
 				fprintf(stderr, "Options: -a <amplitude  >    Default: %f\n", amp);
 				fprintf(stderr, "         -b <Buffer Size>    Default: %d\n", buffer_size);
+				fprintf(stderr, "         -C <csv file>       Default: stdout (analyser results)\n");
+				fprintf(stderr, "         -d <delay file>     Default: none (delay in RAM)\n");
 				fprintf(stderr, "         -f <freq>           Default: %f\n", freq);
+				fprintf(stderr, "         -F <end freq>       Default: %f\n", freq_end);
 				fprintf(stderr, "         -i <input device>   Default: %s\n", snd_device_in);
+				fprintf(stderr, "         -n <voices>         Default: %d\n", voices);
+				fprintf(stderr, "         -N <channels>       Default: %d\n", nchannels);
 				fprintf(stderr, "         -o <output device>  Default: %s\n", snd_device_out);
 				fprintf(stderr, "         -p <process type  > Default: %d\n", proc);
 				fprintf(stderr, "         -r <sample rate Hz> Default: %d\n", sample_rate);
+				fprintf(stderr, "         -s <sweep secs>     Default: %f\n", sweep);
 				fprintf(stderr, "         -t <time secs>      Default: %d\n", dlytime);
+				fprintf(stderr, "         -w <waveform>       Default: %d\n", wave);
 				fprintf(stderr, "         -v enables verbose progress messages\n");
 				fprintf(stderr, "         -V prints the tool version\n");
 				fprintf(stderr, "         -h prints this help\n");
+				fprintf(stderr, "Process types: 0=tone 1=saw 2=delay 3=loopback 4=multitone 5=sweep 6=analyser\n");
+				fprintf(stderr, "Waveforms: 0=sine 1=saw 2=band-limited saw 3=band-limited square\n");
 				exit(1);
 		}
 	}
 	
-	/* set up audio processing */
-    samples  = sample_rate * dlytime;
-    if(samples > ((uint64_t)1<<32))
-    {
-		fprintf(stderr, "Requested time exceeds max\n");
-        exit(1);
-    }
-	if(Audio_Init(samples, proc, amp, freq))
-    {
-		fprintf(stderr, "Audio Init failed\n");
-        exit(1);
-    }
-	else
+	/* the oscillator bank takes a uint8_t count and log spaces from freq */
+	if(voices < 1 || voices > OSC_MAX_VOICES)
 	{
-		if(verbose)
-			fprintf(stderr, "%lld sample buffer allocated\n", samples);
+		fprintf(stderr, "Voices must be 1 to %d\n", OSC_MAX_VOICES);
+		exit(1);
 	}
-    
+	if(!(freq > 0.0F) || !(freq_end > 0.0F))
+	{
+		fprintf(stderr, "Frequencies must be above 0\n");
+		exit(1);
+	}
+	
 	/* set up for control c */
 	sigIntHandler.sa_handler = handle_signals;
 	sigemptyset(&sigIntHandler.sa_mask);
@@ -365,8 +441,48 @@ int main(int argc, char **argv)
 	}
 
 	/* set up both devices identically */
-	configure_alsa_audio(capture_handle,  nchannels);
-	configure_alsa_audio(playback_handle, nchannels);
+	if(configure_alsa_audio(capture_handle,  nchannels))
+		exit(1);
+	cap_chls = nchannels;
+	if(configure_alsa_audio(playback_handle, nchannels))
+		exit(1);
+	
+	/* processing runs on whole frames, so both ends need the same count */
+	if(nchannels != cap_chls)
+	{
+		fprintf(stderr, "Capture has %d channels but playback %d\n",
+			cap_chls, nchannels);
+		snd_pcm_close(playback_handle);
+		snd_pcm_close(capture_handle);
+		exit(1);
+	}
+	
+	/* set up audio processing once rate & channels are settled */
+	if(dlytime < 1)
+	{
+		fprintf(stderr, "Delay time must be at least 1 sec\n");
+		exit(1);
+	}
+    samples  = (uint64_t)sample_rate * dlytime;
+    if(samples >= ((uint64_t)1<<32))
+    {
+		fprintf(stderr, "Requested time exceeds max\n");
+        exit(1);
+    }
+	if(Audio_Init(samples, nchannels, proc, amp, freq, dly_file, wave, voices,
+		freq_end, sweep, csv_file))
+    {
+		fprintf(stderr, "Audio Init failed\n");
+		snd_pcm_close(playback_handle);
+		snd_pcm_close(capture_handle);
+        exit(1);
+    }
+	else
+	{
+		if(verbose)
+			fprintf(stderr, "%lld sample buffer allocated, %d channels\n",
+				samples, nchannels);
+	}
 	
 	/* init the mixer */
 	//mixer_init();
@@ -378,8 +494,10 @@ int main(int argc, char **argv)
 	frames = buffer_size / frame_size;
 	fprintf(stderr, "Frames/buffer = %lu\n", frames);
 	
-	/* allocate the audio buffer */
-	rdbuf = (char *)malloc(buffer_size);
+	/* allocate the audio buffers - separate so processing can copy in one pass */
+	rdbuf = (char *)calloc(buffer_size, 1);
+	wrbuf = (char *)calloc(buffer_size, 1);
+	zbuf = (char *)calloc(buffer_size, 1);
 		
 	/* prepare for use */
 	snd_pcm_prepare(capture_handle);
@@ -387,7 +505,7 @@ int main(int argc, char **argv)
 
 	/* fill the whole output buffer */
 	for(i = 0; i < fragments; i += 1)
-		snd_pcm_writei(playback_handle, rdbuf, frames);
+		snd_pcm_writei(playback_handle, zbuf, frames);
 	
 	/* start audio thread */
 	fprintf(stderr, "main: starting audio thread...\n");
@@ -400,6 +518,10 @@ int main(int argc, char **argv)
 			/* wait a bit */
 			usleep(100000);
 			
+			/* measurements end on their own */
+			if(Audio_Poll())
+				exit_program = 1;
+			
             /* print some status */
             if(verbose)
                 Audio_Status();
@@ -417,6 +539,8 @@ int main(int argc, char **argv)
 	snd_pcm_drain(playback_handle);
 	snd_pcm_drop(capture_handle);
 	free(rdbuf);
+	free(wrbuf);
+	free(zbuf);
 	//snd_mixer_close(mixer_handle);
 	snd_pcm_close(playback_handle);
 	snd_pcm_close(capture_handle);
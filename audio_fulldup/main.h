@@ -12,6 +12,8 @@
 extern int sample_rate;
 extern int exit_program;
 extern int verbose;
+extern int buffer_size;
+extern unsigned int fragments;
 void mixer_set(long vol);
 
 #endif
\ No newline at end of file
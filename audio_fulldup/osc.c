@@ -0,0 +1,308 @@
+/*
+ * osc.c - multi-voice NCO oscillator bank for test signals
+ * 10-19-26 E. Brombaugh
+ *
+ * Each voice is a 32-bit phase accumulator. Waveforms are computed a block
+ * at a time with one voice per pass over the block - the sample index is
+ * the lane, so every inner loop is branch-free arithmetic on independent
+ * phases (ph + i*frq) that the compiler can map onto vector lanes. The
+ * block loop for each mode is picked once at init.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "osc.h"
+
+/* frames rendered per pass */
+#define OSC_BLK 32
+
+/* lowest phase step - the band-limited waves divide by frq>>8 */
+#define OSC_MIN_FRQ 256
+
+/* phase to float scaling - unsigned uses the top 24 bits so it stays < 1 */
+#define OSC_SCL (1.0F/2147483648.0F)
+#define OSC_USCL (1.0F/16777216.0F)
+
+/* sin(pi*a) series coefficients, good to ~1e-7 for |a| <= 0.5 */
+#define OSC_S1 3.14159265F
+#define OSC_S3 -5.16771278F
+#define OSC_S5 2.55016404F
+#define OSC_S7 -0.59926453F
+#define OSC_S9 0.08214589F
+#define OSC_S11 -0.00737043F
+
+typedef void (*osc_wavefn)(float *acc, uint32_t phs, uint32_t frq, float gain, int n);
+
+static uint8_t osc_voices;
+static uint32_t osc_phs[OSC_MAX_VOICES], osc_frq[OSC_MAX_VOICES];
+static float osc_gain[OSC_MAX_VOICES];
+static float osc_amp;
+static int osc_chls;
+static osc_wavefn osc_wave;
+static void (*osc_mode)(int16_t *dst, int inframes);
+
+/* sweep state */
+static double osc_swp_frq, osc_swp_start, osc_swp_step, osc_swp_blk;
+static uint32_t osc_swp_len, osc_swp_pos;
+
+/*
+ * sine - folded to a quarter wave and evaluated by polynomial, no LUT
+ */
+static void osc_wave_sine(float *acc, uint32_t phs, uint32_t frq, float gain, int n)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		float x = (float)(int32_t)(phs + i*frq) * OSC_SCL;
+		float a = 0.5F - fabsf(fabsf(x) - 0.5F);
+		float a2 = a*a;
+		float s = OSC_S11;
+		s = s*a2 + OSC_S9;
+		s = s*a2 + OSC_S7;
+		s = s*a2 + OSC_S5;
+		s = s*a2 + OSC_S3;
+		s = s*a2 + OSC_S1;
+		acc[i] += copysignf(s*a, x) * gain;
+	}
+}
+
+/*
+ * naive sawtooth - same shape as the original generator
+ */
+static void osc_wave_saw(float *acc, uint32_t phs, uint32_t frq, float gain, int n)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+		acc[i] += (float)(int32_t)(phs + i*frq) * OSC_SCL * gain;
+}
+
+/*
+ * clamp negative to zero without a compare
+ */
+static inline float osc_pos(float x)
+{
+	return 0.5F * (x + fabsf(x));
+}
+
+/*
+ * PolyBLEP correction for a unit step at t=0, t in [0,1) - no compares so
+ * the callers vectorize
+ */
+static inline float osc_blep(float t, float idt)
+{
+	float c0 = osc_pos(1.0F - t*idt);
+	float c1 = osc_pos(1.0F + (t - 1.0F)*idt);
+	return c1*c1 - c0*c0;
+}
+
+/*
+ * band-limited sawtooth
+ */
+static void osc_wave_blsaw(float *acc, uint32_t phs, uint32_t frq, float gain, int n)
+{
+	float idt = 1.0F / ((float)(int32_t)(frq>>8) * OSC_USCL);
+	int i;
+
+	/* offset by half so the wrap of the saw is at t = 0 */
+	phs += 0x80000000;
+	for(i=0;i<n;i++)
+	{
+		float t = (float)(int32_t)((phs + i*frq)>>8) * OSC_USCL;
+		acc[i] += (2.0F*t - 1.0F - osc_blep(t, idt)) * gain;
+	}
+}
+
+/*
+ * band-limited square
+ */
+static void osc_wave_blsqr(float *acc, uint32_t phs, uint32_t frq, float gain, int n)
+{
+	float idt = 1.0F / ((float)(int32_t)(frq>>8) * OSC_USCL);
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		uint32_t p = phs + i*frq;
+		float t = (float)(int32_t)(p>>8) * OSC_USCL;
+		float th = (float)(int32_t)((p + 0x80000000)>>8) * OSC_USCL;
+		float sq = 1.0F - 2.0F * (float)(int32_t)(p>>31);
+		acc[i] += (sq + osc_blep(t, idt) - osc_blep(th, idt)) * gain;
+	}
+}
+
+/* waveform table */
+static const osc_wavefn osc_wavefns[OSC_NUM_WAVES] =
+{
+	osc_wave_sine,
+	osc_wave_saw,
+	osc_wave_blsaw,
+	osc_wave_blsqr,
+};
+
+/*
+ * sum all voices for one block
+ */
+static void osc_sum_voices(float *acc, int n)
+{
+	uint8_t v;
+
+	memset(acc, 0, n*sizeof(float));
+	for(v=0;v<osc_voices;v++)
+	{
+		osc_wave(acc, osc_phs[v], osc_frq[v], osc_gain[v], n);
+		osc_phs[v] += n*osc_frq[v];
+	}
+}
+
+/*
+ * block to interleaved output - odd channels are inverted. Always inlined
+ * so the channel count is a constant in each case of osc_output().
+ */
+static inline __attribute__((always_inline)) void osc_output_n(int16_t *dst,
+	float *acc, int n, const int chls)
+{
+	int i, c;
+	int16_t s;
+
+	for(i=0;i<n;i++)
+	{
+		s = (int16_t)fmaxf(fminf(acc[i] * osc_amp, 32767.0F), -32767.0F);
+		for(c=0;c<chls;c++)
+			dst[chls*i+c] = (c & 1) ? -s : s;
+	}
+}
+
+static void osc_output(int16_t *dst, float *acc, int n)
+{
+	switch(osc_chls)
+	{
+		case 1: osc_output_n(dst, acc, n, 1); break;
+		case 2: osc_output_n(dst, acc, n, 2); break;
+		case 4: osc_output_n(dst, acc, n, 4); break;
+		case 8: osc_output_n(dst, acc, n, 8); break;
+		default: osc_output_n(dst, acc, n, osc_chls); break;
+	}
+}
+
+/*
+ * fixed-frequency bank - single tone or multitone
+ */
+static void osc_mode_bank(int16_t *dst, int inframes)
+{
+	float acc[OSC_BLK];
+	int n;
+
+	while(inframes)
+	{
+		n = inframes > OSC_BLK ? OSC_BLK : inframes;
+		osc_sum_voices(acc, n);
+		osc_output(dst, acc, n);
+		dst += osc_chls*n;
+		inframes -= n;
+	}
+}
+
+/*
+ * log sweep - frequency stepped once per block, phase stays continuous
+ */
+static void osc_mode_sweep(int16_t *dst, int inframes)
+{
+	float acc[OSC_BLK];
+	int n;
+
+	while(inframes)
+	{
+		n = inframes > OSC_BLK ? OSC_BLK : inframes;
+		osc_frq[0] = (uint32_t)osc_swp_frq;
+		osc_sum_voices(acc, n);
+		osc_output(dst, acc, n);
+		dst += osc_chls*n;
+		inframes -= n;
+
+		/* advance the sweep and restart at the end */
+		osc_swp_pos += n;
+		if(osc_swp_pos >= osc_swp_len)
+		{
+			osc_swp_pos = 0;
+			osc_swp_frq = osc_swp_start;
+		}
+		else
+			osc_swp_frq *= (n == OSC_BLK) ? osc_swp_blk : exp(osc_swp_step*n);
+	}
+}
+
+/*
+ * set up the bank
+ */
+int32_t osc_init(uint8_t mode, uint8_t wave, uint8_t voices, float amp,
+	float freq, float freq_end, float sweep_secs, int chls, int rate)
+{
+	double scl = 4294967296.0 / (double)rate, f;
+	uint8_t v;
+
+	if(wave >= OSC_NUM_WAVES)
+	{
+		fprintf(stderr, "osc_init: illegal waveform %d\n", wave);
+		return 1;
+	}
+	osc_wave = osc_wavefns[wave];
+
+	/* output scaling */
+	osc_amp = amp * 32767.0F;
+	osc_chls = chls;
+
+	if(mode == OSC_SWEEP)
+	{
+		if(freq * scl < OSC_MIN_FRQ || freq_end * scl < OSC_MIN_FRQ || sweep_secs <= 0.0F)
+		{
+			fprintf(stderr, "osc_init: illegal sweep\n");
+			return 1;
+		}
+
+		/* one voice, per-sample log step of the frequency */
+		osc_voices = 1;
+		osc_phs[0] = 0;
+		osc_gain[0] = 1.0F;
+		osc_swp_len = sweep_secs * rate;
+		osc_swp_start = osc_swp_frq = freq * scl;
+		osc_swp_step = log(freq_end / freq) / (double)osc_swp_len;
+		osc_swp_blk = exp(osc_swp_step * OSC_BLK);
+		osc_swp_pos = 0;
+		osc_mode = osc_mode_sweep;
+	}
+	else
+	{
+		if(freq * scl < OSC_MIN_FRQ || freq_end * scl < OSC_MIN_FRQ)
+		{
+			fprintf(stderr, "osc_init: illegal frequency\n");
+			return 1;
+		}
+		voices = voices < 1 ? 1 : voices;
+		voices = voices > OSC_MAX_VOICES ? OSC_MAX_VOICES : voices;
+		osc_voices = voices;
+
+		/* log spaced from freq to freq_end w/ Schroeder phases for low crest */
+		for(v=0;v<voices;v++)
+		{
+			f = voices > 1 ? freq * pow(freq_end / freq, (double)v/(voices-1)) : freq;
+			osc_frq[v] = (uint32_t)floor(f * scl);
+			osc_phs[v] = (uint32_t)(int64_t)floor(-0.5 * v * (v - 1) / voices * 4294967296.0);
+			osc_gain[v] = 1.0F / voices;
+		}
+		osc_mode = osc_mode_bank;
+	}
+
+	return 0;
+}
+
+/*
+ * render a block of frames, interleaved with the channel count given to
+ * osc_init
+ */
+void osc_render(int16_t *dst, int inframes)
+{
+	osc_mode(dst, inframes);
+}
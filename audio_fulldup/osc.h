@@ -0,0 +1,32 @@
+/*
+ * osc.h - multi-voice NCO oscillator bank for test signals
+ * 10-19-26 E. Brombaugh
+ */
+
+#ifndef __osc__
+#define __osc__
+
+#include <stdint.h>
+
+#define OSC_MAX_VOICES 32
+
+enum osc_waves
+{
+	OSC_SINE,
+	OSC_SAW,
+	OSC_BLSAW,
+	OSC_BLSQR,
+	OSC_NUM_WAVES
+};
+
+enum osc_modes
+{
+	OSC_BANK,
+	OSC_SWEEP,
+};
+
+int32_t osc_init(uint8_t mode, uint8_t wave, uint8_t voices, float amp,
+	float freq, float freq_end, float sweep_secs, int chls, int rate);
+void osc_render(int16_t *dst, int inframes);
+
+#endif
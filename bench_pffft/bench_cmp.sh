@@ -0,0 +1,23 @@
+#!/bin/sh
+# bench_cmp.sh - compare two bench_pffft.sh tables
+# usage: bench_cmp.sh old.csv new.csv [percent]
+# prints the cases that got slower by more than percent (5 by default) and
+# exits with 1 if there are any
+if [ $# -lt 2 ]; then
+	echo "usage: $0 old.csv new.csv [percent]"
+	exit 2
+fi
+awk -F, -v pct=${3:-5} '
+	FNR == 1 { next }
+	{ key = $1 "," $2 "," $4 "," $5 "," $6 "," $7 }
+	NR == FNR { old[key] = $8; next }
+	(key in old) && old[key] > 0 {
+		d = 100 * ($8 - old[key]) / old[key]
+		if(d > pct)
+		{
+			printf "%-50s %12.1f -> %12.1f ns  %+6.1f%%\n", key, old[key], $8, d
+			slow++
+		}
+	}
+	END { exit slow > 0 }
+' "$1" "$2"
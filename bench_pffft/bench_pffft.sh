@@ -0,0 +1,20 @@
+#!/bin/sh
+# bench_pffft.sh - run the FFT benchmark suite on the target
+# build the binaries with 'make' and 'make widths', copy them and this script
+# over and run it. One CSV table goes to stdout with a row per
+# implementation, type, size, direction and order - keep it to compare
+# against the next release with bench_cmp.sh. Arguments go on to each
+# binary, e.g. -n 64:4096 for a shorter sweep.
+first=1
+for b in bench_pffft bench_pffft_0 bench_pffft_4 bench_pffft_8 bench_pffft_16 \
+	bench_pffft_r8 bench_pffft_r16 bench_pffft_r64; do
+	if [ -x ./$b ]; then
+		if [ $first = 1 ]; then
+			# the native build also times fftpack and prints the header
+			./$b "$@"
+			first=0
+		else
+			./$b -s pffft -H "$@"
+		fi
+	fi
+done
@@ -0,0 +1,487 @@
+/*
+ * main.c - top level of bench_pffft, the FFT benchmark suite
+ * 10-19-26 E. Brombaugh
+ * 10-19-26 E. Brombaugh - name the PFFFT_TWIDDLE_RECUR builds
+ *
+ * Sweeps every size 2^a * 3^b * 5^c in a range through pffft (all four
+ * combinations of forward / backward and ordered / unordered, real and
+ * complex) and fftpack, and prints one row per case as CSV, JSON lines or
+ * text. Which pffft it times is fixed at build time, the Makefile builds one
+ * binary per vector width and bench_pffft.sh merges their tables.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <linux/perf_event.h>
+#include "pffft.h"
+#include "fftpack.h"
+
+#define MAX_SIZES 512
+
+typedef enum
+{
+	FMT_CSV,
+	FMT_JSON,
+	FMT_TEXT,
+} fmt_t;
+
+/* one timed case */
+typedef struct
+{
+	const char *impl;
+	int simd;
+	pffft_transform_t type;
+	int n;
+	pffft_direction_t dir;
+	int ordered;
+	double ns;				// median time per transform
+	size_t setup_bytes;
+	double misses;			// cache misses per transform, < 0 if unknown
+} bench_row;
+
+static fmt_t fmt = FMT_CSV;
+static int reps = 5, min_us = 2000, rows;
+static char arch[65];
+static int perf_fd = -1;
+
+/*
+ * nanoseconds now
+ */
+static double get_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1e9 * ts.tv_sec + ts.tv_nsec;
+}
+
+/*
+ * cache miss counter, left closed when perf isn't available
+ */
+static void perf_init(void)
+{
+	struct perf_event_attr pe;
+
+	memset(&pe, 0, sizeof(pe));
+	pe.type = PERF_TYPE_HARDWARE;
+	pe.size = sizeof(pe);
+	pe.config = PERF_COUNT_HW_CACHE_MISSES;
+	pe.disabled = 1;
+	pe.exclude_kernel = 1;
+	pe.exclude_hv = 1;
+	perf_fd = syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+static void perf_start(void)
+{
+	if(perf_fd < 0)
+		return;
+	ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+	ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static double perf_stop(void)
+{
+	uint64_t cnt;
+
+	if(perf_fd < 0)
+		return -1;
+	ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+	if(read(perf_fd, &cnt, sizeof(cnt)) != sizeof(cnt))
+		return -1;
+	return cnt;
+}
+
+/*
+ * what gets timed - one call is one transform
+ */
+typedef struct
+{
+	PFFFT_Setup *s;
+	float *wsave;
+	const float *in;
+	float *out, *work;
+	pffft_transform_t type;
+	pffft_direction_t dir;
+	int n, ordered;
+} bench_case;
+
+static void run_pffft(bench_case *c, int iters)
+{
+	while(iters--)
+	{
+		if(c->ordered)
+			pffft_transform_ordered(c->s, c->in, c->out, c->work, c->dir);
+		else
+			pffft_transform(c->s, c->in, c->out, c->work, c->dir);
+	}
+}
+
+/*
+ * fftpack works in place, so each pass starts from a fresh copy of the
+ * input to keep the values from growing - the copy is timed on its own
+ * and taken off
+ */
+static void run_fftpack(bench_case *c, int iters)
+{
+	size_t sz = (c->type == PFFFT_COMPLEX ? 2 : 1) * c->n * sizeof(float);
+
+	while(iters--)
+	{
+		memcpy(c->out, c->in, sz);
+		if(c->type == PFFFT_COMPLEX)
+		{
+			if(c->dir == PFFFT_FORWARD)
+				cfftf(c->n, c->out, c->wsave);
+			else
+				cfftb(c->n, c->out, c->wsave);
+		}
+		else
+		{
+			if(c->dir == PFFFT_FORWARD)
+				rfftf(c->n, c->out, c->wsave);
+			else
+				rfftb(c->n, c->out, c->wsave);
+		}
+	}
+}
+
+static void run_copy(bench_case *c, int iters)
+{
+	size_t sz = (c->type == PFFFT_COMPLEX ? 2 : 1) * c->n * sizeof(float);
+
+	while(iters--)
+	{
+		memcpy(c->out, c->in, sz);
+		__asm__ volatile ("" : : "r"(c->out) : "memory");
+	}
+}
+
+static int cmp_dbl(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+ * median ns per call over reps samples, each long enough to read the
+ * clock well. The cache misses are over all the samples.
+ */
+static double time_case(void (*fn)(bench_case *, int), bench_case *c, double *misses)
+{
+	double t, samp[32], m;
+	int iters = 1, i;
+
+	/* warm up and find the iterations per sample */
+	for(;;)
+	{
+		t = get_ns();
+		fn(c, iters);
+		t = get_ns() - t;
+		if(t >= min_us * 1e3 || iters >= (1 << 24))
+			break;
+		iters *= 2;
+	}
+
+	perf_start();
+	for(i=0;i<reps;i++)
+	{
+		t = get_ns();
+		fn(c, iters);
+		samp[i] = (get_ns() - t) / iters;
+	}
+	m = perf_stop();
+	if(misses)
+		*misses = m < 0 ? -1 : m / ((double)iters * reps);
+
+	qsort(samp, reps, sizeof(double), cmp_dbl);
+	return samp[reps/2];
+}
+
+/*
+ * standard FFT flop count, half of it for a real transform
+ */
+static double mflops(const bench_row *r)
+{
+	double f = 5.0 * r->n * log2(r->n);
+
+	if(r->type == PFFFT_REAL)
+		f *= 0.5;
+	return f / r->ns * 1e3;
+}
+
+static void print_row(const bench_row *r, int header)
+{
+	const char *type = r->type == PFFFT_COMPLEX ? "complex" : "real";
+	const char *dir = r->dir == PFFFT_FORWARD ? "fwd" : "bwd";
+	const char *order = r->ordered ? "ordered" : "unordered";
+	char miss[32];
+
+	switch(fmt)
+	{
+		case FMT_CSV:
+			if(r->misses < 0)
+				miss[0] = 0;
+			else
+				snprintf(miss, sizeof(miss), "%.1f", r->misses);
+			if(header)
+				printf("arch,impl,simd,type,n,dir,order,ns,mflops,setup_bytes,cache_misses\n");
+			printf("%s,%s,%d,%s,%d,%s,%s,%.1f,%.1f,%zu,%s\n", arch, r->impl, r->simd,
+				type, r->n, dir, order, r->ns, mflops(r), r->setup_bytes, miss);
+			break;
+
+		case FMT_JSON:
+			if(r->misses < 0)
+				strcpy(miss, "null");
+			else
+				snprintf(miss, sizeof(miss), "%.1f", r->misses);
+			printf("{\"arch\":\"%s\",\"impl\":\"%s\",\"simd\":%d,\"type\":\"%s\",\"n\":%d,"
+				"\"dir\":\"%s\",\"order\":\"%s\",\"ns\":%.1f,\"mflops\":%.1f,"
+				"\"setup_bytes\":%zu,\"cache_misses\":%s}\n",
+				arch, r->impl, r->simd, type, r->n, dir, order, r->ns, mflops(r),
+				r->setup_bytes, miss);
+			break;
+
+		case FMT_TEXT:
+			if(r->misses < 0)
+				strcpy(miss, "-");
+			else
+				snprintf(miss, sizeof(miss), "%.1f", r->misses);
+			if(header)
+				printf("%-20s %-7s %6s %-3s %-9s %12s %8s %8s %10s\n", "impl", "type", "n",
+					"dir", "order", "ns", "MFLOPS", "setup", "misses");
+			printf("%-20s %-7s %6d %-3s %-9s %12.1f %8.1f %8zu %10s\n", r->impl, type, r->n,
+				dir, order, r->ns, mflops(r), r->setup_bytes, miss);
+			break;
+	}
+	fflush(stdout);
+}
+
+static void emit(bench_row *r, int no_header)
+{
+	print_row(r, !no_header && rows == 0);
+	rows++;
+}
+
+/*
+ * all 2^a * 3^b * 5^c from min to max, in order
+ */
+static int make_sizes(int *sz, int min, int max)
+{
+	long p2, p3, p5;
+	int cnt = 0;
+
+	for(p5=1;p5<=max;p5*=5)
+		for(p3=p5;p3<=max;p3*=3)
+			for(p2=p3;p2<=max;p2*=2)
+				if(p2 >= min && cnt < MAX_SIZES)
+					sz[cnt++] = p2;
+	qsort(sz, cnt, sizeof(int), cmp_int);
+	return cnt;
+}
+
+static const char *pffft_impl(void)
+{
+	static char name[32];
+	int l;
+
+#if defined(PFFFT_SIMD_DISABLE)
+	l = snprintf(name, sizeof(name), "pffft-scalar");
+#elif defined(PFFFT_SIMD_VECEXT)
+	l = snprintf(name, sizeof(name), "pffft-vecext%d", pffft_simd_size());
+#else
+	l = snprintf(name, sizeof(name), "pffft-simd%d", pffft_simd_size());
+#endif
+#if defined(PFFFT_TWIDDLE_RECUR) && !defined(PFFFT_SIMD_DISABLE)
+	snprintf(name + l, sizeof(name) - l, "-recur%d", PFFFT_TWIDDLE_RECUR);
+#else
+	(void)l;
+#endif
+	return name;
+}
+
+/*
+ * every direction and order of one pffft size and type
+ */
+static void bench_pffft(pffft_transform_t type, int n, float *in, float *out, float *work, int no_header)
+{
+	bench_case c;
+	bench_row r;
+	int d, o;
+
+	if(n % pffft_min_fft_size(type))
+		return;
+	if(!(c.s = pffft_new_setup(n, type)))
+		return;
+	c.in = in;
+	c.out = out;
+	c.work = work;
+	c.type = type;
+	c.n = n;
+
+	r.impl = pffft_impl();
+	r.simd = pffft_simd_size();
+	r.type = type;
+	r.n = n;
+	r.setup_bytes = pffft_setup_bytes(n, type);
+	for(o=1;o>=0;o--)
+		for(d=0;d<2;d++)
+		{
+			c.dir = r.dir = d ? PFFFT_BACKWARD : PFFFT_FORWARD;
+			c.ordered = r.ordered = o;
+			r.ns = time_case(run_pffft, &c, &r.misses);
+			emit(&r, no_header);
+		}
+	pffft_destroy_setup(c.s);
+}
+
+/*
+ * fftpack in both directions - its output is in natural order
+ */
+static void bench_fftpack(pffft_transform_t type, int n, float *in, float *out, float *wsave, int no_header)
+{
+	bench_case c;
+	bench_row r;
+	double copy, cmiss;
+	int d;
+
+	if(type == PFFFT_COMPLEX)
+		cffti(n, wsave);
+	else
+		rffti(n, wsave);
+	c.wsave = wsave;
+	c.in = in;
+	c.out = out;
+	c.type = type;
+	c.n = n;
+	copy = time_case(run_copy, &c, &cmiss);
+
+	r.impl = "fftpack";
+	r.simd = 1;
+	r.type = type;
+	r.n = n;
+	r.ordered = 1;
+	r.setup_bytes = ((type == PFFFT_COMPLEX ? 4 : 2) * n + 15) * sizeof(float);
+	for(d=0;d<2;d++)
+	{
+		c.dir = r.dir = d ? PFFFT_BACKWARD : PFFFT_FORWARD;
+		r.ns = time_case(run_fftpack, &c, &r.misses) - copy;
+		if(r.misses >= 0 && cmiss >= 0)
+			r.misses = r.misses > cmiss ? r.misses - cmiss : 0;
+		emit(&r, no_header);
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-n min:max] [-t c|r] [-s pffft|fftpack|all] [-r reps] [-u us]\n"
+		"          [-f csv|json|text] [-H]\n"
+		"  -n  range of sizes, every 2^a*3^b*5^c in it (16:16384)\n"
+		"  -t  complex or real only (both)\n"
+		"  -s  which FFTs to time (all)\n"
+		"  -r  samples per case, the median is reported (5)\n"
+		"  -u  minimum microseconds per sample (2000)\n"
+		"  -f  output format (csv)\n"
+		"  -H  no header line, for appending to a table\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	int sizes[MAX_SIZES], nsz, nmin = 16, nmax = 16384, no_header = 0;
+	int do_pffft = 1, do_fftpack = 1, types = 3, opt, i, t;
+	struct utsname un;
+	float *in, *out, *work, *wsave;
+
+	while((opt = getopt(argc, argv, "n:t:s:r:u:f:Hh")) != -1)
+	{
+		switch(opt)
+		{
+			case 'n':
+				if(sscanf(optarg, "%d:%d", &nmin, &nmax) != 2)
+					nmax = nmin;
+				break;
+			case 't':
+				types = optarg[0] == 'c' ? 1 : optarg[0] == 'r' ? 2 : 3;
+				break;
+			case 's':
+				do_pffft = strcmp(optarg, "fftpack") != 0;
+				do_fftpack = strcmp(optarg, "pffft") != 0;
+				break;
+			case 'r':
+				reps = atoi(optarg);
+				break;
+			case 'u':
+				min_us = atoi(optarg);
+				break;
+			case 'f':
+				fmt = !strcmp(optarg, "json") ? FMT_JSON : !strcmp(optarg, "text") ? FMT_TEXT : FMT_CSV;
+				break;
+			case 'H':
+				no_header = 1;
+				break;
+			default:
+				usage(argv[0]);
+				exit(opt == 'h' ? 0 : 1);
+		}
+	}
+	if(reps < 1 || reps > 32 || nmin < 2 || nmax < nmin)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	strcpy(arch, "unknown");
+	if(!uname(&un))
+		snprintf(arch, sizeof(arch), "%s", un.machine);
+	perf_init();
+	if(perf_fd < 0)
+		fprintf(stderr, "perf not available, no cache misses\n");
+
+	nsz = make_sizes(sizes, nmin, nmax);
+	in = pffft_aligned_malloc(2 * nmax * sizeof(float));
+	out = pffft_aligned_malloc(2 * nmax * sizeof(float));
+	work = pffft_aligned_malloc(2 * nmax * sizeof(float));
+	wsave = malloc((4 * nmax + 25) * sizeof(float));
+	if(!in || !out || !work || !wsave)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	srand(1);
+	for(i=0;i<2*nmax;i++)
+		in[i] = (float)rand() / RAND_MAX - 0.5f;
+
+	for(t=0;t<2;t++)
+	{
+		pffft_transform_t type = t ? PFFFT_REAL : PFFFT_COMPLEX;
+
+		if(!(types & (1 << t)))
+			continue;
+		for(i=0;i<nsz;i++)
+		{
+			if(do_pffft)
+				bench_pffft(type, sizes[i], in, out, work, no_header);
+			if(do_fftpack)
+				bench_fftpack(type, sizes[i], in, out, wsave, no_header);
+		}
+	}
+	pffft_aligned_free(in);
+	pffft_aligned_free(out);
+	pffft_aligned_free(work);
+	free(wsave);
+	if(perf_fd >= 0)
+		close(perf_fd);
+	return 0;
+}
@@ -1,6 +1,7 @@
 /*
  * audio.c - audio processing routines for long delay
  * 08-20-20 E. Brombaugh
+ * 10-19-26 E. Brombaugh - feed the spectrum analyser
  */
 
 #include <stdio.h>
@@ -11,9 +12,7 @@
 #include "audio.h"
 #include "dsp_lib.h"
 #include "fx.h"
-
-/* stereo or mono */
-#define CHLS 2
+#include "spectrum.h"
 
 #define FADE_BITS 11
 #define FADE_MAX ((1<<FADE_BITS)-1)
@@ -30,7 +29,8 @@ enum fadestate
     FADE_OUT,
 };
 
-int16_t *prcbuf;
+int16_t *prcbuf, *pairbuf;
+int audio_chls;
 uint32_t fadecnt;
 uint8_t init, fadest;
 int16_t audio_sl[4];
@@ -40,8 +40,17 @@ int16_t prev_wet;
 /*
  * init audio
  */
-int32_t Audio_Init(uint32_t buffer_size)
+int32_t Audio_Init(uint32_t buffer_size, int chls)
 {
+	uint32_t pairsz;
+	
+	if(chls < 1)
+	{
+		fprintf(stderr, "Audio_Init: illegal channel count %d\n", chls);
+		return 1;
+	}
+	audio_chls = chls;
+	
 	/* init fx */
 	if(fx_init())
 	{
@@ -62,10 +71,13 @@ int32_t Audio_Init(uint32_t buffer_size)
 	audio_mute_state = 2;	// start up  muted
 	audio_mute_cnt = 0;
 	
-	/* procesing buffer */
-	if(!(prcbuf = malloc(buffer_size)))
+	/* procesing buffers - the effect always sees a stereo pair */
+	pairsz = buffer_size / chls * 2;
+	if(!(prcbuf = malloc(pairsz)) || !(pairbuf = malloc(pairsz)))
 	{
 		fprintf(stderr, "Audio_Init: couldn't allocate processing buffer\n");
+		free(prcbuf);
+		prcbuf = NULL;
 		fx_deinit();
 		return 1;
 	}
@@ -80,6 +92,8 @@ void Audio_Close(void)
 {
     if(prcbuf)
         free(prcbuf);
+    if(pairbuf)
+        free(pairbuf);
 }
 
 /*
@@ -96,26 +110,58 @@ void level_calc(int16_t sig, int16_t *level)
 }
 
 /*
- * process the audio
+ * advance the soft mute one frame and return its gain, 512 = unity
  */
-void Audio_Process(char *wrbuf, char *rdbuf, int inframes)
+static inline int32_t Audio_Mute_Gain(void)
 {
-	int16_t *src = (int16_t *)rdbuf;
-	int16_t *prc = (int16_t *)prcbuf;
-	int16_t *dst = (int16_t *)wrbuf;
-	uint16_t index;
-	int32_t wet, dry, mix;
-	float live_wet, slope_wet;
+	int32_t gain;
 	
-	/* check input levels */
-	for(index=0;index<inframes;index++)
+	switch(audio_mute_state)
 	{
-		level_calc(*(src+0), &audio_sl[0]);
-		level_calc(*(src+1), &audio_sl[1]);
+		case 0:
+			/* pass thru and wait for foreground to force a transition */
+			return 512;
+		
+		case 1:
+			/* transition to mute state */
+			gain = audio_mute_cnt--;
+			if(audio_mute_cnt == 0)
+				audio_mute_state = 2;
+			return gain;
+			
+		case 2:
+			/* mute and wait for foreground to force a transition */
+			return 0;
+		
+		case 3:
+			/* transition to unmute state */
+			gain = audio_mute_cnt++;
+			if(audio_mute_cnt == 512)
+			{
+				audio_mute_state = 0;
+				audio_mute_cnt = 0;
+			}
+			return gain;
+			
+		default:
+			/* go to legal state */
+			audio_mute_state = 0;
+			return 512;
 	}
-	
-	/* apply the effect */
-	fx_proc(prc, src, inframes);
+}
+
+/*
+ * W/D mixing of the effect pair, muting and level detect for one block.
+ * Always inlined so the channel count is a constant in each caller below.
+ */
+static inline __attribute__((always_inline)) void Audio_Mix(int16_t *dst,
+	int16_t *src, int16_t *prc, int inframes, const int chls)
+{
+	const int r = chls > 1 ? 1 : 0;
+	uint16_t index;
+	int chl;
+	int32_t wet, dry, mix, mgain;
+	float live_wet, slope_wet;
 	
 	/* set W/D mix gain and prep linear interp */
 	wet = adc_buffer[3];
@@ -123,67 +169,101 @@ void Audio_Process(char *wrbuf, char *rdbuf, int inframes)
 	slope_wet = (float)(wet - prev_wet) / (float)inframes;
 	prev_wet = wet;
 
-	/* W/D mixing and output level detect */
 	for(index=0;index<inframes;index++)
 	{
 		/* linear interp W/D mix gain */
 		wet = live_wet;
 		dry = 0xfff - wet;
 		live_wet += slope_wet;
+		mgain = Audio_Mute_Gain();
 		
-		/* W/D with saturation */
-		mix = *prc++ * wet + *src++ * dry;
-		*dst++ = dsp_ssat16(mix>>12);
-		mix = *prc++ * wet + *src++ * dry;
-		*dst++ = dsp_ssat16(mix>>12);
-
-		/* handle muting */
-		switch(audio_mute_state)
+		/* check input levels */
+		level_calc(src[0], &audio_sl[0]);
+		level_calc(src[r], &audio_sl[1]);
+		
+		/* W/D with saturation on the effect pair */
+		mix = prc[0] * wet + src[0] * dry;
+		dst[0] = dsp_ssat16((dsp_ssat16(mix>>12) * mgain)>>9);
+		if(chls > 1)
 		{
-			case 0:
-				/* pass thru and wait for foreground to force a transition */
-				break;
-			
-			case 1:
-				/* transition to mute state */
-				mix = (*(dst-2) * audio_mute_cnt);
-				*(dst-2) = dsp_ssat16(mix>>9);
-				mix = (*(dst-1) * audio_mute_cnt);
-				*(dst-1) = dsp_ssat16(mix>>9);
-				audio_mute_cnt--;
-				if(audio_mute_cnt == 0)
-					audio_mute_state = 2;
-				break;
-				
-			case 2:
-				/* mute and wait for foreground to force a transition */
-				*(dst-2) = 0;
-				*(dst-1) = 0;
-				break;
-			
-			case 3:
-				/* transition to unmute state */
-				mix = (*(dst-2) * audio_mute_cnt);
-				*(dst-2) = dsp_ssat16(mix>>9);
-				mix = (*(dst-1) * audio_mute_cnt);
-				*(dst-1) = dsp_ssat16(mix>>9);
-				audio_mute_cnt++;
-				if(audio_mute_cnt == 512)
-				{
-					audio_mute_state = 0;
-					audio_mute_cnt = 0;
-				}
-				break;
-				
-			default:
-				/* go to legal state */
-				audio_mute_state = 0;
-				break;
+			mix = prc[1] * wet + src[1] * dry;
+			dst[1] = dsp_ssat16((dsp_ssat16(mix>>12) * mgain)>>9);
 		}
+		
+		/* remaining channels pass thru */
+		for(chl=2;chl<chls;chl++)
+			dst[chl] = (src[chl] * mgain)>>9;
 
 		/* check output levels */
-		level_calc(*(dst-2), &audio_sl[2]);
-		level_calc(*(dst-1), &audio_sl[3]);
+		level_calc(dst[0], &audio_sl[2]);
+		level_calc(dst[r], &audio_sl[3]);
+		
+		src += chls;
+		dst += chls;
+		prc += 2;
+	}
+}
+
+/*
+ * gather the effect pair - mono is doubled
+ */
+static void Audio_Get_Pair(int16_t *pair, int16_t *src, int inframes, int chls)
+{
+	int r = chls > 1 ? 1 : 0;
+	
+	while(inframes--)
+	{
+		pair[0] = src[0];
+		pair[1] = src[r];
+		pair += 2;
+		src += chls;
+	}
+}
+
+/*
+ * process the audio - the effect runs on channels 0/1
+ */
+void Audio_Process(char *wrbuf, char *rdbuf, int inframes)
+{
+	int16_t *src = (int16_t *)rdbuf;
+	int16_t *dst = (int16_t *)wrbuf;
+	int16_t *fxin = src;
+	
+	/* hand a copy of the input to the analysis thread */
+	spec_push(src, inframes);
+	
+	/* effects work on an interleaved stereo pair */
+	if(audio_chls != 2)
+	{
+		Audio_Get_Pair(pairbuf, src, inframes, audio_chls);
+		fxin = pairbuf;
+	}
+	
+	/* apply the effect */
+	fx_proc(prcbuf, fxin, inframes);
+	
+	/* common channel counts get their own copy of the mixer */
+	switch(audio_chls)
+	{
+		case 1:
+			Audio_Mix(dst, src, prcbuf, inframes, 1);
+			break;
+		
+		case 2:
+			Audio_Mix(dst, src, prcbuf, inframes, 2);
+			break;
+		
+		case 4:
+			Audio_Mix(dst, src, prcbuf, inframes, 4);
+			break;
+		
+		case 8:
+			Audio_Mix(dst, src, prcbuf, inframes, 8);
+			break;
+		
+		default:
+			Audio_Mix(dst, src, prcbuf, inframes, audio_chls);
+			break;
 	}
 }
 
@@ -8,7 +8,7 @@
 
 #include <stdint.h>
 
-int32_t Audio_Init(uint32_t buffer_size);
+int32_t Audio_Init(uint32_t buffer_size, int chls);
 void Audio_Close(void);
 void Audio_Process(char *wrbuf, char *rdbuf, int inframes);
 int16_t Audio_get_level(uint8_t idx);
@@ -1,6 +1,8 @@
 /*
  * main.c - top level of dspod_app - main UI + audio app for dspod_cv1800b
  * 09-07-25 E. Brombaugh
+ * 10-19-26 E. Brombaugh - spectrum / tuner analysis thread
+ * 10-19-26 E. Brombaugh - fail if in and out differ in channel count
  */
 
 #include <stdio.h>
@@ -21,6 +23,7 @@
 #include "codec_nau88c22.h"
 #include "audio.h"
 #include "menu.h"
+#include "spectrum.h"
 
 /* version */
 const char *swVersionStr = "V0.1";
@@ -57,6 +60,7 @@ float				adc_iir[4];
 volatile int16_t	adc_buffer[4];
 uint8_t				adc_idx;
 int					verbose = 0;
+int					fft_size = 2048;
 uint64_t audio_load[5], audio_load_per, audio_load_rd, audio_load_wd,
 	audio_load_pd;
 uint8_t audio_load_pct;
@@ -120,13 +124,21 @@ int configure_alsa_audio(snd_pcm_t *device, int channels)
 		sample_rate = tmp;
 	}
 	
-	if((err = snd_pcm_hw_params_set_channels(device, hw_params, channels)) < 0)
+	tmp = channels;
+	if((err = snd_pcm_hw_params_set_channels_near(device, hw_params, &tmp)) < 0)
 	{
 		fprintf (stderr, "cannot set channel count: %s\n",
 			snd_strerror(err));
 		return 1;
 	}
 	
+	if(tmp != channels)
+	{
+		fprintf(stderr, "Could not set requested channel count, %d != %d\n",
+			channels, tmp);
+		nchannels = channels = tmp;
+	}
+	
 	if((err = snd_pcm_hw_params_set_periods_near(device, hw_params,
 		&fragments, 0)) < 0)
 	{
@@ -303,9 +315,10 @@ uint8_t get_load(void)
 {	
 	uint8_t load = audio_load_pct;
 	
-	/* write to console status line */
-	fprintf(stdout, "rd: % 6llu wd: % 6llu pd % 6llu per: % 6llu = % 3u%% \r",
-		audio_load_rd, audio_load_wd, audio_load_pd, audio_load_per, load);
+	/* write to console status line - analysis load is separate */
+	fprintf(stdout, "rd: % 6llu wd: % 6llu pd % 6llu per: % 6llu = % 3u%% an: % 3u%% \r",
+		audio_load_rd, audio_load_wd, audio_load_pd, audio_load_per, load,
+		spec_get_load());
 	fflush(stdout);
 	
 	return load;
@@ -321,14 +334,13 @@ int main(int argc, char **argv)
 	int opt;
 	struct sigaction sigIntHandler;
 	int i, codec = 0;
-	int iret;
-    uint64_t samples;
+	int iret, cap_chls;
 	int16_t val = 0;
 	uint8_t btn = 0;
     int errorstat = 1;
 	
 	/* parse options */
-	while((opt = getopt(argc, argv, "a:b:ci:o:p:r:t:vVh")) != EOF)
+	while((opt = getopt(argc, argv, "a:b:cF:i:N:o:p:r:t:vVh")) != EOF)
 	{
 		switch(opt)
 		{
@@ -342,11 +354,21 @@ int main(int argc, char **argv)
 				codec = 1;
 				break;
 
+			case 'F':
+				/* analysis FFT size */
+				fft_size = atoi(optarg);
+				break;
+
 			case 'i':
 				/* input device */
 				snd_device_in = optarg;
 				break;
 
+			case 'N':
+				/* channels */
+				nchannels = atoi(optarg);
+				break;
+
 			case 'o':
 				/* output device */
 				snd_device_out = optarg;
@@ -381,7 +403,9 @@ int main(int argc, char **argv)
 				fprintf(stderr, "Version %s, %s %s\n", swVersionStr, bdate, btime);
 				fprintf(stderr, "Options: -b <Buffer Size>    Default: %d\n", buffer_size);
 				fprintf(stderr, "         -c init codec (default no)\n");
+				fprintf(stderr, "         -F <analysis FFT>   Default: %d\n", fft_size);
 				fprintf(stderr, "         -i <input device>   Default: %s\n", snd_device_in);
+				fprintf(stderr, "         -N <channels>       Default: %d\n", nchannels);
 				fprintf(stderr, "         -o <output device>  Default: %s\n", snd_device_out);
 				fprintf(stderr, "         -r <sample rate Hz> Default: %d\n", sample_rate);
 				fprintf(stderr, "         -v enables verbose progress messages\n");
@@ -440,16 +464,6 @@ int main(int argc, char **argv)
 		printf("Codec initialized\n");
 	}
 	
-	/* set up audio processing */
-	if(Audio_Init(buffer_size))
-    {
-		fprintf(stderr, "Audio Init failed\n");
-		goto err_audio;
-    }
-	
-	if(verbose)
-		fprintf(stderr, "Audio initialized - %lld sample buffer allocated\n", samples);
-    
 	/* open audio devices - output first because input is slaved */
 	if((err = snd_pcm_open(&playback_handle, snd_device_out, SND_PCM_STREAM_PLAYBACK, 0)) < 0)
 	{
@@ -464,8 +478,19 @@ int main(int argc, char **argv)
 	}
 
 	/* set up both devices identically */
-	configure_alsa_audio(capture_handle,  nchannels);
-	configure_alsa_audio(playback_handle, nchannels);
+	if(configure_alsa_audio(capture_handle,  nchannels))
+		goto err_config;
+	cap_chls = nchannels;
+	if(configure_alsa_audio(playback_handle, nchannels))
+		goto err_config;
+	
+	/* processing runs on whole frames, so both ends need the same count */
+	if(nchannels != cap_chls)
+	{
+		fprintf(stderr, "Capture has %d channels but playback %d\n",
+			cap_chls, nchannels);
+		goto err_config;
+	}
 	
 	/* set up sizes */
 	frame_size = nchannels * (bits / 8);
@@ -479,6 +504,23 @@ int main(int argc, char **argv)
 		goto err_rdbuf;
 	if(!(wrbuf = (char *)malloc(buffer_size)))
 		goto err_wrbuf;
+	
+	/* set up audio processing once the channel count is settled */
+	if(Audio_Init(buffer_size, nchannels))
+    {
+		fprintf(stderr, "Audio Init failed\n");
+		goto err_audio;
+    }
+	
+	if(verbose)
+		fprintf(stderr, "Audio initialized - %d channels\n", nchannels);
+	
+	/* background spectrum / tuner analysis */
+	if(spec_init(sample_rate, nchannels, buffer_size, fft_size))
+	{
+		fprintf(stderr, "Spectrum Init failed\n");
+		goto err_spec;
+	}
 		
 	/* wait for splash */
 	if(verbose)
@@ -562,16 +604,19 @@ int main(int argc, char **argv)
 err_adcthread:
 	snd_pcm_drain(playback_handle);
 	snd_pcm_drop(capture_handle);
+	spec_close();
+err_spec:
+    Audio_Close();
+err_audio:
 	free(wrbuf);
 err_wrbuf:
 	free(rdbuf);
 err_rdbuf:
+err_config:
 	snd_pcm_close(capture_handle);
 err_caph:
 	snd_pcm_close(playback_handle);
 err_pbh:
-    Audio_Close();
-err_audio:
 err_codec:
 	adc_deinit();
 err_adc:
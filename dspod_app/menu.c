@@ -1,24 +1,54 @@
 /*
  * menu.c - menuing UI for dspod_cv1800b
  * 09-08-25 E. Brombaugh
+ * 10-19-26 E. Brombaugh - spectrum / tuner screen on long press
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "main.h"
 #include "menu.h"
 #include "widgets.h"
 #include "audio.h"
 #include "encoder.h"
 #include "fx.h"
+#include "spectrum.h"
 
 #define MENU_XMAX 319
 #define MENU_YMAX 169
 #define MENU_CV_WIDTH 50
 #define MENU_VU_WIDTH 50
 
-static uint8_t menu_reset;
+/* screens */
+#define MENU_SCREEN_FX 0
+#define MENU_SCREEN_SPEC 1
+
+/* button held this many menu_process() calls (~0.5 sec) is a long press */
+#define MENU_LONGPRESS 15
+
+/* spectrum columns & dB range shown */
+#define MENU_SPEC_X 10
+#define MENU_SPEC_Y 52
+#define MENU_SPEC_H 100
+#define MENU_SPEC_COLW 4
+#define MENU_SPEC_RANGE 90.0F
+
+/* tuner meter, +/-50 cents over the width */
+#define MENU_TUNE_X0 100
+#define MENU_TUNE_X1 300
+#define MENU_TUNE_Y0 18
+#define MENU_TUNE_Y1 32
+
+static uint8_t menu_reset, menu_screen, menu_btn_down, menu_btn_ticks;
 static int8_t menu_next_algo, menu_curr_algo;
 
+/* spectrum screen state - what's on the display now */
+static spec_result menu_spec_res;
+static uint8_t menu_spec_cols[SPEC_BANDS];
+static int16_t menu_spec_needle, menu_spec_note, menu_spec_cents;
+static uint8_t menu_spec_ana;
+static GFX_COLOR menu_spec_ncolor;
+
 /*
  * Draw splash screen
  */
@@ -52,13 +82,13 @@ void menu_splash(const char *swVersionStr, const char *bdate, const char *btime)
 /*
  * display CPU load on change
  */
-void menu_show_cpuload(void)
+void menu_show_cpuload(uint8_t init)
 {
 	static uint8_t prev_load = 255;
 	uint8_t curr_load = get_load();
 	char textbuf[32];
 	
-	if(curr_load != prev_load)
+	if(init || (curr_load != prev_load))
 	{
 		sprintf(textbuf, "Load: %2u%% ", curr_load);
 		gfx_drawstr(10, 4, textbuf);
@@ -78,7 +108,7 @@ int16_t cv_coords[] =
 /*
  * render CV indicators on change
  */
-void menu_render_cvs(void)
+void menu_render_cvs(uint8_t init)
 {
 	static int16_t prev_cv[4];
 	int16_t curr_cv, i;
@@ -86,7 +116,7 @@ void menu_render_cvs(void)
 	for(i=0;i<4;i++)
 	{
 		curr_cv = adc_buffer[i]/41;
-		if(curr_cv != prev_cv[i])
+		if(init || (curr_cv != prev_cv[i]))
 		{
 			widg_bargraphH(cv_coords[2*i], cv_coords[2*i+1], MENU_CV_WIDTH, 8, curr_cv);		
 			prev_cv[i] = curr_cv;
@@ -97,13 +127,13 @@ void menu_render_cvs(void)
 /*
  * render W/D indicator on change
  */
-void menu_render_wetdry(void)
+void menu_render_wetdry(uint8_t init)
 {
 	static int16_t prev_wetdry = -1;
 	int16_t curr_wetdry = adc_buffer[3]/41;
 	char textbuf[32];
 	
-	if(curr_wetdry != prev_wetdry)
+	if(init || (curr_wetdry != prev_wetdry))
 	{
 		gfx_drawstrctr((240+319)/2, 129-16, "W/D Mix");
 		sprintf(textbuf, "%2d%% ", curr_wetdry);
@@ -161,6 +191,11 @@ void menu_render(void)
 		gfx_drawstr(10, 151, "ir");
 		gfx_drawstr(MENU_XMAX-10-16, 141, "ol");
 		gfx_drawstr(MENU_XMAX-10-16, 151, "or");
+		
+		/* dynamic items that only draw on change */
+		menu_show_cpuload(1);
+		menu_render_cvs(1);
+		menu_render_wetdry(1);
 	}
 	
 	/* divide the updates up into horizontal slices to reduce loading */
@@ -168,7 +203,7 @@ void menu_render(void)
 	{
 		case 0:	// top region
 			/* update dynamic items */
-			menu_show_cpuload();
+			menu_show_cpuload(0);
 			break;
 	
 		case 1:	// center region
@@ -181,11 +216,11 @@ void menu_render(void)
 			}
 			
 			/* update W/D mix param */
-			menu_render_wetdry();
+			menu_render_wetdry(0);
 			break;
 	
 		case 2:	/* CV indicators */
-			menu_render_cvs();
+			menu_render_cvs(0);
 			break;
 		
 		case 3:
@@ -211,6 +246,185 @@ void menu_render(void)
 	vslice = (vslice + 1) % 5;
 }
 
+/*
+ * x coord of a frequency on the spectrum
+ */
+static int16_t menu_spec_freq_x(float freq)
+{
+	float b = SPEC_BANDS * logf(freq / SPEC_FLO) / logf(spec_get_fhi() / SPEC_FLO);
+	
+	return MENU_SPEC_X + b * (MENU_SPEC_COLW + 1);
+}
+
+/*
+ * draw the static items of the spectrum / tuner screen
+ */
+static void menu_spec_reset(void)
+{
+	static const float freqs[] = {50, 100, 200, 500, 1000, 2000, 5000, 10000};
+	static const char *labels[] = {"50", "100", "200", "500", "1k", "2k", "5k", "10k"};
+	int16_t i, x;
+	
+	gfx_set_backcolor(GFX_DGRAY);
+	gfx_set_forecolor(GFX_WHITE);
+	gfx_set_txtscale(1);
+	gfx_clrscreen();
+	
+	/* tuner meter scale */
+	gfx_set_forecolor(GFX_LGRAY);
+	gfx_drawhline(MENU_TUNE_Y1+2, MENU_TUNE_X0, MENU_TUNE_X1);
+	for(i=0;i<5;i++)
+	{
+		x = MENU_TUNE_X0 + i*(MENU_TUNE_X1-MENU_TUNE_X0)/4;
+		gfx_drawvline(x, MENU_TUNE_Y1+2, MENU_TUNE_Y1+5);
+	}
+	gfx_drawvline((MENU_TUNE_X0+MENU_TUNE_X1)/2, MENU_TUNE_Y0, MENU_TUNE_Y1);
+	gfx_drawstrctr(MENU_TUNE_X0, MENU_TUNE_Y1+12, "-50");
+	gfx_drawstrctr((MENU_TUNE_X0+MENU_TUNE_X1)/2, MENU_TUNE_Y1+12, "0");
+	gfx_drawstrctr(MENU_TUNE_X1, MENU_TUNE_Y1+12, "+50");
+	
+	/* frequency axis */
+	for(i=0;i<sizeof(freqs)/sizeof(float);i++)
+	{
+		x = menu_spec_freq_x(freqs[i]);
+		if(freqs[i] >= spec_get_fhi() || x + 4*strlen(labels[i]) > MENU_XMAX)
+			break;
+		gfx_drawvline(x, MENU_SPEC_Y+MENU_SPEC_H, MENU_SPEC_Y+MENU_SPEC_H+2);
+		gfx_drawstrctr(x, MENU_SPEC_Y+MENU_SPEC_H+9, (char *)labels[i]);
+	}
+	gfx_set_forecolor(GFX_WHITE);
+	
+	/* nothing dynamic is on screen yet */
+	memset(menu_spec_cols, 0, sizeof(menu_spec_cols));
+	menu_spec_needle = -1;
+	menu_spec_note = menu_spec_cents = -100;
+	menu_spec_ncolor = GFX_DGRAY;
+	menu_spec_ana = 255;
+	menu_show_cpuload(1);
+}
+
+/*
+ * note, cents & needle from the analysis - each drawn only on change
+ */
+static void menu_spec_tuner(spec_result *res)
+{
+	static const char *names[] =
+		{"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+	int16_t x = -1, cents = 0;
+	GFX_COLOR color = GFX_DGRAY;
+	GFX_RECT rect;
+	char textbuf[32];
+	
+	if(res->note >= 0)
+	{
+		cents = floorf(res->cents + 0.5F);
+		x = (MENU_TUNE_X0+MENU_TUNE_X1)/2 + cents*(MENU_TUNE_X1-MENU_TUNE_X0)/100;
+		color = (cents > -5) && (cents < 5) ? GFX_GREEN : GFX_RED;
+	}
+	
+	/* note name & offset */
+	if((res->note != menu_spec_note) || (cents != menu_spec_cents))
+	{
+		gfx_set_txtscale(2);
+		if(res->note >= 0)
+			sprintf(textbuf, "%-2s%d ", names[res->note % 12], res->note/12 - 1);
+		else
+			sprintf(textbuf, "--  ");
+		gfx_drawstr(10, MENU_TUNE_Y0, textbuf);
+		gfx_set_txtscale(1);
+		if(res->note >= 0)
+			sprintf(textbuf, "%+3dc%7.1fHz", cents, res->pitch);
+		else
+			sprintf(textbuf, "%-14s", "");
+		gfx_drawstr(200, 4, textbuf);
+		menu_spec_note = res->note;
+		menu_spec_cents = cents;
+	}
+	
+	/* move the needle */
+	if((x != menu_spec_needle) || (color != menu_spec_ncolor))
+	{
+		rect.y0 = MENU_TUNE_Y0;
+		rect.y1 = MENU_TUNE_Y1;
+		if(menu_spec_needle >= 0)
+		{
+			rect.x0 = menu_spec_needle-1;
+			rect.x1 = menu_spec_needle+1;
+			gfx_clrrect(&rect);
+			gfx_set_forecolor(GFX_LGRAY);
+			gfx_drawvline((MENU_TUNE_X0+MENU_TUNE_X1)/2, MENU_TUNE_Y0, MENU_TUNE_Y1);
+		}
+		if(x >= 0)
+		{
+			rect.x0 = x-1;
+			rect.x1 = x+1;
+			gfx_set_forecolor(color);
+			gfx_fillrect(&rect);
+		}
+		gfx_set_forecolor(GFX_WHITE);
+		menu_spec_needle = x;
+		menu_spec_ncolor = color;
+	}
+}
+
+/*
+ * update the spectrum / tuner screen
+ */
+static void menu_spec_render(void)
+{
+	static int8_t vslice = 0;
+	uint8_t cols[SPEC_BANDS], i, ana_load;
+	float h;
+	char textbuf[32];
+	
+	/* only when the analysis has moved on, and only the columns that changed */
+	if(spec_get_result(&menu_spec_res))
+	{
+		for(i=0;i<SPEC_BANDS;i++)
+		{
+			h = (menu_spec_res.band[i] + MENU_SPEC_RANGE) * (MENU_SPEC_H / MENU_SPEC_RANGE);
+			h = h < 0.0F ? 0.0F : h;
+			cols[i] = h > MENU_SPEC_H ? MENU_SPEC_H : h;
+		}
+		widg_columnsV(MENU_SPEC_X, MENU_SPEC_Y, SPEC_BANDS, cols, menu_spec_cols);
+		menu_spec_tuner(&menu_spec_res);
+	}
+	
+	/* loads every 5th pass like the main screen, drawn on change */
+	if(vslice == 0)
+	{
+		menu_show_cpuload(0);
+		ana_load = spec_get_load();
+		if(ana_load != menu_spec_ana)
+		{
+			sprintf(textbuf, "Ana: %2u%% ", ana_load);
+			gfx_drawstr(110, 4, textbuf);
+			menu_spec_ana = ana_load;
+		}
+	}
+	vslice = (vslice + 1) % 5;
+}
+
+/*
+ * switch screens - the analysis only runs while it's on display
+ */
+static void menu_set_screen(uint8_t screen)
+{
+	menu_screen = screen;
+	spec_enable(screen == MENU_SCREEN_SPEC);
+	
+	if(screen == MENU_SCREEN_SPEC)
+		menu_spec_reset();
+	else
+	{
+		gfx_set_backcolor(GFX_DGRAY);
+		gfx_set_forecolor(GFX_WHITE);
+		gfx_clrscreen();
+		menu_next_algo = menu_curr_algo;
+		menu_reset = 1;
+	}
+}
+
 /*
  * init the menu state
  */
@@ -221,9 +435,12 @@ void menu_init(void)
 	gfx_set_forecolor(GFX_WHITE);
 	gfx_clrscreen();
 	
-	/* create VU gradient */
+	/* create VU & spectrum gradients */
 	widg_gradient_init(MENU_VU_WIDTH);
+	widg_columns_init(MENU_SPEC_COLW, MENU_SPEC_H);
 	
+	menu_screen = MENU_SCREEN_FX;
+	menu_btn_down = 0;
 	menu_reset = 1;
 	menu_curr_algo = menu_next_algo = 0;
 	
@@ -243,7 +460,14 @@ void menu_process(void)
 	// detect encoder changes
 	if(encoder_poll(&enc_val, &enc_btn))
 	{
-		if(enc_val)
+		/* button down starts timing for long press */
+		if(enc_btn & 2)
+		{
+			menu_btn_down = 1;
+			menu_btn_ticks = 0;
+		}
+		
+		if(enc_val && (menu_screen == MENU_SCREEN_FX))
 		{
 			menu_next_algo += enc_val;
 			menu_next_algo = menu_next_algo < 0 ? 0 : menu_next_algo;
@@ -265,7 +489,9 @@ void menu_process(void)
 			gfx_set_backcolor(GFX_DGRAY);
 		}
 		
-		if(enc_btn == 1)
+		/* release - short press when a long press hasn't already fired */
+		if((enc_btn & 1) && menu_btn_down && (menu_btn_ticks < MENU_LONGPRESS) &&
+			(menu_screen == MENU_SCREEN_FX))
 		{
 			/* erase next algo box */
 			gfx_set_forecolor(GFX_DGRAY);
@@ -281,8 +507,18 @@ void menu_process(void)
 			menu_curr_algo = menu_next_algo;
 			fx_select_algo(menu_next_algo);
 		}
+		if(enc_btn & 1)
+			menu_btn_down = 0;
 	}
 	
+	// long press toggles the spectrum / tuner screen
+	if(menu_btn_down && (menu_btn_ticks < MENU_LONGPRESS) &&
+		(++menu_btn_ticks == MENU_LONGPRESS))
+		menu_set_screen(menu_screen == MENU_SCREEN_FX ? MENU_SCREEN_SPEC : MENU_SCREEN_FX);
+	
 	// update display
-	menu_render();
+	if(menu_screen == MENU_SCREEN_SPEC)
+		menu_spec_render();
+	else
+		menu_render();
 }
@@ -0,0 +1,558 @@
+/*
+ * spectrum.c - background spectrum / pitch analysis for dspod cv1800b
+ * 10-19-26 E. Brombaugh
+ *
+ * The audio thread only copies its input blocks into a lock-free single
+ * producer / single consumer ring of block slots. Everything else runs in
+ * a SCHED_IDLE analysis thread:
+ *
+ *   effect pair -> mono -> FIR decimate to <= 24kHz -> N sample history
+ *
+ * and every N/4 new samples:
+ *
+ *   Blackman-Harris windowed N point real pffft -> peak dBFS per band
+ *   zero-padded 2N point pffft autocorrelation -> NSDF (McLeod) pitch
+ *
+ * Results are handed to the UI under a mutex. Blocks are dropped while
+ * the ring is full or while the display isn't showing the analysis.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include "main.h"
+#include "pffft.h"
+#include "spectrum.h"
+
+/* ring slots - power of 2 */
+#define SPEC_SLOTS 8
+
+/* highest analysis rate & decimation filter taps per unit of decimation */
+#define SPEC_RATE_MAX 24000
+#define SPEC_TAPS_PER 48
+
+/* top band edge & decimation filter cutoff as fractions of analysis rate */
+#define SPEC_FHI 0.42F
+#define SPEC_FC 0.45F
+
+/* band release in dB/s */
+#define SPEC_RELEASE 30.0F
+
+/* pitch detection limits */
+#define SPEC_PMAX 1500.0F
+#define SPEC_NSDF_K 0.9F
+#define SPEC_MIN_CLARITY 0.8F
+#define SPEC_MIN_RMS 0.001F
+
+/* analysis thread poll interval in us */
+#define SPEC_SLEEP 5000
+
+/* block ring - written by the audio thread, read by the analysis thread */
+static char *spec_ring;
+static int spec_ring_len[SPEC_SLOTS];
+static uint32_t spec_slotsz, spec_wr, spec_rd, spec_drops;
+static uint8_t spec_enabled;
+
+/* input format & decimator */
+static int spec_chls, spec_decim, spec_ntaps, spec_phs;
+static float *spec_taps, *spec_dly;
+static uint32_t spec_dly_wr, spec_dly_mask;
+static float spec_rate;
+
+/* analysis */
+static int spec_n, spec_hop, spec_fresh;
+static uint32_t spec_hist_wr;
+static float *spec_hist, *spec_win, *spec_x, *spec_fft, *spec_acf, *spec_work;
+static PFFFT_Setup *spec_setup, *spec_acf_setup;
+static int spec_k0[SPEC_BANDS], spec_k1[SPEC_BANDS];
+static float spec_band[SPEC_BANDS];
+static float spec_wscale, spec_fhi;
+
+/* results for the UI */
+static spec_result spec_res;
+static pthread_mutex_t spec_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* thread & load */
+static pthread_t spec_thread;
+static uint8_t spec_running, spec_quit, spec_load_pct;
+
+/*
+ * time in us from a clock
+ */
+static uint64_t spec_usecs(clockid_t clk)
+{
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return 1000000ULL * ts.tv_sec + ts.tv_nsec / 1000;
+}
+
+/*
+ * mono mix, anti-alias filter and decimate one block into the history
+ */
+static void spec_decimate(int16_t *src, int len)
+{
+	const int r = spec_chls > 1 ? 1 : 0;
+	float acc;
+	int j;
+
+	while(len--)
+	{
+		spec_dly[spec_dly_wr] = (float)(src[0] + src[r]) * (0.5F/32768.0F);
+		src += spec_chls;
+
+		if(++spec_phs == spec_decim)
+		{
+			spec_phs = 0;
+			acc = 0.0F;
+			for(j=0;j<spec_ntaps;j++)
+				acc += spec_taps[j] * spec_dly[(spec_dly_wr - j) & spec_dly_mask];
+			spec_hist[spec_hist_wr] = acc;
+			spec_hist_wr = (spec_hist_wr + 1) & (spec_n - 1);
+			spec_fresh++;
+		}
+		spec_dly_wr = (spec_dly_wr + 1) & spec_dly_mask;
+	}
+}
+
+/*
+ * windowed spectrum -> peak level per band with instant attack and
+ * a release scaled to the samples since the last pass
+ */
+static void spec_bands(int fresh)
+{
+	float *p = spec_fft, pk, db, decay;
+	int i, k, b;
+
+	for(i=0;i<spec_n;i++)
+		p[i] = spec_x[i] * spec_win[i];
+	pffft_transform_ordered(spec_setup, p, p, spec_work, PFFFT_FORWARD);
+
+	/* power per bin into the first half - bin k is read before slot k is hit */
+	p[0] = p[0]*p[0];
+	for(k=1;k<spec_n/2;k++)
+		p[k] = p[2*k]*p[2*k] + p[2*k+1]*p[2*k+1];
+
+	decay = SPEC_RELEASE * fresh / spec_rate;
+	for(b=0;b<SPEC_BANDS;b++)
+	{
+		pk = 0.0F;
+		for(k=spec_k0[b];k<=spec_k1[b];k++)
+			pk = p[k] > pk ? p[k] : pk;
+		db = 10.0F * log10f(pk * spec_wscale + 1e-20F);
+
+		spec_band[b] -= decay;
+		spec_band[b] = db > spec_band[b] ? db : spec_band[b];
+		spec_band[b] = spec_band[b] < SPEC_FLOOR_DB ? SPEC_FLOOR_DB : spec_band[b];
+	}
+}
+
+/*
+ * pitch from the normalised square difference function of the history -
+ * the autocorrelation comes from a zero-padded pffft so it isn't circular
+ */
+static float spec_pitch(float *clarity)
+{
+	float *x = spec_x, *r = spec_acf, mean = 0.0F, e = 0.0F, m, a, b, c, d, den;
+	int n = spec_n, i, k, t, tmin, tmax, best, inlobe, started;
+	int nkeys = 0, keys[64];
+
+	*clarity = 0.0F;
+
+	/* remove DC & gate on level */
+	for(i=0;i<n;i++)
+		mean += x[i];
+	mean /= n;
+	for(i=0;i<n;i++)
+	{
+		x[i] -= mean;
+		e += x[i]*x[i];
+	}
+	if(sqrtf(e / n) < SPEC_MIN_RMS)
+		return 0.0F;
+
+	/* r(t) = IFFT(|FFT(x)|^2) over 2N */
+	memcpy(r, x, n*sizeof(float));
+	memset(r+n, 0, n*sizeof(float));
+	pffft_transform_ordered(spec_acf_setup, r, r, spec_work, PFFFT_FORWARD);
+	r[0] = r[0]*r[0];
+	r[1] = r[1]*r[1];
+	for(k=1;k<n;k++)
+	{
+		r[2*k] = r[2*k]*r[2*k] + r[2*k+1]*r[2*k+1];
+		r[2*k+1] = 0.0F;
+	}
+	pffft_transform_ordered(spec_acf_setup, r, r, spec_work, PFFFT_BACKWARD);
+
+	/* NSDF in place, m(t) = sum of x[j]^2 + x[j+t]^2 kept incrementally */
+	tmin = spec_rate / SPEC_PMAX;
+	tmax = n/2;
+	m = 2.0F * e;
+	r[0] = 1.0F;
+	for(t=1;t<=tmax+1;t++)
+	{
+		m -= x[t-1]*x[t-1] + x[n-t]*x[n-t];
+		r[t] = m > 0.0F ? r[t] / (n * m) : 0.0F;
+	}
+
+	/* key maxima - highest point of each positive lobe after the first dip */
+	started = inlobe = 0;
+	best = 0;
+	for(t=1;t<=tmax;t++)
+	{
+		if(!started)
+		{
+			started = r[t] < 0.0F;
+			continue;
+		}
+
+		if(r[t] > 0.0F)
+		{
+			if(!inlobe || r[t] > r[best])
+				best = t;
+			inlobe = 1;
+		}
+		else if(inlobe)
+		{
+			inlobe = 0;
+			if(best >= tmin && nkeys < 64)
+				keys[nkeys++] = best;
+		}
+	}
+	if(inlobe && best >= tmin && nkeys < 64)
+		keys[nkeys++] = best;
+	if(!nkeys)
+		return 0.0F;
+
+	/* first key within K of the highest */
+	a = 0.0F;
+	for(i=0;i<nkeys;i++)
+		a = r[keys[i]] > a ? r[keys[i]] : a;
+	for(i=0;r[keys[i]]<SPEC_NSDF_K*a;i++)
+		;
+	t = keys[i];
+
+	/* parabolic interpolation */
+	a = r[t-1];
+	b = r[t];
+	c = r[t+1];
+	d = 0.0F;
+	den = a - 2.0F*b + c;
+	if(den < 0.0F)
+		d = 0.5F * (a - c) / den;
+	*clarity = b - 0.25F * (a - c) * d;
+
+	return *clarity < SPEC_MIN_CLARITY ? 0.0F : spec_rate / (t + d);
+}
+
+/*
+ * analyse the history & publish
+ */
+static void spec_analyse(int fresh)
+{
+	float pitch, clarity, midi;
+	int i;
+
+	/* oldest sample first */
+	for(i=0;i<spec_n;i++)
+		spec_x[i] = spec_hist[(spec_hist_wr + i) & (spec_n - 1)];
+
+	spec_bands(fresh);
+	pitch = spec_pitch(&clarity);
+
+	pthread_mutex_lock(&spec_lock);
+	memcpy(spec_res.band, spec_band, sizeof(spec_band));
+	spec_res.pitch = pitch;
+	spec_res.clarity = clarity;
+	spec_res.note = -1;
+	spec_res.cents = 0.0F;
+	if(pitch > 0.0F)
+	{
+		midi = 69.0F + 12.0F * log2f(pitch / 440.0F);
+		spec_res.note = floorf(midi + 0.5F);
+		spec_res.cents = 100.0F * (midi - spec_res.note);
+	}
+	spec_res.seq++;
+	pthread_mutex_unlock(&spec_lock);
+}
+
+/*
+ * analysis thread
+ */
+static void *spec_thread_handler(void *ptr)
+{
+	uint64_t t0, c0, t, c;
+	uint32_t rd, wr;
+	int slot;
+
+	fprintf(stderr, "Starting Analysis Thread\n");
+
+	t0 = spec_usecs(CLOCK_MONOTONIC);
+	c0 = spec_usecs(CLOCK_THREAD_CPUTIME_ID);
+	while(!exit_program && !__atomic_load_n(&spec_quit, __ATOMIC_ACQUIRE))
+	{
+		/* drain the ring */
+		rd = spec_rd;
+		wr = __atomic_load_n(&spec_wr, __ATOMIC_ACQUIRE);
+		while(rd != wr)
+		{
+			slot = rd & (SPEC_SLOTS-1);
+			spec_decimate((int16_t *)(spec_ring + slot*spec_slotsz), spec_ring_len[slot]);
+			__atomic_store_n(&spec_rd, ++rd, __ATOMIC_RELEASE);
+		}
+
+		/* one pass per hop - skip ahead rather than catch up if behind */
+		if(spec_fresh >= spec_hop)
+		{
+			spec_analyse(spec_fresh);
+			spec_fresh = 0;
+		}
+		else
+			usleep(SPEC_SLEEP);
+
+		/* CPU time of this thread over wall time, twice a second */
+		t = spec_usecs(CLOCK_MONOTONIC);
+		if(t - t0 >= 500000)
+		{
+			c = spec_usecs(CLOCK_THREAD_CPUTIME_ID);
+			__atomic_store_n(&spec_load_pct, 100 * (c - c0) / (t - t0), __ATOMIC_RELAXED);
+			t0 = t;
+			c0 = c;
+		}
+	}
+
+	fprintf(stderr, "Analysis Thread Quitting.\n");
+	return NULL;
+}
+
+/*
+ * set up the analysis & start its thread - fftn is 1024, 2048 or 4096
+ */
+int32_t spec_init(int rate, int chls, uint32_t buffer_size, int fftn)
+{
+	pthread_attr_t thread_attr;
+	struct sched_param sched_param;
+	float fc, x, df, lo, hi, ratio, sum;
+	int i, b, n;
+
+	if(fftn < 1024 || fftn > 4096 || (fftn & (fftn - 1)))
+	{
+		fprintf(stderr, "spec_init: FFT size must be 1024, 2048 or 4096\n");
+		return 1;
+	}
+
+	spec_chls = chls;
+	spec_n = n = fftn;
+	spec_hop = n / 4;
+
+	/* decimate down to the analysis rate */
+	spec_decim = (rate + SPEC_RATE_MAX - 1) / SPEC_RATE_MAX;
+	spec_rate = (float)rate / spec_decim;
+	spec_fhi = SPEC_FHI * spec_rate;
+	spec_ntaps = spec_decim > 1 ? SPEC_TAPS_PER * spec_decim + 1 : 1;
+	for(spec_dly_mask = 1; spec_dly_mask < spec_ntaps; spec_dly_mask <<= 1)
+		;
+
+	spec_slotsz = buffer_size;
+	spec_ring = malloc(SPEC_SLOTS * spec_slotsz);
+	spec_taps = malloc(spec_ntaps * sizeof(float));
+	spec_dly = calloc(spec_dly_mask, sizeof(float));
+	spec_hist = calloc(n, sizeof(float));
+	spec_win = malloc(n * sizeof(float));
+	spec_x = malloc(n * sizeof(float));
+	spec_fft = pffft_aligned_malloc(n * sizeof(float));
+	spec_acf = pffft_aligned_malloc(2 * n * sizeof(float));
+	spec_work = pffft_aligned_malloc(2 * n * sizeof(float));
+	spec_setup = pffft_new_setup(n, PFFFT_REAL);
+	spec_acf_setup = pffft_new_setup(2 * n, PFFFT_REAL);
+	if(!spec_ring || !spec_taps || !spec_dly || !spec_hist || !spec_win ||
+		!spec_x || !spec_fft || !spec_acf || !spec_work || !spec_setup ||
+		!spec_acf_setup)
+	{
+		fprintf(stderr, "spec_init: out of memory\n");
+		spec_close();
+		return 1;
+	}
+	spec_dly_mask--;
+
+	/* Blackman windowed sinc anti-alias filter, unity gain at DC */
+	fc = SPEC_FC / spec_decim;
+	sum = 0.0F;
+	for(i=0;i<spec_ntaps;i++)
+	{
+		x = i - (spec_ntaps - 1) / 2;
+		spec_taps[i] = x == 0.0F ? 2.0F * fc : sinf(2.0F * M_PI * fc * x) / (M_PI * x);
+		if(spec_ntaps > 1)
+			spec_taps[i] *= 0.42F - 0.5F * cosf(2.0F * M_PI * i / (spec_ntaps - 1))
+				+ 0.08F * cosf(4.0F * M_PI * i / (spec_ntaps - 1));
+		sum += spec_taps[i];
+	}
+	for(i=0;i<spec_ntaps;i++)
+		spec_taps[i] /= sum;
+
+	/* 4 term Blackman-Harris, scaled so a full scale sine peaks at 0dBFS */
+	sum = 0.0F;
+	for(i=0;i<n;i++)
+	{
+		x = 2.0F * M_PI * i / n;
+		spec_win[i] = 0.35875F - 0.48829F * cosf(x) + 0.14128F * cosf(2.0F * x)
+			- 0.01168F * cosf(3.0F * x);
+		sum += spec_win[i];
+	}
+	spec_wscale = 4.0F / (sum * sum);
+
+	/* band edges to bins - bands narrower than a bin take the nearest one */
+	df = spec_rate / n;
+	ratio = powf(spec_fhi / SPEC_FLO, 1.0F / SPEC_BANDS);
+	for(b=0;b<SPEC_BANDS;b++)
+	{
+		lo = SPEC_FLO * powf(ratio, b);
+		hi = lo * ratio;
+		spec_k0[b] = ceilf(lo / df);
+		spec_k1[b] = ceilf(hi / df) - 1;
+		if(spec_k1[b] < spec_k0[b])
+			spec_k0[b] = spec_k1[b] = floorf(sqrtf(lo * hi) / df + 0.5F);
+		spec_k0[b] = spec_k0[b] < 1 ? 1 : spec_k0[b];
+		spec_k1[b] = spec_k1[b] < spec_k0[b] ? spec_k0[b] : spec_k1[b];
+		spec_band[b] = SPEC_FLOOR_DB;
+	}
+
+	spec_wr = spec_rd = spec_drops = 0;
+	spec_dly_wr = spec_hist_wr = 0;
+	spec_phs = spec_fresh = 0;
+	spec_enabled = spec_quit = spec_load_pct = 0;
+	memset(&spec_res, 0, sizeof(spec_res));
+	spec_res.note = -1;
+
+	/* analysis is best effort - only runs when nothing else wants the CPU */
+	pthread_attr_init(&thread_attr);
+	pthread_attr_setschedpolicy(&thread_attr, SCHED_IDLE);
+	sched_param.sched_priority = 0;
+	pthread_attr_setschedparam(&thread_attr, &sched_param);
+	pthread_attr_setinheritsched(&thread_attr, PTHREAD_EXPLICIT_SCHED);
+	i = pthread_create(&spec_thread, &thread_attr, spec_thread_handler, NULL);
+	pthread_attr_destroy(&thread_attr);
+	if(i)
+	{
+		fprintf(stderr, "spec_init: error creating analysis thread\n");
+		spec_close();
+		return 1;
+	}
+	spec_running = 1;
+
+	if(verbose)
+		fprintf(stderr, "spec_init: %d point FFT at %.0f Hz, %d tap decimator, %.0f - %.0f Hz\n",
+			n, spec_rate, spec_ntaps, SPEC_FLO, spec_fhi);
+
+	return 0;
+}
+
+/*
+ * stop the thread & free everything
+ */
+void spec_close(void)
+{
+	spec_enable(0);
+	if(spec_running)
+	{
+		__atomic_store_n(&spec_quit, 1, __ATOMIC_RELEASE);
+		pthread_join(spec_thread, NULL);
+		spec_running = 0;
+		if(verbose)
+			fprintf(stderr, "spec_close: %u blocks dropped\n", spec_drops);
+	}
+
+	if(spec_setup)
+		pffft_destroy_setup(spec_setup);
+	if(spec_acf_setup)
+		pffft_destroy_setup(spec_acf_setup);
+	pffft_aligned_free(spec_fft);
+	pffft_aligned_free(spec_acf);
+	pffft_aligned_free(spec_work);
+	free(spec_ring);
+	free(spec_taps);
+	free(spec_dly);
+	free(spec_hist);
+	free(spec_win);
+	free(spec_x);
+	spec_setup = spec_acf_setup = NULL;
+	spec_fft = spec_acf = spec_work = NULL;
+	spec_ring = NULL;
+	spec_taps = spec_dly = spec_hist = spec_win = spec_x = NULL;
+}
+
+/*
+ * audio thread side - copy the raw input block into the ring, nothing more
+ */
+void spec_push(int16_t *src, int inframes)
+{
+	uint32_t wr = spec_wr, bytes;
+	int slot;
+
+	if(!__atomic_load_n(&spec_enabled, __ATOMIC_ACQUIRE))
+		return;
+
+	/* drop if the analysis thread is behind */
+	if(wr - __atomic_load_n(&spec_rd, __ATOMIC_ACQUIRE) >= SPEC_SLOTS)
+	{
+		spec_drops++;
+		return;
+	}
+
+	bytes = inframes * spec_chls * sizeof(int16_t);
+	bytes = bytes > spec_slotsz ? spec_slotsz : bytes;
+	slot = wr & (SPEC_SLOTS-1);
+	memcpy(spec_ring + slot*spec_slotsz, src, bytes);
+	spec_ring_len[slot] = bytes / (spec_chls * sizeof(int16_t));
+	__atomic_store_n(&spec_wr, wr + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * start / stop feeding the analysis
+ */
+void spec_enable(uint8_t enable)
+{
+	if(enable && !spec_ring)
+		return;
+	__atomic_store_n(&spec_enabled, enable, __ATOMIC_RELEASE);
+}
+
+/*
+ * copy out the latest results - returns 1 if they're newer than res
+ */
+uint8_t spec_get_result(spec_result *res)
+{
+	uint8_t result = 0;
+
+	pthread_mutex_lock(&spec_lock);
+	if(res->seq != spec_res.seq)
+	{
+		memcpy(res, &spec_res, sizeof(spec_result));
+		result = 1;
+	}
+	pthread_mutex_unlock(&spec_lock);
+
+	return result;
+}
+
+/*
+ * top band edge in Hz
+ */
+float spec_get_fhi(void)
+{
+	return spec_fhi;
+}
+
+/*
+ * analysis thread CPU load in %
+ */
+uint8_t spec_get_load(void)
+{
+	return __atomic_load_n(&spec_load_pct, __ATOMIC_RELAXED);
+}
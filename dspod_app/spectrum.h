@@ -0,0 +1,41 @@
+/*
+ * spectrum.h - background spectrum / pitch analysis for dspod cv1800b
+ * 10-19-26 E. Brombaugh
+ */
+
+#ifndef __spectrum__
+#define __spectrum__
+
+#include <stdint.h>
+
+/* log-spaced bands, one per display column */
+#define SPEC_BANDS 60
+
+/* bands run from SPEC_FLO up to spec_get_fhi() */
+#define SPEC_FLO 25.0F
+
+/* band levels are clamped to this */
+#define SPEC_FLOOR_DB -100.0F
+
+/*
+ * analysis results
+ */
+typedef struct
+{
+	uint32_t seq;				// bumped on every new result
+	float band[SPEC_BANDS];		// peak level in dBFS w/ release ballistics
+	float pitch;				// Hz, 0 if no clear pitch
+	float clarity;				// 0-1 peak of normalised autocorrelation
+	int16_t note;				// MIDI note nearest to pitch, -1 if none
+	float cents;				// pitch offset from note, +/-50
+} spec_result;
+
+int32_t spec_init(int rate, int chls, uint32_t buffer_size, int fftn);
+void spec_close(void);
+void spec_push(int16_t *src, int inframes);
+void spec_enable(uint8_t enable);
+uint8_t spec_get_result(spec_result *res);
+float spec_get_fhi(void);
+uint8_t spec_get_load(void);
+
+#endif
@@ -1,6 +1,7 @@
 /*
  * widgets.c - UI graphics widgets for dspod
  * 03-20-22 E. Brombaugh
+ * 10-19-26 E. Brombaugh - vertical column bars with dirty updates
  */
 #include <stdio.h>
 #include <string.h>
@@ -10,7 +11,12 @@
 
 #define GRAD_MAX_WIDTH 100
 
+#define COLS_MAX_WIDTH 8
+#define COLS_MAX_HEIGHT 160
+
 static uint16_t gradient[2][GRAD_MAX_WIDTH];
+static uint16_t colgrad[COLS_MAX_HEIGHT*COLS_MAX_WIDTH];
+static uint16_t colw, colh;
 
 /*
  * Horizontal bargraph
@@ -120,3 +126,61 @@ void widg_sliderH(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t v)
 		else
 			gfx_drawhline(y+t, x, x+w);
 }
+
+/*
+ * initialize the gradient image for the column bars - red at the top
+ */
+uint8_t widg_columns_init(int16_t width, int16_t height)
+{
+	uint16_t i, j, c;
+	uint8_t hsv[3];
+	
+	if((width > COLS_MAX_WIDTH) || (height > COLS_MAX_HEIGHT))
+		return 1;
+	
+	colw = width;
+	colh = height;
+	hsv[1] = 255;
+	hsv[2] = 255;
+	for(i=0;i<height;i++)
+	{
+		hsv[0] = 85*i/(height-1);
+		c = gfx_getcolor(gfx_hsv2rgb(hsv));
+		for(j=0;j<width;j++)
+			colgrad[i*width+j] = c;
+	}
+	
+	return 0;
+}
+
+/*
+ * Row of n vertical gradient bars on a 1 pixel gap, heights v[] in pixels.
+ * Only the part of each column that differs from prev[] is drawn.
+ */
+void widg_columnsV(uint16_t x, uint16_t y, uint16_t n, uint8_t *v, uint8_t *prev)
+{
+	GFX_RECT rect;
+	uint16_t i, t;
+	
+	for(i=0;i<n;i++)
+	{
+		v[i] = v[i] > colh ? colh : v[i];
+		if(v[i] > prev[i])
+		{
+			/* grown - blit the new top from the gradient */
+			t = colh - v[i];
+			gfx_bitblt(x, y+t, colw, v[i]-prev[i], &colgrad[t*colw]);
+		}
+		else if(v[i] < prev[i])
+		{
+			/* shrunk - clear the old top */
+			rect.x0 = x;
+			rect.y0 = y+colh-prev[i];
+			rect.x1 = x+colw-1;
+			rect.y1 = y+colh-v[i]-1;
+			gfx_clrrect(&rect);
+		}
+		prev[i] = v[i];
+		x += colw+1;
+	}
+}
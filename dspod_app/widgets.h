@@ -1,6 +1,7 @@
 /*
  * widgets.h - UI graphics widgets for dspod
  * 03-20-22 E. Brombaugh
+ * 10-19-26 E. Brombaugh - vertical column bars with dirty updates
  */
 
 #ifndef __widgets__
@@ -12,5 +13,7 @@ void widg_bargraphH(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t v);
 uint8_t widg_gradient_init(int16_t width);
 void widg_bargraphHG(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t v);
 void widg_sliderH(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t v);
+uint8_t widg_columns_init(int16_t width, int16_t height);
+void widg_columnsV(uint16_t x, uint16_t y, uint16_t n, uint8_t *v, uint8_t *prev);
 
 #endif
\ No newline at end of file
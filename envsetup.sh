@@ -84,6 +84,7 @@ sys_inc="${script_dir}/include/system"
 if [[ "${milkv_arch}" == "riscv64" ]]; then
 
 	arch_cflags="-mcpu=c906fdv -march=rv64imafdcv0p7xthead -mcmodel=medany -mabi=lp64d"
+	novec_cflags="-mcpu=c906fd -march=rv64imafdcxthead"
 	arch_ldflags="-D_LARGEFILE_SOURCE -D_LARGEFILE64_SOURCE -D_FILE_OFFSET_BITS=64"
 
 	toolchain_dir=${host_tools}/gcc/riscv64-linux-musl-x86_64
@@ -92,6 +93,7 @@ if [[ "${milkv_arch}" == "riscv64" ]]; then
 elif [[ "${milkv_arch}" == "arm64" ]]; then
 
 	arch_cflags="-march=armv8-a"
+	novec_cflags=""
 	arch_ldflags=""
 
 	toolchain_dir="${host_tools}/gcc/gcc-linaro-7.3.1-2018.05-x86_64_aarch64-linux-gnu"
@@ -123,6 +125,8 @@ fi
 export CC="${TOOLCHAIN_PREFIX}gcc"
 export CFLAGS="${arch_cflags} ${debug_cflags} -I${sys_inc}"
 export LDFLAGS="${arch_ldflags} -L${sys_lib}"
+# appended to CFLAGS for code that must run without the vector unit
+export NOVEC_CFLAGS="${novec_cflags}"
 
 export CHIP="${milkv_chip}"
 
@@ -0,0 +1,24 @@
+/*
+  fftpackd : fftpack.c in double precision, see fftpackd.h.
+*/
+
+#include "fftpackd.h"
+
+#define FFTPACK_DOUBLE_PRECISION
+#define cffti dcffti
+#define cfftf dcfftf
+#define cfftb dcfftb
+#define rffti drffti
+#define rfftf drfftf
+#define rfftb drfftb
+#define cosqi dcosqi
+#define cosqf dcosqf
+#define cosqb dcosqb
+#define costi dcosti
+#define cost dcost
+#define sinqi dsinqi
+#define sinqb dsinqb
+#define sinqf dsinqf
+#define sinti dsinti
+#define sint dsint
+#include "fftpack.c"
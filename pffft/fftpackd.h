@@ -0,0 +1,40 @@
+/*
+  fftpackd : fftpack.c built in double precision (FFTPACK_DOUBLE_PRECISION)
+  with the d prefixed names of the netlib dfftpack, so that it links next
+  to the float fftpack. The reference for pffftd in test_pffft.c.
+*/
+
+#ifndef FFTPACKD_H
+#define FFTPACKD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  void dcffti(int n, double *wsave);
+  void dcfftf(int n, double *c, double *wsave);
+  void dcfftb(int n, double *c, double *wsave);
+
+  void drffti(int n, double *wsave);
+  void drfftf(int n, double *r, double *wsave);
+  void drfftb(int n, double *r, double *wsave);
+
+  void dcosqi(int n, double *wsave);
+  void dcosqf(int n, double *x, double *wsave);
+  void dcosqb(int n, double *x, double *wsave);
+
+  void dcosti(int n, double *wsave);
+  void dcost(int n, double *x, double *wsave);
+
+  void dsinqi(int n, double *wsave);
+  void dsinqb(int n, double *x, double *wsave);
+  void dsinqf(int n, double *x, double *wsave);
+
+  void dsinti(int n, double *wsave);
+  void dsint(int n, double *x, double *wsave);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FFTPACKD_H
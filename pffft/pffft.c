@@ -61,9 +61,14 @@
 #  define _USE_MATH_DEFINES // ask gently MSVC to define M_PI, M_SQRT2 etc.
 #endif
 
-#include "pffft.h"
+#ifdef PFFFT_DOUBLE
+#  include "pffftd.h"
+#else
+#  include "pffft.h"
+#endif
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 
@@ -79,11 +84,13 @@
 #  define NEVER_INLINE(return_type) return_type __attribute__ ((noinline))
 #  define RESTRICT __restrict
 #  define VLA_ARRAY_ON_STACK(type__, varname__, size__) type__ varname__[size__];
+#  define UNROLL_FULL _Pragma("GCC unroll 32")
 #elif defined(COMPILER_MSVC)
 #  define ALWAYS_INLINE(return_type) __forceinline return_type
 #  define NEVER_INLINE(return_type) __declspec(noinline) return_type
 #  define RESTRICT __restrict
 #  define VLA_ARRAY_ON_STACK(type__, varname__, size__) type__ *varname__ = (type__*)_alloca(size__ * sizeof(type__))
+#  define UNROLL_FULL
 #endif
 
 
@@ -97,26 +104,118 @@
 // define PFFFT_SIMD_DISABLE if you want to use scalar code instead of simd code
 //#define PFFFT_SIMD_DISABLE
 
+/*
+  double precision, built by pffftd.c: SSE2 and the GCC vector extension
+  (float64x2 on arm64, RVV e64 on RISC-V when PFFFT_SIMD_VECEXT is
+  defined) give 2 doubles per vector, AVX 4.
+  32-bit ARM and Altivec have no double vectors and run the scalar code.
+*/
+#if defined(PFFFT_DOUBLE) && !defined(PFFFT_SIMD_DISABLE)
+#  if defined(PFFFT_SIMD_VECEXT)
+#  elif defined(__AVX__)
+#    define PFFFT_SIMD_AVX
+#  elif defined(__x86_64__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define PFFFT_SIMD_SSE
+#  elif defined(__aarch64__) && defined(COMPILER_GCC)
+#    define PFFFT_SIMD_VECEXT
+#  endif
+
 /* select which SIMD intrinsics will be used */
-#if !defined(PFFFT_SIMD_DISABLE)
-#  if (defined(__ppc__) || defined(__ppc64__) || defined(__powerpc__) || defined(__powerpc64__)) \
+#elif !defined(PFFFT_SIMD_DISABLE)
+#  if defined(PFFFT_SIMD_VECEXT)
+     // forced use of the GCC vector extension backend, e.g. to test it on a host
+#  elif (defined(__ppc__) || defined(__ppc64__) || defined(__powerpc__) || defined(__powerpc64__)) \
    && (defined(__VEC__) || defined(__ALTIVEC__))
 #    define PFFFT_SIMD_ALTIVEC
 #  elif defined(__ARM_NEON) || defined(__aarch64__) || defined(__arm64)  \
    || defined(_M_ARM64) || defined(_M_ARM64EC) || defined(__wasm_simd128__)
      // we test _M_ARM64EC before _M_X64 because when _M_ARM64EC is defined, the microsoft compiler also defines _M_X64
 #    define PFFFT_SIMD_NEON
+#  elif defined(__AVX__)
+#    define PFFFT_SIMD_AVX
 #  elif defined(__x86_64__) || defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
 #    define PFFFT_SIMD_SSE
-#  elif defined( __riscv_vector)
-#    define PFFFT_SIMD_RISCV
+     // no __riscv_vector case: the RVV types are sizeless so can't be used as
+     // v4sf, and the vector extension backend that maps fixed vectors onto it
+     // has to be asked for with -DPFFFT_SIMD_VECEXT until it is measured
+     // faster than scalar on the C906
 #   endif
 #endif // PFFFT_SIMD_DISABLE
 
+/*
+  AVX double support macros - 4 doubles by vector, so the 4-wide
+  finalize/preprocess code is used as with SSE floats. unpack works within
+  the 128-bit halves and permute2f128 moves the halves.
+*/
+#if defined(PFFFT_DOUBLE) && defined(PFFFT_SIMD_AVX)
+
+#include <immintrin.h>
+typedef __m256d v4sf;
+#  define SIMD_SZ 4
+#  define VZERO() _mm256_setzero_pd()
+#  define VMUL(a,b) _mm256_mul_pd(a,b)
+#  define VADD(a,b) _mm256_add_pd(a,b)
+#  ifdef __FMA__
+#  define VMADD(a,b,c) _mm256_fmadd_pd(a,b,c)
+#  define VMSUB(a,b,c) _mm256_fmsub_pd(a,b,c)
+#  else
+#  define VMADD(a,b,c) _mm256_add_pd(_mm256_mul_pd(a,b), c)
+#  endif
+#  define VSUB(a,b) _mm256_sub_pd(a,b)
+#  define LD_PS1(p) _mm256_set1_pd(p)
+#  define INTERLEAVE2(in1, in2, out1, out2) {                            \
+    v4sf lo__ = _mm256_unpacklo_pd(in1, in2), hi__ = _mm256_unpackhi_pd(in1, in2); \
+    out1 = _mm256_permute2f128_pd(lo__, hi__, 0x20);                    \
+    out2 = _mm256_permute2f128_pd(lo__, hi__, 0x31);                    \
+  }
+#  define UNINTERLEAVE2(in1, in2, out1, out2) {                          \
+    v4sf lo__ = _mm256_permute2f128_pd(in1, in2, 0x20), hi__ = _mm256_permute2f128_pd(in1, in2, 0x31); \
+    out1 = _mm256_unpacklo_pd(lo__, hi__);                              \
+    out2 = _mm256_unpackhi_pd(lo__, hi__);                              \
+  }
+#  define VTRANSPOSE4(x0,x1,x2,x3) {                                    \
+    v4sf t0_ = _mm256_unpacklo_pd(x0, x1), t1_ = _mm256_unpackhi_pd(x0, x1); \
+    v4sf t2_ = _mm256_unpacklo_pd(x2, x3), t3_ = _mm256_unpackhi_pd(x2, x3); \
+    x0 = _mm256_permute2f128_pd(t0_, t2_, 0x20);                        \
+    x1 = _mm256_permute2f128_pd(t1_, t3_, 0x20);                        \
+    x2 = _mm256_permute2f128_pd(t0_, t2_, 0x31);                        \
+    x3 = _mm256_permute2f128_pd(t1_, t3_, 0x31);                        \
+  }
+#  define VSWAPHL(a,b) _mm256_permute2f128_pd(b, a, 0x30)
+#  define VALIGNED(ptr) ((((size_t)(ptr)) & 0x1F) == 0)
+
+/*
+  SSE2 double support macros - 2 doubles by vector, generic
+  finalize/preprocess code. A 2x2 interleave is its own inverse.
+*/
+#elif defined(PFFFT_DOUBLE) && defined(PFFFT_SIMD_SSE)
+
+#ifdef __FMA__
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+typedef __m128d v4sf;
+#  define SIMD_SZ 2
+#  define VZERO() _mm_setzero_pd()
+#  define VMUL(a,b) _mm_mul_pd(a,b)
+#  define VADD(a,b) _mm_add_pd(a,b)
+#  ifdef __FMA__
+#  define VMADD(a,b,c) _mm_fmadd_pd(a,b,c)
+#  define VMSUB(a,b,c) _mm_fmsub_pd(a,b,c)
+#  else
+#  define VMADD(a,b,c) _mm_add_pd(_mm_mul_pd(a,b), c)
+#  endif
+#  define VSUB(a,b) _mm_sub_pd(a,b)
+#  define LD_PS1(p) _mm_set1_pd(p)
+#  define INTERLEAVE2(in1, in2, out1, out2) { v4sf tmp__ = _mm_unpacklo_pd(in1, in2); out2 = _mm_unpackhi_pd(in1, in2); out1 = tmp__; }
+#  define UNINTERLEAVE2(in1, in2, out1, out2) INTERLEAVE2(in1, in2, out1, out2)
+#  define VALIGNED(ptr) ((((size_t)(ptr)) & 0xF) == 0)
+
 /*
   Altivec support macros
 */
-#ifdef PFFFT_SIMD_ALTIVEC
+#elif defined(PFFFT_SIMD_ALTIVEC)
 #include <altivec.h>
 typedef vector float v4sf;
 #  define SIMD_SZ 4
@@ -146,18 +245,61 @@ inline v4sf ld_ps1(const float *p) { v4sf v=vec_lde(0,p); return vec_splat(vec_p
 #  define VSWAPHL(a,b) vec_perm(a,b, (vector unsigned char){16,17,18,19,20,21,22,23,8,9,10,11,12,13,14,15})
 #  define VALIGNED(ptr) ((((size_t)(ptr)) & 0xF) == 0)
 
+/*
+  AVX support macros - 8 floats by vector so this uses the generic wide
+  finalize/preprocess code. With FMA (-mavx2 -mfma or -march=native on
+  anything from Haswell on) the multiply-adds are fused.
+*/
+#elif defined(PFFFT_SIMD_AVX)
+
+#include <immintrin.h>
+typedef __m256 v4sf;
+#  define SIMD_SZ 8
+#  define VZERO() _mm256_setzero_ps()
+#  define VMUL(a,b) _mm256_mul_ps(a,b)
+#  define VADD(a,b) _mm256_add_ps(a,b)
+#  ifdef __FMA__
+#  define VMADD(a,b,c) _mm256_fmadd_ps(a,b,c)
+#  define VMSUB(a,b,c) _mm256_fmsub_ps(a,b,c)
+#  else
+#  define VMADD(a,b,c) _mm256_add_ps(_mm256_mul_ps(a,b), c)
+#  endif
+#  define VSUB(a,b) _mm256_sub_ps(a,b)
+#  define LD_PS1(p) _mm256_set1_ps(p)
+// unpack works within the 128-bit halves, so fix up across them
+#  define INTERLEAVE2(in1, in2, out1, out2) {                            \
+    v4sf lo__ = _mm256_unpacklo_ps(in1, in2), hi__ = _mm256_unpackhi_ps(in1, in2); \
+    out1 = _mm256_permute2f128_ps(lo__, hi__, 0x20);                    \
+    out2 = _mm256_permute2f128_ps(lo__, hi__, 0x31);                    \
+  }
+#  define UNINTERLEAVE2(in1, in2, out1, out2) {                          \
+    v4sf lo__ = _mm256_permute2f128_ps(in1, in2, 0x20), hi__ = _mm256_permute2f128_ps(in1, in2, 0x31); \
+    out1 = _mm256_shuffle_ps(lo__, hi__, _MM_SHUFFLE(2,0,2,0));         \
+    out2 = _mm256_shuffle_ps(lo__, hi__, _MM_SHUFFLE(3,1,3,1));         \
+  }
+#  define VALIGNED(ptr) ((((size_t)(ptr)) & 0x1F) == 0)
+
 /*
   SSE1 support macros
 */
 #elif defined(PFFFT_SIMD_SSE)
 
+#ifdef __FMA__
+#include <immintrin.h>
+#else
 #include <xmmintrin.h>
+#endif
 typedef __m128 v4sf;
-#  define SIMD_SZ 4 // 4 floats by simd vector -- this is pretty much hardcoded in the preprocess/finalize functions anyway so you will have to work if you want to enable AVX with its 256-bit vectors.
+#  define SIMD_SZ 4 // 4 floats by simd vector -- this is pretty much hardcoded in the preprocess/finalize functions anyway, wider vectors go through the generic code used by the AVX path.
 #  define VZERO() _mm_setzero_ps()
 #  define VMUL(a,b) _mm_mul_ps(a,b)
 #  define VADD(a,b) _mm_add_ps(a,b)
+#  ifdef __FMA__
+#  define VMADD(a,b,c) _mm_fmadd_ps(a,b,c)
+#  define VMSUB(a,b,c) _mm_fmsub_ps(a,b,c)
+#  else
 #  define VMADD(a,b,c) _mm_add_ps(_mm_mul_ps(a,b), c)
+#  endif
 #  define VSUB(a,b) _mm_sub_ps(a,b)
 #  define LD_PS1(p) _mm_set1_ps(p)
 #  define INTERLEAVE2(in1, in2, out1, out2) { v4sf tmp__ = _mm_unpacklo_ps(in1, in2); out2 = _mm_unpackhi_ps(in1, in2); out1 = tmp__; }
@@ -194,35 +336,121 @@ typedef float32x4_t v4sf;
 #  define VALIGNED(ptr) ((((size_t)(ptr)) & 0x3) == 0)
 
 /*
-  RISC-V vector support macros
- */
-#elif defined(PFFFT_SIMD_RISCV)
-#  warning "SIMD not available on RISC-V!\n";
-#  define PFFFT_SIMD_DISABLE // fallback to scalar code
-#  if 0
-/* RVV dynamically sized types are incompatible with the way pffft is written */
-#   include <riscv_vector.h>
-typedef vfloat32m1_t v4sf;
-#   define SIMD_SZ 4
-#   define VZERO() vfmv_v_f_f32m1(0.0f,SIMD_SZ)
-#   define VMUL(a,b) vfmul_vv_f32m1(a,b,SIMD_SZ)
-#   define VADD(a,b) vfadd_vv_f32m1(a,b,SIMD_SZ)
-#   define VMADD(a,b,c) vfmacc_vv_f32m1(c,a,b,SIMD_SZ)
-#   define VSUB(a,b) vfsub_vv_f32m1(a,b,SIMD_SZ)
-#   define LD_PS1(p) vfmv_v_f_f32m1(0.0f,SIMD_SZ)
-#   define INTERLEAVE2(in1, in2, out1, out2) vfmv_v_f_f32m1(0.0f,SIMD_SZ)
-#   define UNINTERLEAVE2(in1, in2, out1, out2) vfmv_v_f_f32m1(0.0f,SIMD_SZ)
-#   define VTRANSPOSE4(x0,x1,x2,x3) vfmv_v_f_f32m1(0.0f,SIMD_SZ)
-#   define VSWAPHL(a,b) vfmv_v_f_f32m1(0.0f,SIMD_SZ)
-#   define VALIGNED(ptr) ((((size_t)(ptr)) & 0xF) == 0)
+  GCC vector extension support macros - used for RISC-V vector where the
+  native RVV types are sizeless and can't be stored in arrays or structs.
+  Fixed 16-byte vectors are lowered by the compiler to vle32/vfadd/vse32
+  etc. with VL=4, and __builtin_shuffle gives the permutes. Any other GCC
+  target can use this too by defining PFFFT_SIMD_VECEXT.
+
+  Defining PFFFT_SIMD_SZ as 8 or 16 makes the vectors 32 or 64 bytes wide,
+  which RVV handles with LMUL=2/4 register groups and x86 with AVX/AVX-512.
+  The wide widths use the generic finalize/preprocess code below.
+
+  pffftd builds the same with doubles, 2 to a 16-byte vector by default.
+*/
+#elif defined(PFFFT_SIMD_VECEXT)
+#  ifdef PFFFT_DOUBLE
+#    define VECEXT_T double
+#    define VECEXT_I long long
+#    ifndef PFFFT_SIMD_SZ
+#      define PFFFT_SIMD_SZ 2
+#    endif
+#  else
+#    define VECEXT_T float
+#    define VECEXT_I int
+#    ifndef PFFFT_SIMD_SZ
+#      define PFFFT_SIMD_SZ 4
+#    endif
+#  endif
+#  define SIMD_SZ PFFFT_SIMD_SZ
+typedef VECEXT_T v4sf __attribute__ ((vector_size (sizeof(VECEXT_T)*SIMD_SZ)));
+typedef VECEXT_I v4si __attribute__ ((vector_size (sizeof(VECEXT_T)*SIMD_SZ)));
+#  define VZERO() ((v4sf){ 0 })
+#  define VMUL(a,b) ((a)*(b))
+#  define VADD(a,b) ((a)+(b))
+#  define VMADD(a,b,c) ((a)*(b)+(c))
+#  define VSUB(a,b) ((a)-(b))
+static ALWAYS_INLINE(v4sf) ld_ps1(VECEXT_T p) { return VZERO() + p; }
+#  define LD_PS1(p) ld_ps1(p)
+#  if SIMD_SZ == 2
+#    define VILV_LO ((v4si){ 0, 2 })
+#    define VILV_HI ((v4si){ 1, 3 })
+#    define VUNILV_LO VILV_LO
+#    define VUNILV_HI VILV_HI
+#  elif SIMD_SZ == 8
+#    define VILV_LO ((v4si){ 0, 8, 1, 9, 2, 10, 3, 11 })
+#    define VILV_HI ((v4si){ 4, 12, 5, 13, 6, 14, 7, 15 })
+#    define VUNILV_LO ((v4si){ 0, 2, 4, 6, 8, 10, 12, 14 })
+#    define VUNILV_HI ((v4si){ 1, 3, 5, 7, 9, 11, 13, 15 })
+#  elif SIMD_SZ == 16
+#    define VILV_LO ((v4si){ 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23 })
+#    define VILV_HI ((v4si){ 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31 })
+#    define VUNILV_LO ((v4si){ 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30 })
+#    define VUNILV_HI ((v4si){ 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31 })
+#  elif SIMD_SZ != 4
+#    error "PFFFT_SIMD_SZ must be 2, 4, 8 or 16"
 #  endif
+#  if SIMD_SZ == 4
+#  define INTERLEAVE2(in1, in2, out1, out2) { v4sf tmp__ = __builtin_shuffle(in1, in2, (v4si){ 0, 4, 1, 5 }); out2 = __builtin_shuffle(in1, in2, (v4si){ 2, 6, 3, 7 }); out1 = tmp__; }
+#  define UNINTERLEAVE2(in1, in2, out1, out2) { v4sf tmp__ = __builtin_shuffle(in1, in2, (v4si){ 0, 2, 4, 6 }); out2 = __builtin_shuffle(in1, in2, (v4si){ 1, 3, 5, 7 }); out1 = tmp__; }
+#  define VTRANSPOSE4(x0,x1,x2,x3) {                               \
+    v4sf y0 = __builtin_shuffle(x0, x2, (v4si){ 0, 4, 1, 5 });     \
+    v4sf y1 = __builtin_shuffle(x0, x2, (v4si){ 2, 6, 3, 7 });     \
+    v4sf y2 = __builtin_shuffle(x1, x3, (v4si){ 0, 4, 1, 5 });     \
+    v4sf y3 = __builtin_shuffle(x1, x3, (v4si){ 2, 6, 3, 7 });     \
+    x0 = __builtin_shuffle(y0, y2, (v4si){ 0, 4, 1, 5 });          \
+    x1 = __builtin_shuffle(y0, y2, (v4si){ 2, 6, 3, 7 });          \
+    x2 = __builtin_shuffle(y1, y3, (v4si){ 0, 4, 1, 5 });          \
+    x3 = __builtin_shuffle(y1, y3, (v4si){ 2, 6, 3, 7 });          \
+  }
+#  define VSWAPHL(a,b) __builtin_shuffle(a, b, (v4si){ 4, 5, 2, 3 })
+#  else
+#  define INTERLEAVE2(in1, in2, out1, out2) { v4sf tmp__ = __builtin_shuffle(in1, in2, VILV_LO); out2 = __builtin_shuffle(in1, in2, VILV_HI); out1 = tmp__; }
+#  define UNINTERLEAVE2(in1, in2, out1, out2) { v4sf tmp__ = __builtin_shuffle(in1, in2, VUNILV_LO); out2 = __builtin_shuffle(in1, in2, VUNILV_HI); out1 = tmp__; }
+#  endif
+#  define VALIGNED(ptr) ((((size_t)(ptr)) & (sizeof(VECEXT_T)*SIMD_SZ-1)) == 0)
+
 #else
-#  if !defined(PFFFT_SIMD_DISABLE)
+#  if !defined(PFFFT_SIMD_DISABLE) && defined(__riscv_vector)
+#    warning "RVV is not used by default, define PFFFT_SIMD_VECEXT (not yet measured on the C906) or PFFFT_SIMD_DISABLE"
+#    define PFFFT_SIMD_DISABLE
+#  elif !defined(PFFFT_SIMD_DISABLE)
 #    warning "building with simd disabled !\n";
 #    define PFFFT_SIMD_DISABLE // fallback to scalar code
 #  endif
 #endif
 
+/*
+  the vector types are set, from here on pffftd.c compiles the same code in
+  double precision, with the public names of pffftd.h
+*/
+#ifdef PFFFT_DOUBLE
+#  define float double
+#  define PFFFT_Setup PFFFTD_Setup
+#  define pffft_new_setup pffftd_new_setup
+#  define pffft_destroy_setup pffftd_destroy_setup
+#  define pffft_setup_bytes pffftd_setup_bytes
+#  define pffft_new_setup_inplace pffftd_new_setup_inplace
+#  define pffft_setup_tables pffftd_setup_tables
+#  define pffft_transform pffftd_transform
+#  define pffft_transform_ordered pffftd_transform_ordered
+#  define pffft_transform_batch pffftd_transform_batch
+#  define pffft_zreorder pffftd_zreorder
+#  define pffft_zconvolve_accumulate pffftd_zconvolve_accumulate
+#  define pffft_zconvolve_sum pffftd_zconvolve_sum
+#  define pffft_aligned_malloc pffftd_aligned_malloc
+#  define pffft_aligned_free pffftd_aligned_free
+#  define pffft_simd_size pffftd_simd_size
+#  define pffft_twiddle_recur pffftd_twiddle_recur
+#  define pffft_min_fft_size pffftd_min_fft_size
+#  define pffft_cplx_finalize pffftd_cplx_finalize
+#  define pffft_cplx_preprocess pffftd_cplx_preprocess
+#  define pffft_transform_internal pffftd_transform_internal
+#  define cffti1_ps cffti1_pd
+#  define cfftf1_ps cfftf1_pd
+#  define validate_pffft_simd validate_pffftd_simd
+#endif
+
 // fallback mode for situations where SSE/Altivec are not available, use scalar mode instead
 #ifdef PFFFT_SIMD_DISABLE
 typedef float v4sf;
@@ -237,8 +465,14 @@ typedef float v4sf;
 #endif
 
 // shortcuts for complex multiplcations
+#ifdef VMSUB
+// fused versions, VMSUB(a,b,c) is a*b-c
+#define VCPLXMUL(ar,ai,br,bi) { v4sf tmp; tmp=VMUL(ai,bi); ai=VMADD(ar,bi,VMUL(ai,br)); ar=VMSUB(ar,br,tmp); }
+#define VCPLXMULCONJ(ar,ai,br,bi) { v4sf tmp; tmp=VMUL(ar,bi); ar=VMADD(ai,bi,VMUL(ar,br)); ai=VMSUB(ai,br,tmp); }
+#else
 #define VCPLXMUL(ar,ai,br,bi) { v4sf tmp; tmp=VMUL(ar,bi); ar=VMUL(ar,br); ar=VSUB(ar,VMUL(ai,bi)); ai=VMUL(ai,br); ai=VADD(ai,tmp); }
 #define VCPLXMULCONJ(ar,ai,br,bi) { v4sf tmp; tmp=VMUL(ar,bi); ar=VMUL(ar,br); ar=VADD(ar,VMUL(ai,bi)); ai=VMUL(ai,br); ai=VSUB(ai,tmp); }
+#endif
 #ifndef SVMUL
 // multiply a scalar with a vector
 #define SVMUL(f,v) VMUL(LD_PS1(f),v)
@@ -247,10 +481,13 @@ typedef float v4sf;
 #if !defined(PFFFT_SIMD_DISABLE)
 typedef union v4sf_union {
   v4sf  v;
-  float f[4];
+  float f[SIMD_SZ];
 } v4sf_union;
 
-#include <string.h>
+#if SIMD_SZ == 4
+static ALWAYS_INLINE(void) vtranspose(v4sf *x) {
+  VTRANSPOSE4(x[0], x[1], x[2], x[3]);
+}
 
 #define assertv4(v,f0,f1,f2,f3) assert(v.f[0] == (f0) && v.f[1] == (f1) && v.f[2] == (f2) && v.f[3] == (f3))
 
@@ -292,11 +529,74 @@ void validate_pffft_simd(void) {
   assertv4(a0, 0, 4, 8, 12); assertv4(a1, 1, 5, 9, 13); assertv4(a2, 2, 6, 10, 14); assertv4(a3, 3, 7, 11, 15);
 }
 #else
+/*
+  SIMD_SZ x SIMD_SZ transpose of x[0..SIMD_SZ-1]: log2(SIMD_SZ) rounds of
+  interleaving row k with row k+SIMD_SZ/2, the same as VTRANSPOSE4 does with
+  two rounds for 4x4.
+*/
+static ALWAYS_INLINE(void) vtranspose(v4sf *x) {
+  v4sf y[SIMD_SZ];
+  int k, r;
+  UNROLL_FULL
+  for (r=1; r < SIMD_SZ; r *= 2) {
+    UNROLL_FULL
+    for (k=0; k < SIMD_SZ/2; ++k) {
+      INTERLEAVE2(x[k], x[k+SIMD_SZ/2], y[2*k], y[2*k+1]);
+    }
+    UNROLL_FULL
+    for (k=0; k < SIMD_SZ; ++k) x[k] = y[k];
+  }
+}
+
+/* other widths - same checks, looped over the lanes */
+void validate_pffft_simd(void) {
+  v4sf_union a[SIMD_SZ > 2 ? SIMD_SZ : 3], t, u; // a[2] is used below
+  int j, k;
+  for (k=0; k < (int)(sizeof(a)/sizeof(a[0])); ++k)
+    for (j=0; j < SIMD_SZ; ++j) a[k].f[j] = (float)(k*SIMD_SZ + j);
+
+  t.v = VZERO();
+  for (j=0; j < SIMD_SZ; ++j) assert(t.f[j] == 0);
+  t.v = VADD(a[1].v, a[2].v);
+  for (j=0; j < SIMD_SZ; ++j) assert(t.f[j] == a[1].f[j] + a[2].f[j]);
+  t.v = VMUL(a[1].v, a[2].v);
+  for (j=0; j < SIMD_SZ; ++j) assert(t.f[j] == a[1].f[j] * a[2].f[j]);
+  t.v = VMADD(a[1].v, a[2].v, a[0].v);
+  for (j=0; j < SIMD_SZ; ++j) assert(t.f[j] == a[1].f[j] * a[2].f[j] + a[0].f[j]);
+  t.v = LD_PS1(a[1].f[1]);
+  for (j=0; j < SIMD_SZ; ++j) assert(t.f[j] == SIMD_SZ + 1);
+
+  INTERLEAVE2(a[1].v, a[2].v, t.v, u.v);
+  for (j=0; j < SIMD_SZ/2; ++j) {
+    assert(t.f[2*j] == a[1].f[j] && t.f[2*j+1] == a[2].f[j]);
+    assert(u.f[2*j] == a[1].f[j+SIMD_SZ/2] && u.f[2*j+1] == a[2].f[j+SIMD_SZ/2]);
+  }
+  UNINTERLEAVE2(a[1].v, a[2].v, t.v, u.v);
+  for (j=0; j < SIMD_SZ/2; ++j) {
+    assert(t.f[j] == a[1].f[2*j] && t.f[j+SIMD_SZ/2] == a[2].f[2*j]);
+    assert(u.f[j] == a[1].f[2*j+1] && u.f[j+SIMD_SZ/2] == a[2].f[2*j+1]);
+  }
+
+  {
+    v4sf x[SIMD_SZ];
+    for (k=0; k < SIMD_SZ; ++k) x[k] = a[k].v;
+    vtranspose(x);
+    for (k=0; k < SIMD_SZ; ++k) {
+      t.v = x[k];
+      for (j=0; j < SIMD_SZ; ++j) assert(t.f[j] == a[j].f[k]);
+    }
+  }
+  printf("SIMD_SZ=%d vector macros ok\n", SIMD_SZ);
+}
+#endif
+#else
 void validate_pffft_simd() {} // allow test_pffft.c to call this function even when simd is not available..
 #endif //!PFFFT_SIMD_DISABLE
 
-/* SSE and co like 16-bytes aligned pointers */
-#define MALLOC_V4SF_ALIGNMENT 64 // with a 64-byte alignment, we are even aligned on L2 cache lines...
+/* SSE and co like 16-bytes aligned pointers, with a 64-byte alignment
+   we are even aligned on L2 cache lines. The widest vectors (16 doubles
+   with VECEXT) need their own size. */
+#define MALLOC_V4SF_ALIGNMENT (sizeof(v4sf) > 64 ? sizeof(v4sf) : 64)
 void *pffft_aligned_malloc(size_t nb_bytes) {
   void *p, *p0 = malloc(nb_bytes + MALLOC_V4SF_ALIGNMENT);
   if (!p0) return (void *) 0;
@@ -311,6 +611,10 @@ void pffft_aligned_free(void *p) {
 
 int pffft_simd_size(void) { return SIMD_SZ; }
 
+int pffft_min_fft_size(pffft_transform_t transform) {
+  return (transform == PFFFT_REAL ? 2 : 1) * SIMD_SZ * SIMD_SZ;
+}
+
 /*
   passf2 and passb2 has been merged here, fsign = -1 for passf2, +1 for passb2
 */
@@ -346,7 +650,7 @@ static NEVER_INLINE(void) passf2_ps(int ido, int l1, const v4sf *cc, v4sf *ch, c
 static NEVER_INLINE(void) passf3_ps(int ido, int l1, const v4sf *cc, v4sf *ch,
                                     const float *wa1, const float *wa2, float fsign) {
   static const float taur = -0.5f;
-  float taui = 0.866025403784439f*fsign;
+  float taui = 0.866025403784438647*fsign;
   int i, k;
   v4sf tr2, ti2, cr2, ci2, cr3, ci3, dr2, di2, dr3, di3;
   int l1ido = l1*ido;
@@ -451,10 +755,10 @@ static NEVER_INLINE(void) passf4_ps(int ido, int l1, const v4sf *cc, v4sf *ch,
 static NEVER_INLINE(void) passf5_ps(int ido, int l1, const v4sf *cc, v4sf *ch,
                                     const float *wa1, const float *wa2,
                                     const float *wa3, const float *wa4, float fsign) {
-  static const float tr11 = .309016994374947f;
-  const float ti11 = .951056516295154f*fsign;
-  static const float tr12 = -.809016994374947f;
-  const float ti12 = .587785252292473f*fsign;
+  static const float tr11 = .309016994374947424;
+  const float ti11 = .951056516295153572*fsign;
+  static const float tr12 = -.809016994374947424;
+  const float ti12 = .587785252292473129*fsign;
 
   /* Local variables */
   int i, k;
@@ -515,6 +819,99 @@ static NEVER_INLINE(void) passf5_ps(int ido, int l1, const v4sf *cc, v4sf *ch,
 #undef cc_ref
 }
 
+/*
+  in-place 8 point dft of (xr[j], xi[j]), fsign = -1 forward, +1 backward.
+  Two radix 4 butterflies on the even and odd points, then a radix 2 one,
+  all in registers.
+*/
+static ALWAYS_INLINE(void) dft8_ps(v4sf *xr, v4sf *xi, float fsign) {
+  static const float hsqt2 = (float)0.7071067811865475;
+  v4sf f = LD_PS1(fsign), h = LD_PS1(hsqt2);
+  v4sf t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+  v4sf e0r, e0i, e1r, e1i, e2r, e2i, e3r, e3i;
+  v4sf o0r, o0i, o1r, o1i, o2r, o2i, o3r, o3i;
+  v4sf wr, wi;
+
+  t0r = VADD(xr[0], xr[4]); t0i = VADD(xi[0], xi[4]);
+  t1r = VSUB(xr[0], xr[4]); t1i = VSUB(xi[0], xi[4]);
+  t2r = VADD(xr[2], xr[6]); t2i = VADD(xi[2], xi[6]);
+  t3r = VMUL(f, VSUB(xr[2], xr[6])); t3i = VMUL(f, VSUB(xi[2], xi[6]));
+  e0r = VADD(t0r, t2r); e0i = VADD(t0i, t2i);
+  e2r = VSUB(t0r, t2r); e2i = VSUB(t0i, t2i);
+  e1r = VSUB(t1r, t3i); e1i = VADD(t1i, t3r);
+  e3r = VADD(t1r, t3i); e3i = VSUB(t1i, t3r);
+
+  t0r = VADD(xr[1], xr[5]); t0i = VADD(xi[1], xi[5]);
+  t1r = VSUB(xr[1], xr[5]); t1i = VSUB(xi[1], xi[5]);
+  t2r = VADD(xr[3], xr[7]); t2i = VADD(xi[3], xi[7]);
+  t3r = VMUL(f, VSUB(xr[3], xr[7])); t3i = VMUL(f, VSUB(xi[3], xi[7]));
+  o0r = VADD(t0r, t2r); o0i = VADD(t0i, t2i);
+  o2r = VSUB(t0r, t2r); o2i = VSUB(t0i, t2i);
+  o1r = VSUB(t1r, t3i); o1i = VADD(t1i, t3r);
+  o3r = VADD(t1r, t3i); o3i = VSUB(t1i, t3r);
+
+  xr[0] = VADD(e0r, o0r); xi[0] = VADD(e0i, o0i);
+  xr[4] = VSUB(e0r, o0r); xi[4] = VSUB(e0i, o0i);
+  /* o1 * sqrt(1/2)(1 + i*fsign) */
+  wr = VMUL(h, VSUB(o1r, VMUL(f, o1i)));
+  wi = VMUL(h, VADD(o1i, VMUL(f, o1r)));
+  xr[1] = VADD(e1r, wr); xi[1] = VADD(e1i, wi);
+  xr[5] = VSUB(e1r, wr); xi[5] = VSUB(e1i, wi);
+  /* o2 * i*fsign */
+  wr = VMUL(f, o2i);
+  wi = VMUL(f, o2r);
+  xr[2] = VSUB(e2r, wr); xi[2] = VADD(e2i, wi);
+  xr[6] = VADD(e2r, wr); xi[6] = VSUB(e2i, wi);
+  /* o3 * sqrt(1/2)(-1 + i*fsign) */
+  wr = VMUL(h, VADD(o3r, VMUL(f, o3i)));
+  wi = VMUL(h, VSUB(VMUL(f, o3r), o3i));
+  xr[3] = VSUB(e3r, wr); xi[3] = VADD(e3i, wi);
+  xr[7] = VADD(e3r, wr); xi[7] = VSUB(e3i, wi);
+}
+
+/*
+  passf8 and passb8, fsign = -1 for passf8, +1 for passb8. Does the work
+  of a radix 2 and a radix 4 pass with a single trip through memory. The
+  seven twiddle rows are ido apart in wa.
+*/
+static NEVER_INLINE(void) passf8_ps(int ido, int l1, const v4sf *cc, v4sf *ch,
+                                    const float *wa, float fsign) {
+  int i, k;
+  int l1ido = l1*ido;
+  v4sf xr[8], xi[8], f = LD_PS1(fsign);
+  for (k=0; k < l1ido; k += ido, ch += ido, cc += 8*ido) {
+    for (i=0; i<ido-1; i+=2) {
+      xr[0] = cc[i + 0*ido]; xi[0] = cc[i + 0*ido + 1];
+      xr[1] = cc[i + 1*ido]; xi[1] = cc[i + 1*ido + 1];
+      xr[2] = cc[i + 2*ido]; xi[2] = cc[i + 2*ido + 1];
+      xr[3] = cc[i + 3*ido]; xi[3] = cc[i + 3*ido + 1];
+      xr[4] = cc[i + 4*ido]; xi[4] = cc[i + 4*ido + 1];
+      xr[5] = cc[i + 5*ido]; xi[5] = cc[i + 5*ido + 1];
+      xr[6] = cc[i + 6*ido]; xi[6] = cc[i + 6*ido + 1];
+      xr[7] = cc[i + 7*ido]; xi[7] = cc[i + 7*ido + 1];
+      dft8_ps(xr, xi, fsign);
+      if (ido > 2) {
+        const float *w = wa + i;
+        VCPLXMUL(xr[1], xi[1], LD_PS1(w[0*ido]), VMUL(f, LD_PS1(w[0*ido + 1])));
+        VCPLXMUL(xr[2], xi[2], LD_PS1(w[1*ido]), VMUL(f, LD_PS1(w[1*ido + 1])));
+        VCPLXMUL(xr[3], xi[3], LD_PS1(w[2*ido]), VMUL(f, LD_PS1(w[2*ido + 1])));
+        VCPLXMUL(xr[4], xi[4], LD_PS1(w[3*ido]), VMUL(f, LD_PS1(w[3*ido + 1])));
+        VCPLXMUL(xr[5], xi[5], LD_PS1(w[4*ido]), VMUL(f, LD_PS1(w[4*ido + 1])));
+        VCPLXMUL(xr[6], xi[6], LD_PS1(w[5*ido]), VMUL(f, LD_PS1(w[5*ido + 1])));
+        VCPLXMUL(xr[7], xi[7], LD_PS1(w[6*ido]), VMUL(f, LD_PS1(w[6*ido + 1])));
+      }
+      ch[i + 0*l1ido] = xr[0]; ch[i + 0*l1ido + 1] = xi[0];
+      ch[i + 1*l1ido] = xr[1]; ch[i + 1*l1ido + 1] = xi[1];
+      ch[i + 2*l1ido] = xr[2]; ch[i + 2*l1ido + 1] = xi[2];
+      ch[i + 3*l1ido] = xr[3]; ch[i + 3*l1ido + 1] = xi[3];
+      ch[i + 4*l1ido] = xr[4]; ch[i + 4*l1ido + 1] = xi[4];
+      ch[i + 5*l1ido] = xr[5]; ch[i + 5*l1ido + 1] = xi[5];
+      ch[i + 6*l1ido] = xr[6]; ch[i + 6*l1ido + 1] = xi[6];
+      ch[i + 7*l1ido] = xr[7]; ch[i + 7*l1ido + 1] = xi[7];
+    }
+  }
+} /* passf8 */
+
 static NEVER_INLINE(void) radf2_ps(int ido, int l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch, const float *wa1) {
   static const float minus_one = -1.f;
   int i, k, l1ido = l1*ido;
@@ -581,7 +978,7 @@ static NEVER_INLINE(void) radb2_ps(int ido, int l1, const v4sf *cc, v4sf *ch, co
 static void radf3_ps(int ido, int l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch,
                      const float *wa1, const float *wa2) {
   static const float taur = -0.5f;
-  static const float taui = 0.866025403784439f;
+  static const float taui = 0.866025403784438647;
   int i, k, ic;
   v4sf ci2, di2, di3, cr2, dr2, dr3, ti2, ti3, tr2, tr3, wr1, wi1, wr2, wi2;
   for (k=0; k<l1; k++) {
@@ -623,8 +1020,8 @@ static void radb3_ps(int ido, int l1, const v4sf *RESTRICT cc, v4sf *RESTRICT ch
                      const float *wa1, const float *wa2)
 {
   static const float taur = -0.5f;
-  static const float taui = 0.866025403784439f;
-  static const float taui_2 = 1.732050807568878f;
+  static const float taui = 0.866025403784438647;
+  static const float taui_2 = 1.73205080756887729;
   int i, k, ic;
   v4sf ci2, ci3, di2, di3, cr2, cr3, dr2, dr3, ti2, tr2;
   for (k=0; k<l1; k++) {
@@ -828,10 +1225,10 @@ static NEVER_INLINE(void) radb4_ps(int ido, int l1, const v4sf * RESTRICT cc, v4
 static void radf5_ps(int ido, int l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch,
                      const float *wa1, const float *wa2, const float *wa3, const float *wa4)
 {
-  static const float tr11 = .309016994374947f;
-  static const float ti11 = .951056516295154f;
-  static const float tr12 = -.809016994374947f;
-  static const float ti12 = .587785252292473f;
+  static const float tr11 = .309016994374947424;
+  static const float ti11 = .951056516295153572;
+  static const float tr12 = -.809016994374947424;
+  static const float ti12 = .587785252292473129;
 
   /* System generated locals */
   int cc_offset, ch_offset;
@@ -915,10 +1312,10 @@ static void radf5_ps(int ido, int l1, const v4sf * RESTRICT cc, v4sf * RESTRICT
 static void radb5_ps(int ido, int l1, const v4sf *RESTRICT cc, v4sf *RESTRICT ch,
                      const float *wa1, const float *wa2, const float *wa3, const float *wa4)
 {
-  static const float tr11 = .309016994374947f;
-  static const float ti11 = .951056516295154f;
-  static const float tr12 = -.809016994374947f;
-  static const float ti12 = .587785252292473f;
+  static const float tr11 = .309016994374947424;
+  static const float ti11 = .951056516295153572;
+  static const float tr12 = -.809016994374947424;
+  static const float ti12 = .587785252292473129;
 
   int cc_offset, ch_offset;
 
@@ -1001,6 +1398,175 @@ static void radb5_ps(int ido, int l1, const v4sf *RESTRICT cc, v4sf *RESTRICT ch
 #undef ch_ref
 } /* radb5 */
 
+/* cos(j*pi/8) and sin(j*pi/8), the twiddles of the ido/2 bin of the radix 8 passes */
+static const float rad8_nyq_c[8] = { 1, 0.923879532511286756, 0.707106781186547524, 0.382683432365089772,
+                                     0, -0.382683432365089772, -0.707106781186547524, -0.923879532511286756 };
+static const float rad8_nyq_s[8] = { 0, 0.382683432365089772, 0.707106781186547524, 0.923879532511286756,
+                                     1, 0.923879532511286756, 0.707106781186547524, 0.382683432365089772 };
+
+/* the seven twiddle rows are ido apart in wa */
+static NEVER_INLINE(void) radf8_ps(int ido, int l1, const v4sf *RESTRICT cc, v4sf * RESTRICT ch,
+                                   const float * RESTRICT wa)
+{
+  static const float hsqt2 = (float)0.7071067811865475;
+  int i, j, k, l1ido = l1*ido;
+  v4sf xr[8], xi[8];
+  {
+    const v4sf *RESTRICT cc_ = cc, * RESTRICT cc_end = cc + l1ido;
+    v4sf * RESTRICT ch_ = ch;
+    while (cc < cc_end) {
+      v4sf a0 = cc[0], a1 = cc[1*l1ido], a2 = cc[2*l1ido], a3 = cc[3*l1ido];
+      v4sf a4 = cc[4*l1ido], a5 = cc[5*l1ido], a6 = cc[6*l1ido], a7 = cc[7*l1ido];
+      v4sf t0 = VADD(a0, a4), t1 = VSUB(a0, a4), t2 = VADD(a2, a6), t3 = VSUB(a2, a6);
+      v4sf u0 = VADD(a1, a5), u1 = VSUB(a1, a5), u2 = VADD(a3, a7), u3 = VSUB(a3, a7);
+      v4sf p = SVMUL(hsqt2, VSUB(u1, u3)), q = SVMUL(hsqt2, VADD(u1, u3));
+      v4sf e0 = VADD(t0, t2), o0 = VADD(u0, u2);
+      ch[0      ] = VADD(e0, o0);
+      ch[8*ido-1] = VSUB(e0, o0);
+      ch[2*ido-1] = VADD(t1, p);
+      ch[2*ido  ] = VSUB(VZERO(), VADD(t3, q));
+      ch[4*ido-1] = VSUB(t0, t2);
+      ch[4*ido  ] = VSUB(u2, u0);
+      ch[6*ido-1] = VSUB(t1, p);
+      ch[6*ido  ] = VSUB(t3, q);
+      cc += ido; ch += 8*ido;
+    }
+    cc = cc_; ch = ch_;
+  }
+  if (ido < 2) return;
+  if (ido != 2) {
+    for (k = 0; k < l1ido; k += ido) {
+      const v4sf * RESTRICT pc = (v4sf*)(cc + 1 + k);
+      v4sf * RESTRICT po = ch + 8*k;
+      for (i=2; i<ido; i += 2, pc += 2) {
+        int ic = ido - i;
+        const float *w = wa + i - 2;
+        xr[0] = pc[0]; xi[0] = pc[1];
+        xr[1] = pc[1*l1ido]; xi[1] = pc[1*l1ido + 1];
+        xr[2] = pc[2*l1ido]; xi[2] = pc[2*l1ido + 1];
+        xr[3] = pc[3*l1ido]; xi[3] = pc[3*l1ido + 1];
+        xr[4] = pc[4*l1ido]; xi[4] = pc[4*l1ido + 1];
+        xr[5] = pc[5*l1ido]; xi[5] = pc[5*l1ido + 1];
+        xr[6] = pc[6*l1ido]; xi[6] = pc[6*l1ido + 1];
+        xr[7] = pc[7*l1ido]; xi[7] = pc[7*l1ido + 1];
+        VCPLXMULCONJ(xr[1], xi[1], LD_PS1(w[0*ido]), LD_PS1(w[0*ido + 1]));
+        VCPLXMULCONJ(xr[2], xi[2], LD_PS1(w[1*ido]), LD_PS1(w[1*ido + 1]));
+        VCPLXMULCONJ(xr[3], xi[3], LD_PS1(w[2*ido]), LD_PS1(w[2*ido + 1]));
+        VCPLXMULCONJ(xr[4], xi[4], LD_PS1(w[3*ido]), LD_PS1(w[3*ido + 1]));
+        VCPLXMULCONJ(xr[5], xi[5], LD_PS1(w[4*ido]), LD_PS1(w[4*ido + 1]));
+        VCPLXMULCONJ(xr[6], xi[6], LD_PS1(w[5*ido]), LD_PS1(w[5*ido + 1]));
+        VCPLXMULCONJ(xr[7], xi[7], LD_PS1(w[6*ido]), LD_PS1(w[6*ido + 1]));
+        dft8_ps(xr, xi, -1.f);
+        /* bins 0..3 in place, 4..7 conjugated and mirrored */
+        po[i - 1 + 0*ido] = xr[0]; po[i + 0*ido] = xi[0];
+        po[i - 1 + 2*ido] = xr[1]; po[i + 2*ido] = xi[1];
+        po[i - 1 + 4*ido] = xr[2]; po[i + 4*ido] = xi[2];
+        po[i - 1 + 6*ido] = xr[3]; po[i + 6*ido] = xi[3];
+        po[ic - 1 + 7*ido] = xr[4]; po[ic + 7*ido] = VSUB(VZERO(), xi[4]);
+        po[ic - 1 + 5*ido] = xr[5]; po[ic + 5*ido] = VSUB(VZERO(), xi[5]);
+        po[ic - 1 + 3*ido] = xr[6]; po[ic + 3*ido] = VSUB(VZERO(), xi[6]);
+        po[ic - 1 + 1*ido] = xr[7]; po[ic + 1*ido] = VSUB(VZERO(), xi[7]);
+      }
+    }
+    if (ido % 2 == 1) return;
+  }
+  for (k=0; k<l1ido; k += ido) {
+    for (j=0; j < 8; ++j) {
+      v4sf a = cc[ido-1 + k + j*l1ido];
+      xr[j] = SVMUL(rad8_nyq_c[j], a);
+      xi[j] = VSUB(VZERO(), SVMUL(rad8_nyq_s[j], a));
+    }
+    dft8_ps(xr, xi, -1.f);
+    for (j=0; j < 4; ++j) {
+      ch[ido-1 + 8*k + 2*j*ido] = xr[j];
+      ch[8*k + (2*j+1)*ido] = xi[j];
+    }
+  }
+} /* radf8 */
+
+static NEVER_INLINE(void) radb8_ps(int ido, int l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch,
+                                   const float * RESTRICT wa)
+{
+  static const float sqrt2 = (float)1.414213562373095;
+  static const float two = 2.f;
+  int i, j, k, l1ido = l1*ido;
+  v4sf xr[8], xi[8];
+  {
+    const v4sf *RESTRICT cc_ = cc, * RESTRICT ch_end = ch + l1ido;
+    v4sf *ch_ = ch;
+    while (ch < ch_end) {
+      v4sf y0 = cc[0], y4 = cc[8*ido-1];
+      v4sf r1 = cc[2*ido-1], i1 = cc[2*ido];
+      v4sf r2 = SVMUL(two, cc[4*ido-1]), i2 = SVMUL(two, cc[4*ido]);
+      v4sf r3 = cc[6*ido-1], i3 = cc[6*ido];
+      v4sf a = VADD(y0, y4), b = VSUB(y0, y4);
+      v4sf a0 = VADD(a, r2), a1 = VSUB(a, r2);
+      v4sf b0 = SVMUL(two, VADD(r1, r3)), b1 = SVMUL(two, VSUB(i1, i3));
+      v4sf c0 = VSUB(b, i2), c1 = VADD(b, i2);
+      v4sf p = SVMUL(sqrt2, VSUB(r1, r3)), q = SVMUL(sqrt2, VADD(i1, i3));
+      v4sf pmq = VSUB(p, q), ppq = VADD(p, q);
+      ch[0*l1ido] = VADD(a0, b0);
+      ch[4*l1ido] = VSUB(a0, b0);
+      ch[2*l1ido] = VSUB(a1, b1);
+      ch[6*l1ido] = VADD(a1, b1);
+      ch[1*l1ido] = VADD(c0, pmq);
+      ch[5*l1ido] = VSUB(c0, pmq);
+      ch[3*l1ido] = VSUB(c1, ppq);
+      ch[7*l1ido] = VADD(c1, ppq);
+      cc += 8*ido; ch += ido;
+    }
+    cc = cc_; ch = ch_;
+  }
+  if (ido < 2) return;
+  if (ido != 2) {
+    for (k = 0; k < l1ido; k += ido) {
+      const v4sf * RESTRICT pc = (v4sf*)(cc + 8*k);
+      v4sf * RESTRICT ph = (v4sf*)(ch + k + 1);
+      for (i = 2; i < ido; i += 2, ph += 2) {
+        int ic = ido - i;
+        const float *w = wa + i - 2;
+        xr[0] = pc[i - 1 + 0*ido]; xi[0] = pc[i + 0*ido];
+        xr[1] = pc[i - 1 + 2*ido]; xi[1] = pc[i + 2*ido];
+        xr[2] = pc[i - 1 + 4*ido]; xi[2] = pc[i + 4*ido];
+        xr[3] = pc[i - 1 + 6*ido]; xi[3] = pc[i + 6*ido];
+        xr[4] = pc[ic - 1 + 7*ido]; xi[4] = VSUB(VZERO(), pc[ic + 7*ido]);
+        xr[5] = pc[ic - 1 + 5*ido]; xi[5] = VSUB(VZERO(), pc[ic + 5*ido]);
+        xr[6] = pc[ic - 1 + 3*ido]; xi[6] = VSUB(VZERO(), pc[ic + 3*ido]);
+        xr[7] = pc[ic - 1 + 1*ido]; xi[7] = VSUB(VZERO(), pc[ic + 1*ido]);
+        dft8_ps(xr, xi, 1.f);
+        VCPLXMUL(xr[1], xi[1], LD_PS1(w[0*ido]), LD_PS1(w[0*ido + 1]));
+        VCPLXMUL(xr[2], xi[2], LD_PS1(w[1*ido]), LD_PS1(w[1*ido + 1]));
+        VCPLXMUL(xr[3], xi[3], LD_PS1(w[2*ido]), LD_PS1(w[2*ido + 1]));
+        VCPLXMUL(xr[4], xi[4], LD_PS1(w[3*ido]), LD_PS1(w[3*ido + 1]));
+        VCPLXMUL(xr[5], xi[5], LD_PS1(w[4*ido]), LD_PS1(w[4*ido + 1]));
+        VCPLXMUL(xr[6], xi[6], LD_PS1(w[5*ido]), LD_PS1(w[5*ido + 1]));
+        VCPLXMUL(xr[7], xi[7], LD_PS1(w[6*ido]), LD_PS1(w[6*ido + 1]));
+        ph[0*l1ido] = xr[0]; ph[0*l1ido + 1] = xi[0];
+        ph[1*l1ido] = xr[1]; ph[1*l1ido + 1] = xi[1];
+        ph[2*l1ido] = xr[2]; ph[2*l1ido + 1] = xi[2];
+        ph[3*l1ido] = xr[3]; ph[3*l1ido + 1] = xi[3];
+        ph[4*l1ido] = xr[4]; ph[4*l1ido + 1] = xi[4];
+        ph[5*l1ido] = xr[5]; ph[5*l1ido + 1] = xi[5];
+        ph[6*l1ido] = xr[6]; ph[6*l1ido + 1] = xi[6];
+        ph[7*l1ido] = xr[7]; ph[7*l1ido + 1] = xi[7];
+      }
+    }
+    if (ido % 2 == 1) return;
+  }
+  for (k=0; k < l1ido; k+=ido) {
+    for (j=0; j < 4; ++j) {
+      xr[j] = cc[ido-1 + 8*k + 2*j*ido];
+      xi[j] = cc[8*k + (2*j+1)*ido];
+      xr[j+4] = xi[j+4] = VZERO();
+    }
+    dft8_ps(xr, xi, 1.f);
+    for (j=0; j < 8; ++j) {
+      v4sf c = SVMUL(rad8_nyq_c[j], xr[j]), s = SVMUL(rad8_nyq_s[j], xi[j]);
+      ch[ido-1 + k + j*l1ido] = SVMUL(two, VSUB(c, s));
+    }
+  }
+} /* radb8 */
+
 static NEVER_INLINE(v4sf *) rfftf1_ps(int n, const v4sf *input_readonly, v4sf *work1, v4sf *work2,
                                       const float *wa, const int *ifac) {
   v4sf *in  = (v4sf*)input_readonly;
@@ -1016,6 +1582,9 @@ static NEVER_INLINE(v4sf *) rfftf1_ps(int n, const v4sf *input_readonly, v4sf *w
     int ido = n / l2;
     iw -= (ip - 1)*ido;
     switch (ip) {
+      case 8:
+        radf8_ps(ido, l1, in, out, &wa[iw]);
+        break;
       case 5: {
         int ix2 = iw + ido;
         int ix3 = ix2 + ido;
@@ -1061,6 +1630,9 @@ static NEVER_INLINE(v4sf *) rfftb1_ps(int n, const v4sf *input_readonly, v4sf *w
     int l2 = ip*l1;
     int ido = n / l2;
     switch (ip) {
+      case 8:
+        radb8_ps(ido, l1, in, out, &wa[iw]);
+        break;
       case 5: {
         int ix2 = iw + ido;
         int ix3 = ix2 + ido;
@@ -1124,12 +1696,15 @@ static int decompose(int n, int *ifac, const int *ntryh) {
 
 
 
+/* factor order of the real and complex passes */
+static const int rffti_ntryh[] = { 8,4,2,3,5,0 };
+static const int cffti_ntryh[] = { 5,3,8,4,2,0 };
+
 static void rffti1_ps(int n, float *wa, int *ifac)
 {
-  static const int ntryh[] = { 4,2,3,5,0 };
   int k1, j, ii;
 
-  int nf = decompose(n,ifac,ntryh);
+  int nf = decompose(n,ifac,rffti_ntryh);
   float argh = (2*M_PI) / n;
   int is = 0;
   int nfm1 = nf - 1;
@@ -1159,10 +1734,9 @@ static void rffti1_ps(int n, float *wa, int *ifac)
 
 void cffti1_ps(int n, float *wa, int *ifac)
 {
-  static const int ntryh[] = { 5,3,4,2,0 };
   int k1, j, ii;
 
-  int nf = decompose(n,ifac,ntryh);
+  int nf = decompose(n,ifac,cffti_ntryh);
   float argh = (2*M_PI)/(float)n;
   int i = 1;
   int l1 = 1;
@@ -1186,7 +1760,7 @@ void cffti1_ps(int n, float *wa, int *ifac)
         wa[i-1] = cos(fi*argld);
         wa[i] = sin(fi*argld);
       }
-      if (ip > 5) {
+      if (ip > 5 && ip != 8) {
         wa[i1-1] = wa[i-1];
         wa[i1] = wa[i];
       }
@@ -1209,6 +1783,9 @@ v4sf *cfftf1_ps(int n, const v4sf *input_readonly, v4sf *work1, v4sf *work2, con
     int ido = n / l2;
     int idot = ido + ido;
     switch (ip) {
+      case 8: {
+        passf8_ps(idot, l1, in, out, &wa[iw], isign);
+      } break;
       case 5: {
         int ix2 = iw + idot;
         int ix3 = ix2 + idot;
@@ -1243,52 +1820,144 @@ v4sf *cfftf1_ps(int n, const v4sf *input_readonly, v4sf *work1, v4sf *work2, con
 }
 
 
+/* largest N that pffft_transform_batch runs one signal per simd lane */
+#ifndef PFFFT_BATCH_MAX_N
+#define PFFFT_BATCH_MAX_N 256
+#endif
+
+/*
+  The finalize / preprocess twiddles e[] are SIMD_SZ-1 complex vectors per
+  block of SIMD_SZ complex vectors, 3/4 of the setup at the default width.
+  Built with PFFFT_TWIDDLE_RECUR=R (a power of 2) only every R-th block is
+  stored and the blocks in between are rotated on from it, one complex
+  multiply per vector, so e[] takes about R times less room and cache. The
+  error grows by about one float rounding per step.
+*/
+#if defined(PFFFT_TWIDDLE_RECUR) && SIMD_SZ > 1
+#  define TWIDDLE_RECUR PFFFT_TWIDDLE_RECUR
+#  if (TWIDDLE_RECUR & (TWIDDLE_RECUR - 1)) || TWIDDLE_RECUR < 2
+#    error "PFFFT_TWIDDLE_RECUR must be a power of 2"
+#  endif
+#endif
+
+/* vectors of e[]: every block, or the anchor blocks and the rotations */
+static int setup_e_vectors(int Ncvec) {
+#ifdef TWIDDLE_RECUR
+  int dk = Ncvec/SIMD_SZ;
+  return 2*(SIMD_SZ-1)*((dk + TWIDDLE_RECUR-1)/TWIDDLE_RECUR + 1);
+#else
+  return 2*Ncvec*(SIMD_SZ-1)/SIMD_SZ;
+#endif
+}
+
 struct PFFFT_Setup {
   int     N;
   int     Ncvec; // nb of complex simd vectors (N/4 if PFFFT_COMPLEX, N/8 if PFFFT_REAL)
   // hold the decomposition into small integers of N
-  int ifac[IFAC_MAX_SIZE]; // N , number of factors, factors (admitted values: 2, 3, 4 ou 5)
+  int ifac[IFAC_MAX_SIZE]; // N , number of factors, factors (admitted values: 2, 3, 4, 5 ou 8)
   pffft_transform_t transform;
-  v4sf *data; // allocated room for twiddle coefs
-  float *e;    // points into 'data' , N/4*3 elements
+  v4sf *data; // room for twiddle coefs, right after the struct
+  float *e;    // points into 'data' , N/4*3 elements, fewer with PFFFT_TWIDDLE_RECUR
   float *twiddle; // points into 'data', N/4 elements
+  // full length N twiddles for pffft_transform_batch, right after 'data', NULL if N is too large
+  float *btwiddle;
+  int bifac[IFAC_MAX_SIZE];
+  void *mem; // block to free for pffft_new_setup, NULL when placed by the caller
 };
 
-PFFFT_Setup *pffft_new_setup(int N, pffft_transform_t transform) {
-  // validate N for negative values or potential int overflow
-  if (N < 0) {
+/* struct size rounded up so that 'data' is aligned */
+#define SETUP_HEAD_BYTES ((sizeof(PFFFT_Setup) + MALLOC_V4SF_ALIGNMENT - 1) & ~(size_t)(MALLOC_V4SF_ALIGNMENT - 1))
+
+/* floats of twiddles, 'data' and 'btwiddle' together */
+static size_t setup_table_floats(int N, pffft_transform_t transform) {
+  int Ncvec = (transform == PFFFT_REAL ? N/2 : N)/SIMD_SZ;
+  size_t n = (size_t)setup_e_vectors(Ncvec)*SIMD_SZ + 2*(size_t)Ncvec;
+  if (SIMD_SZ > 1 && N <= PFFFT_BATCH_MAX_N) {
+    n += (transform == PFFFT_REAL ? N : 2*N);
+  }
+  return n;
+}
+
+size_t pffft_setup_bytes(int N, pffft_transform_t transform) {
+  int n;
+  if (N <= 0 || N > (1<<26) || N % pffft_min_fft_size(transform)) {
     return 0;
   }
-  if (N > (1<<26)) {
-    // higher values of N will make you enter in the integer overflow world...
-    assert(0);
+  /* both factor orders end up with 2, 3 and 5 only */
+  for (n = N/SIMD_SZ; n % 2 == 0; n /= 2);
+  for (; n % 3 == 0; n /= 3);
+  for (; n % 5 == 0; n /= 5);
+  if (n != 1) {
     return 0;
   }
-  PFFFT_Setup *s = (PFFFT_Setup*)malloc(sizeof(PFFFT_Setup));
+  return MALLOC_V4SF_ALIGNMENT + SETUP_HEAD_BYTES + setup_table_floats(N, transform)*sizeof(float);
+}
+
+PFFFT_Setup *pffft_new_setup_inplace(void *mem, size_t bytes, int N, pffft_transform_t transform,
+                                     const float *tables, int nfloats) {
+  size_t need = pffft_setup_bytes(N, transform);
+  PFFFT_Setup *s;
   int k, m;
-  /* unfortunately, the fft size must be a multiple of 16 for complex FFTs
-     and 32 for real FFTs -- a lot of stuff would need to be rewritten to
-     handle other cases (or maybe just switch to a scalar fft, I don't know..) */
-  if (transform == PFFFT_REAL) { assert((N%(2*SIMD_SZ*SIMD_SZ))==0 && N>0); }
-  if (transform == PFFFT_COMPLEX) { assert((N%(SIMD_SZ*SIMD_SZ))==0 && N>0); }
-  //assert((N % 32) == 0);
+
+  if (!need || bytes < need) {
+    return 0;
+  }
+  /* tables of another size or build would be read past their end */
+  if (tables && (size_t)nfloats != setup_table_floats(N, transform)) {
+    return 0;
+  }
+  s = (PFFFT_Setup*)(((size_t)mem + MALLOC_V4SF_ALIGNMENT - 1) & ~(size_t)(MALLOC_V4SF_ALIGNMENT - 1));
   s->N = N;
   s->transform = transform;
+  s->mem = 0;
   /* nb of complex simd vectors */
   s->Ncvec = (transform == PFFFT_REAL ? N/2 : N)/SIMD_SZ;
-  s->data = (v4sf*)pffft_aligned_malloc(2*s->Ncvec * sizeof(v4sf));
+  s->data = (v4sf*)((char*)s + SETUP_HEAD_BYTES);
   s->e = (float*)s->data;
-  s->twiddle = (float*)(s->data + (2*s->Ncvec*(SIMD_SZ-1))/SIMD_SZ);
+  s->twiddle = (float*)(s->data + setup_e_vectors(s->Ncvec));
+  s->btwiddle = 0;
+  /* small sizes can also be batched one signal per lane, at full length */
+  if (SIMD_SZ > 1 && N <= PFFFT_BATCH_MAX_N) {
+    s->btwiddle = s->twiddle + 2*s->Ncvec;
+  }
 
+  if (tables) {
+    /* only the factors to work out, the twiddles are copied */
+    memcpy(s->data, tables, setup_table_floats(N, transform)*sizeof(float));
+    decompose(N/SIMD_SZ, s->ifac, transform == PFFFT_REAL ? rffti_ntryh : cffti_ntryh);
+    if (s->btwiddle) {
+      decompose(N, s->bifac, transform == PFFFT_REAL ? rffti_ntryh : cffti_ntryh);
+    }
+    return s;
+  }
+
+  /* not every twiddle slot is used, keep the tables reproducible */
+  memset(s->data, 0, setup_table_floats(N, transform)*sizeof(float));
   for (k=0; k < s->Ncvec; ++k) {
     int i = k/SIMD_SZ;
     int j = k%SIMD_SZ;
+#ifdef TWIDDLE_RECUR
+    if (i % TWIDDLE_RECUR) continue;
+    i /= TWIDDLE_RECUR;
+#endif
     for (m=0; m < SIMD_SZ-1; ++m) {
       float A = -2*M_PI*(m+1)*k / N;
-      s->e[(2*(i*3 + m) + 0) * SIMD_SZ + j] = cos(A);
-      s->e[(2*(i*3 + m) + 1) * SIMD_SZ + j] = sin(A);
+      s->e[(2*(i*(SIMD_SZ-1) + m) + 0) * SIMD_SZ + j] = cos(A);
+      s->e[(2*(i*(SIMD_SZ-1) + m) + 1) * SIMD_SZ + j] = sin(A);
+    }
+  }
+#ifdef TWIDDLE_RECUR
+  /* then the step from one block to the next, the same in every lane */
+  k = setup_e_vectors(s->Ncvec) - 2*(SIMD_SZ-1);
+  for (m=0; m < SIMD_SZ-1; ++m) {
+    double A = -2*M_PI*(m+1)*SIMD_SZ / N;
+    int j;
+    for (j=0; j < SIMD_SZ; ++j) {
+      s->e[(k + 2*m + 0) * SIMD_SZ + j] = cos(A);
+      s->e[(k + 2*m + 1) * SIMD_SZ + j] = sin(A);
     }
   }
+#endif
 
   if (transform == PFFFT_REAL) {
     rffti1_ps(N/SIMD_SZ, s->twiddle, s->ifac);
@@ -1296,23 +1965,93 @@ PFFFT_Setup *pffft_new_setup(int N, pffft_transform_t transform) {
     cffti1_ps(N/SIMD_SZ, s->twiddle, s->ifac);
   }
 
-  /* check that N is decomposable with allowed prime factors */
-  for (k=0, m=1; k < s->ifac[1]; ++k) { m *= s->ifac[2+k]; }
-  if (m != N/SIMD_SZ) {
-    pffft_destroy_setup(s); s = 0;
+  if (s->btwiddle) {
+    if (transform == PFFFT_REAL) {
+      rffti1_ps(N, s->btwiddle, s->bifac);
+    } else {
+      cffti1_ps(N, s->btwiddle, s->bifac);
+    }
+  }
+  return s;
+}
+
+PFFFT_Setup *pffft_new_setup(int N, pffft_transform_t transform) {
+  PFFFT_Setup *s;
+  size_t bytes;
+  void *mem;
+  // validate N for negative values or potential int overflow
+  if (N < 0) {
+    return 0;
   }
+  if (N > (1<<26)) {
+    // higher values of N will make you enter in the integer overflow world...
+    assert(0);
+    return 0;
+  }
+  /* unfortunately, the fft size must be a multiple of 16 for complex FFTs
+     and 32 for real FFTs -- a lot of stuff would need to be rewritten to
+     handle other cases (or maybe just switch to a scalar fft, I don't know..) */
+  if (transform == PFFFT_REAL) { assert((N%(2*SIMD_SZ*SIMD_SZ))==0 && N>0); }
+  if (transform == PFFFT_COMPLEX) { assert((N%(SIMD_SZ*SIMD_SZ))==0 && N>0); }
+  //assert((N % 32) == 0);
 
+  /* also checks that N is decomposable with allowed prime factors */
+  bytes = pffft_setup_bytes(N, transform);
+  if (!bytes) {
+    return 0;
+  }
+  mem = malloc(bytes);
+  if (!mem) {
+    return 0;
+  }
+  s = pffft_new_setup_inplace(mem, bytes, N, transform, 0, 0);
+  s->mem = mem;
   return s;
 }
 
+const float *pffft_setup_tables(PFFFT_Setup *s, int *nfloats) {
+  *nfloats = (int)setup_table_floats(s->N, s->transform);
+  return (const float*)s->data;
+}
+
+int pffft_twiddle_recur(void) {
+#ifdef TWIDDLE_RECUR
+  return TWIDDLE_RECUR;
+#else
+  return 1;
+#endif
+}
 
 void pffft_destroy_setup(PFFFT_Setup *s) {
-  pffft_aligned_free(s->data);
-  free(s);
+  if (s) free(s->mem);
 }
 
 #if !defined(PFFFT_SIMD_DISABLE)
 
+/*
+  the e[] vectors of block k of dk. With PFFFT_TWIDDLE_RECUR they are made
+  in cur, which must come in with block k-1 unless k is an anchor, so the
+  blocks have to be visited in order.
+*/
+static ALWAYS_INLINE(const v4sf *) e_block(const v4sf *e, int k, int dk, v4sf *cur) {
+#ifdef TWIDDLE_RECUR
+  int m;
+  if (k % TWIDDLE_RECUR == 0) {
+    const v4sf *a = e + 2*(SIMD_SZ-1)*(k/TWIDDLE_RECUR);
+    for (m=0; m < 2*(SIMD_SZ-1); ++m) cur[m] = a[m];
+  } else {
+    const v4sf *w = e + 2*(SIMD_SZ-1)*((dk + TWIDDLE_RECUR-1)/TWIDDLE_RECUR);
+    for (m=0; m < SIMD_SZ-1; ++m) VCPLXMUL(cur[2*m], cur[2*m+1], w[2*m], w[2*m+1]);
+  }
+  return cur;
+#else
+  (void)dk; (void)cur;
+  return e + 2*(SIMD_SZ-1)*k;
+#endif
+}
+
+#if SIMD_SZ == 4
+
 /* [0 0 1 2 3 4 5 6 7 8] -> [0 8 7 6 5 4 3 2 1] */
 static void reversed_copy(int N, const v4sf *in, int in_stride, v4sf *out) {
   v4sf g0, g1;
@@ -1388,17 +2127,20 @@ void pffft_cplx_finalize(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e) {
   int k, dk = Ncvec/SIMD_SZ; // number of 4x4 matrix blocks
   v4sf r0, i0, r1, i1, r2, i2, r3, i3;
   v4sf sr0, dr0, sr1, dr1, si0, di0, si1, di1;
+  v4sf ecur[6];
+  const v4sf *ek;
   assert(in != out);
   for (k=0; k < dk; ++k) {
+    ek = e_block(e, k, dk, ecur);
     r0 = in[8*k+0]; i0 = in[8*k+1];
     r1 = in[8*k+2]; i1 = in[8*k+3];
     r2 = in[8*k+4]; i2 = in[8*k+5];
     r3 = in[8*k+6]; i3 = in[8*k+7];
     VTRANSPOSE4(r0,r1,r2,r3);
     VTRANSPOSE4(i0,i1,i2,i3);
-    VCPLXMUL(r1,i1,e[k*6+0],e[k*6+1]);
-    VCPLXMUL(r2,i2,e[k*6+2],e[k*6+3]);
-    VCPLXMUL(r3,i3,e[k*6+4],e[k*6+5]);
+    VCPLXMUL(r1,i1,ek[0],ek[1]);
+    VCPLXMUL(r2,i2,ek[2],ek[3]);
+    VCPLXMUL(r3,i3,ek[4],ek[5]);
 
     sr0 = VADD(r0,r2); dr0 = VSUB(r0, r2);
     sr1 = VADD(r1,r3); dr1 = VSUB(r1, r3);
@@ -1432,8 +2174,11 @@ void pffft_cplx_preprocess(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e)
   int k, dk = Ncvec/SIMD_SZ; // number of 4x4 matrix blocks
   v4sf r0, i0, r1, i1, r2, i2, r3, i3;
   v4sf sr0, dr0, sr1, dr1, si0, di0, si1, di1;
+  v4sf ecur[6];
+  const v4sf *ek;
   assert(in != out);
   for (k=0; k < dk; ++k) {
+    ek = e_block(e, k, dk, ecur);
     r0 = in[8*k+0]; i0 = in[8*k+1];
     r1 = in[8*k+2]; i1 = in[8*k+3];
     r2 = in[8*k+4]; i2 = in[8*k+5];
@@ -1449,9 +2194,9 @@ void pffft_cplx_preprocess(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e)
     r2 = VSUB(sr0, sr1); i2 = VSUB(si0, si1);
     r3 = VADD(dr0, di1); i3 = VSUB(di0, dr1);
 
-    VCPLXMULCONJ(r1,i1,e[k*6+0],e[k*6+1]);
-    VCPLXMULCONJ(r2,i2,e[k*6+2],e[k*6+3]);
-    VCPLXMULCONJ(r3,i3,e[k*6+4],e[k*6+5]);
+    VCPLXMULCONJ(r1,i1,ek[0],ek[1]);
+    VCPLXMULCONJ(r2,i2,ek[2],ek[3]);
+    VCPLXMULCONJ(r3,i3,ek[4],ek[5]);
 
     VTRANSPOSE4(r0,r1,r2,r3);
     VTRANSPOSE4(i0,i1,i2,i3);
@@ -1527,10 +2272,11 @@ static NEVER_INLINE(void) pffft_real_finalize(int Ncvec, const v4sf *in, v4sf *o
   v4sf save = in[7], zero=VZERO();
   float xr0, xi0, xr1, xi1, xr2, xi2, xr3, xi3;
   static const float s = (float)(M_SQRT1_2);
+  v4sf ecur[6];
 
   cr.v = in[0]; ci.v = in[Ncvec*2-1];
   assert(in != out);
-  pffft_real_finalize_4x4(&zero, &zero, in+1, e, out);
+  pffft_real_finalize_4x4(&zero, &zero, in+1, e_block(e, 0, dk, ecur), out);
 
   /*
     [cr0 cr1 cr2 cr3 ci0 ci1 ci2 ci3]
@@ -1557,7 +2303,7 @@ static NEVER_INLINE(void) pffft_real_finalize(int Ncvec, const v4sf *in, v4sf *o
   for (k=1; k < dk; ++k) {
     v4sf save_next = in[8*k+7];
     pffft_real_finalize_4x4(&save, &in[8*k+0], in + 8*k+1,
-                            e + k*6, out + k*8);
+                            e_block(e, k, dk, ecur), out + k*8);
     save = save_next;
   }
 
@@ -1619,13 +2365,14 @@ static NEVER_INLINE(void) pffft_real_preprocess(int Ncvec, const v4sf *in, v4sf
   v4sf_union Xr, Xi, *uout = (v4sf_union*)out;
   float cr0, ci0, cr1, ci1, cr2, ci2, cr3, ci3;
   static const float s = (float)M_SQRT2;
+  v4sf ecur[6];
   assert(in != out);
   for (k=0; k < 4; ++k) {
     Xr.f[k] = ((float*)in)[8*k];
     Xi.f[k] = ((float*)in)[8*k+4];
   }
 
-  pffft_real_preprocess_4x4(in, e, out+1, 1); // will write only 6 values
+  pffft_real_preprocess_4x4(in, e_block(e, 0, dk, ecur), out+1, 1); // will write only 6 values
 
   /*
     [Xr0 Xr1 Xr2 Xr3 Xi0 Xi1 Xi2 Xi3]
@@ -1640,7 +2387,7 @@ static NEVER_INLINE(void) pffft_real_preprocess(int Ncvec, const v4sf *in, v4sf
     [ci3] [0  -s   0   s   0  -s   0  -s]
   */
   for (k=1; k < dk; ++k) {
-    pffft_real_preprocess_4x4(in+8*k, e + k*6, out-1+k*8, 0);
+    pffft_real_preprocess_4x4(in+8*k, e_block(e, k, dk, ecur), out-1+k*8, 0);
   }
 
   cr0=(Xr.f[0]+Xi.f[0]) + 2*Xr.f[2]; uout[0].f[0] = cr0;
@@ -1653,6 +2400,278 @@ static NEVER_INLINE(void) pffft_real_preprocess(int Ncvec, const v4sf *in, v4sf
   ci3=-s*(Xr.f[1]-Xr.f[3]) - s*(Xi.f[1]+Xi.f[3]); uout[2*Ncvec-1].f[3] = ci3;
 }
 
+#else // SIMD_SZ != 4
+/*
+  Generic versions of the reorder / finalize / preprocess steps for the
+  other widths, 2 (pffftd) or 8 and 16. Each block of SIMD_SZ complex vectors is transposed, twiddled and
+  put through a SIMD_SZ point DFT across the vectors, so nothing depends on
+  the width. With L = N/SIMD_SZ:
+
+  complex: lane l of vector q in block k is bin k*SIMD_SZ + l + q*L
+
+  real: the same for q < SIMD_SZ/2, the upper vectors hold the conjugates
+  of bins L*(SIMD_SZ-q) - k*SIMD_SZ - l instead, which keeps the
+  products in pffft_zconvolve_accumulate consistent. Lane 0 of block 0 gets
+  the bins where the lane spectra are purely real: vector 0 has DC and
+  Nyquist as in the 4-wide layout, vectors 1..SIMD_SZ/2-1 have bins q*L and
+  the upper half bins L/2 + (q-SIMD_SZ/2)*L.
+*/
+
+/* cos(2*pi*t/32), enough for the DFT twiddles up to SIMD_SZ 16, in double for pffftd */
+static const float wide_cos[32] = {
+   1.000000000000000000,  0.980785280403230449,  0.923879532511286756,  0.831469612302545237,
+   0.707106781186547524,  0.555570233019602225,  0.382683432365089772,  0.195090322016128268,
+   0.000000000000000000, -0.195090322016128268, -0.382683432365089772, -0.555570233019602225,
+  -0.707106781186547524, -0.831469612302545237, -0.923879532511286756, -0.980785280403230449,
+  -1.000000000000000000, -0.980785280403230449, -0.923879532511286756, -0.831469612302545237,
+  -0.707106781186547524, -0.555570233019602225, -0.382683432365089772, -0.195090322016128268,
+   0.000000000000000000,  0.195090322016128268,  0.382683432365089772,  0.555570233019602225,
+   0.707106781186547524,  0.831469612302545237,  0.923879532511286756,  0.980785280403230449
+};
+/* cos / sin of 2*pi*t/(2*SIMD_SZ) */
+#define WIDE_COS(t) wide_cos[((t)*(16/SIMD_SZ)) & 31]
+#define WIDE_SIN(t) wide_cos[((t)*(16/SIMD_SZ) + 24) & 31]
+
+/* 4 bit reversal, shifted down for fewer bits */
+static const unsigned char wide_rev[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+/* in place SIMD_SZ point DFT across the vectors, isign = -1 forward, +1 backward */
+static ALWAYS_INLINE(void) vdft(v4sf *re, v4sf *im, int isign) {
+  int len, i, p;
+  v4sf t, xr[SIMD_SZ], xi[SIMD_SZ];
+
+  /* radix-2 decimation in time, inputs in bit reversed order */
+  UNROLL_FULL
+  for (i=0; i < SIMD_SZ; ++i) {
+    xr[i] = re[wide_rev[i]/(16/SIMD_SZ)];
+    xi[i] = im[wide_rev[i]/(16/SIMD_SZ)];
+  }
+  UNROLL_FULL
+  for (i=0; i < SIMD_SZ; ++i) { re[i] = xr[i]; im[i] = xi[i]; }
+  UNROLL_FULL
+  for (len=2; len <= SIMD_SZ; len *= 2) {
+    UNROLL_FULL
+    for (i=0; i < SIMD_SZ; i += len) {
+      UNROLL_FULL
+      for (p=0; p < len/2; ++p) {
+        v4sf ar = re[i+p], ai = im[i+p];
+        v4sf br = re[i+p+len/2], bi = im[i+p+len/2];
+        if (4*p == len) {
+          /* twiddle is -i forward, +i backward */
+          t = br;
+          if (isign < 0) { br = bi; bi = VSUB(VZERO(), t); }
+          else { br = VSUB(VZERO(), bi); bi = t; }
+        } else if (p) {
+          int tw = p*2*SIMD_SZ/len;
+          v4sf wr = LD_PS1(WIDE_COS(tw)), wi = LD_PS1(isign*WIDE_SIN(tw));
+          VCPLXMUL(br, bi, wr, wi);
+        }
+        re[i+p] = VADD(ar, br); im[i+p] = VADD(ai, bi);
+        re[i+p+len/2] = VSUB(ar, br); im[i+p+len/2] = VSUB(ai, bi);
+      }
+    }
+  }
+}
+
+void pffft_zreorder(PFFFT_Setup *setup, const float *in, float *out, pffft_direction_t direction) {
+  int k, N = setup->N, Ncvec = setup->Ncvec;
+  const v4sf *vin = (const v4sf*)in;
+  v4sf *vout = (v4sf*)out;
+  assert(in != out);
+  if (setup->transform == PFFFT_REAL) {
+    int q, l, b, dk = Ncvec/SIMD_SZ, L = N/SIMD_SZ;
+    if (direction == PFFFT_FORWARD) {
+      for (k=0; k < dk; ++k) {
+        for (q=0; q < SIMD_SZ/2; ++q) {
+          b = 2*(k + q*(L/SIMD_SZ));
+          INTERLEAVE2(vin[2*(k*SIMD_SZ + q)], vin[2*(k*SIMD_SZ + q) + 1], vout[b], vout[b+1]);
+        }
+        for (q=SIMD_SZ/2; q < SIMD_SZ; ++q) {
+          const float *zr = in + 2*(k*SIMD_SZ + q)*SIMD_SZ, *zi = zr + SIMD_SZ;
+          for (l=(k ? 0 : 1); l < SIMD_SZ; ++l) {
+            b = L*(SIMD_SZ-q) - k*SIMD_SZ - l;
+            out[2*b] = zr[l]; out[2*b+1] = -zi[l];
+          }
+        }
+      }
+      for (q=0; q < SIMD_SZ/2; ++q) {
+        b = L/2 + q*L;
+        out[2*b] = in[(SIMD_SZ + 2*q)*SIMD_SZ];
+        out[2*b+1] = in[(SIMD_SZ + 2*q + 1)*SIMD_SZ];
+      }
+    } else {
+      for (k=0; k < dk; ++k) {
+        for (q=0; q < SIMD_SZ/2; ++q) {
+          b = 2*(k + q*(L/SIMD_SZ));
+          UNINTERLEAVE2(vin[b], vin[b+1], vout[2*(k*SIMD_SZ + q)], vout[2*(k*SIMD_SZ + q) + 1]);
+        }
+        for (q=SIMD_SZ/2; q < SIMD_SZ; ++q) {
+          float *zr = out + 2*(k*SIMD_SZ + q)*SIMD_SZ, *zi = zr + SIMD_SZ;
+          for (l=(k ? 0 : 1); l < SIMD_SZ; ++l) {
+            b = L*(SIMD_SZ-q) - k*SIMD_SZ - l;
+            zr[l] = in[2*b]; zi[l] = -in[2*b+1];
+          }
+        }
+      }
+      for (q=0; q < SIMD_SZ/2; ++q) {
+        b = L/2 + q*L;
+        out[(SIMD_SZ + 2*q)*SIMD_SZ] = in[2*b];
+        out[(SIMD_SZ + 2*q + 1)*SIMD_SZ] = in[2*b+1];
+      }
+    }
+  } else {
+    if (direction == PFFFT_FORWARD) {
+      for (k=0; k < Ncvec; ++k) {
+        int kk = (k/SIMD_SZ) + (k%SIMD_SZ)*(Ncvec/SIMD_SZ);
+        INTERLEAVE2(vin[k*2], vin[k*2+1], vout[kk*2], vout[kk*2+1]);
+      }
+    } else {
+      for (k=0; k < Ncvec; ++k) {
+        int kk = (k/SIMD_SZ) + (k%SIMD_SZ)*(Ncvec/SIMD_SZ);
+        UNINTERLEAVE2(vin[kk*2], vin[kk*2+1], vout[k*2], vout[k*2+1]);
+      }
+    }
+  }
+}
+
+void pffft_cplx_finalize(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e) {
+  int k, j, dk = Ncvec/SIMD_SZ; // number of SIMD_SZ x SIMD_SZ blocks
+  v4sf r[SIMD_SZ], i[SIMD_SZ], ecur[2*(SIMD_SZ-1)] = { VZERO() }; // set by e_block
+  const v4sf *ek;
+  assert(in != out);
+  for (k=0; k < dk; ++k) {
+    ek = e_block(e, k, dk, ecur);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) { r[j] = in[2*j]; i[j] = in[2*j+1]; }
+    vtranspose(r);
+    vtranspose(i);
+    UNROLL_FULL
+    for (j=1; j < SIMD_SZ; ++j) VCPLXMUL(r[j], i[j], ek[2*j-2], ek[2*j-1]);
+    vdft(r, i, -1);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) { out[2*j] = r[j]; out[2*j+1] = i[j]; }
+    in += 2*SIMD_SZ; out += 2*SIMD_SZ;
+  }
+}
+
+void pffft_cplx_preprocess(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e) {
+  int k, j, dk = Ncvec/SIMD_SZ; // number of SIMD_SZ x SIMD_SZ blocks
+  v4sf r[SIMD_SZ], i[SIMD_SZ], ecur[2*(SIMD_SZ-1)] = { VZERO() }; // set by e_block
+  const v4sf *ek;
+  assert(in != out);
+  for (k=0; k < dk; ++k) {
+    ek = e_block(e, k, dk, ecur);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) { r[j] = in[2*j]; i[j] = in[2*j+1]; }
+    vdft(r, i, +1);
+    UNROLL_FULL
+    for (j=1; j < SIMD_SZ; ++j) VCPLXMULCONJ(r[j], i[j], ek[2*j-2], ek[2*j-1]);
+    vtranspose(r);
+    vtranspose(i);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) { out[2*j] = r[j]; out[2*j+1] = i[j]; }
+    in += 2*SIMD_SZ; out += 2*SIMD_SZ;
+  }
+}
+
+static NEVER_INLINE(void) pffft_real_finalize(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e) {
+  int k, j, q, m, dk = Ncvec/SIMD_SZ; // number of SIMD_SZ x SIMD_SZ blocks
+  /* fftpack order is f0r f1r f1i f2r f2i ... f(n-1)r f(n-1)i f(n)r */
+  v4sf r[SIMD_SZ], i[SIMD_SZ], ecur[2*(SIMD_SZ-1)] = { VZERO() }; // set by e_block
+  const v4sf *ek;
+  v4sf_union y0, yh, *uout = (v4sf_union*)out;
+  float xr, xi;
+  assert(in != out);
+
+  y0.v = in[0]; yh.v = in[2*Ncvec-1];
+  for (k=0; k < dk; ++k) {
+    ek = e_block(e, k, dk, ecur);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) {
+      m = k*SIMD_SZ + j;
+      r[j] = m ? in[2*m-1] : VZERO();
+      i[j] = m ? in[2*m] : VZERO();
+    }
+    vtranspose(r);
+    vtranspose(i);
+    UNROLL_FULL
+    for (j=1; j < SIMD_SZ; ++j) VCPLXMUL(r[j], i[j], ek[2*j-2], ek[2*j-1]);
+    vdft(r, i, -1);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) { out[2*j] = r[j]; out[2*j+1] = i[j]; }
+    out += 2*SIMD_SZ;
+  }
+
+  /* lane 0 of block 0 from the real f0 and f(n) of each lane */
+  for (q=0; q <= SIMD_SZ/2; ++q) {
+    xr = xi = 0;
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) {
+      xr += y0.f[j]*WIDE_COS(2*j*q);
+      xi -= y0.f[j]*WIDE_SIN(2*j*q);
+    }
+    if (q == 0) uout[0].f[0] = xr;
+    else if (q == SIMD_SZ/2) uout[1].f[0] = xr;
+    else { uout[2*q].f[0] = xr; uout[2*q+1].f[0] = xi; }
+  }
+  for (q=0; q < SIMD_SZ/2; ++q) {
+    xr = xi = 0;
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) {
+      xr += yh.f[j]*WIDE_COS(j*(2*q+1));
+      xi -= yh.f[j]*WIDE_SIN(j*(2*q+1));
+    }
+    uout[SIMD_SZ + 2*q].f[0] = xr; uout[SIMD_SZ + 2*q + 1].f[0] = xi;
+  }
+}
+
+static NEVER_INLINE(void) pffft_real_preprocess(int Ncvec, const v4sf *in, v4sf *out, const v4sf *e) {
+  int k, j, q, m, dk = Ncvec/SIMD_SZ; // number of SIMD_SZ x SIMD_SZ blocks
+  /* fftpack order is f0r f1r f1i f2r f2i ... f(n-1)r f(n-1)i f(n)r */
+  v4sf r[SIMD_SZ], i[SIMD_SZ], ecur[2*(SIMD_SZ-1)] = { VZERO() }; // set by e_block
+  const v4sf *ek;
+  const v4sf_union *uin = (const v4sf_union*)in;
+  v4sf_union y0, yh;
+  float t;
+  assert(in != out);
+
+  /* the real f0 and f(n) of each lane from lane 0 of block 0 */
+  UNROLL_FULL
+  for (j=0; j < SIMD_SZ; ++j) {
+    t = uin[0].f[0] + ((j & 1) ? -uin[1].f[0] : uin[1].f[0]);
+    for (q=1; q < SIMD_SZ/2; ++q) {
+      t += 2*(uin[2*q].f[0]*WIDE_COS(2*j*q) - uin[2*q+1].f[0]*WIDE_SIN(2*j*q));
+    }
+    y0.f[j] = t;
+    t = 0;
+    for (q=0; q < SIMD_SZ/2; ++q) {
+      t += 2*(uin[SIMD_SZ + 2*q].f[0]*WIDE_COS(j*(2*q+1))
+              - uin[SIMD_SZ + 2*q + 1].f[0]*WIDE_SIN(j*(2*q+1)));
+    }
+    yh.f[j] = t;
+  }
+
+  for (k=0; k < dk; ++k) {
+    ek = e_block(e, k, dk, ecur);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) { r[j] = in[2*j]; i[j] = in[2*j+1]; }
+    vdft(r, i, +1);
+    UNROLL_FULL
+    for (j=1; j < SIMD_SZ; ++j) VCPLXMULCONJ(r[j], i[j], ek[2*j-2], ek[2*j-1]);
+    vtranspose(r);
+    vtranspose(i);
+    UNROLL_FULL
+    for (j=0; j < SIMD_SZ; ++j) {
+      m = k*SIMD_SZ + j;
+      if (m) { out[2*m-1] = r[j]; out[2*m] = i[j]; }
+    }
+    in += 2*SIMD_SZ;
+  }
+  out[0] = y0.v;
+  out[2*Ncvec-1] = yh.v;
+}
+#endif // SIMD_SZ != 4
+
 
 void pffft_transform_internal(PFFFT_Setup *setup, const float *finput, float *foutput, v4sf *scratch,
                               pffft_direction_t direction, int ordered) {
@@ -1818,6 +2837,122 @@ void pffft_zconvolve_accumulate(PFFFT_Setup *s, const float *a, const float *b,
   }
 }
 
+/*
+  the sum of n products in one pass: each output vector is accumulated in
+  registers over all the pairs and stored once, instead of n read-modify-
+  write passes over dft_ab. The real and imaginary parts each get two
+  multiply-add chains so they map onto fused multiply-adds.
+*/
+void pffft_zconvolve_sum(PFFFT_Setup *s, int n, const float **a, const float **b, float *ab, float scaling) {
+  int i, k, Ncvec = s->Ncvec;
+  v4sf * RESTRICT vab = (v4sf*)ab;
+  v4sf vscal = LD_PS1(scaling);
+  float dc = 0, ny = 0;
+
+  assert(VALIGNED(ab));
+  if (s->transform == PFFFT_REAL) {
+    for (k=0; k < n; ++k) {
+      dc += a[k][0]*b[k][0];
+      ny += a[k][SIMD_SZ]*b[k][SIMD_SZ];
+    }
+  }
+  for (i=0; i < Ncvec; ++i) {
+    v4sf rr = VZERO(), ii = VZERO(), ri = VZERO(), ir = VZERO();
+    for (k=0; k < n; ++k) {
+      const v4sf *va = (const v4sf*)a[k] + 2*i, *vb = (const v4sf*)b[k] + 2*i;
+      rr = VMADD(va[0], vb[0], rr);
+      ii = VMADD(va[1], vb[1], ii);
+      ri = VMADD(va[0], vb[1], ri);
+      ir = VMADD(va[1], vb[0], ir);
+    }
+    vab[2*i+0] = VMUL(VSUB(rr, ii), vscal);
+    vab[2*i+1] = VMUL(VADD(ri, ir), vscal);
+  }
+  if (s->transform == PFFFT_REAL) {
+    ((v4sf_union*)vab)[0].f[0] = dc*scaling;
+    ((v4sf_union*)vab)[1].f[0] = ny*scaling;
+  }
+}
+
+
+/*
+  pffft_transform_batch for small N: each group of SIMD_SZ signals is
+  transposed so lane j holds signal j, run through the fftpack passes at the
+  full length N and transposed back. That skips the finalize and reorder
+  steps which are most of the cost of a tiny transform. fftpack's real
+  layout has f(n/2) at the end, so real spectra go through a staging copy.
+*/
+static void pffft_transform_batch_lanes(PFFFT_Setup *setup, int M, const float **input,
+                                        float **output, float *work, pffft_direction_t direction) {
+  int N = setup->N, cplx = (setup->transform == PFFFT_COMPLEX);
+  int Nf = cplx ? 2*N : N; // floats per signal, also vectors per group
+  int g, j, k, t, c;
+
+  // temporary buffers are allocated on the stack if the work pointer is NULL
+  int stack_allocate = (work == 0 ? 2*Nf : 1);
+  VLA_ARRAY_ON_STACK(v4sf, work_on_stack, stack_allocate);
+  v4sf *b0 = work ? (v4sf*)work : work_on_stack, *b1 = b0 + Nf, *res, *tmp;
+
+  assert(VALIGNED(b0));
+  for (g=0; g < M; g += SIMD_SZ) {
+    const float *src[SIMD_SZ];
+    float *dst[SIMD_SZ];
+    c = (M - g < SIMD_SZ ? M - g : SIMD_SZ);
+    for (j=0; j < SIMD_SZ; ++j) {
+      src[j] = (j < c ? input[g+j] : 0);
+      dst[j] = (j < c ? output[g+j] : 0);
+      assert(!src[j] || (VALIGNED(src[j]) && VALIGNED(dst[j])));
+    }
+
+    /* back to fftpack order for real inverse transforms, staged in b1 */
+    if (!cplx && direction == PFFFT_BACKWARD) {
+      for (j=0; j < c; ++j) {
+        float *h = (float*)b1 + j*N;
+        h[0] = src[j][0];
+        memcpy(h+1, src[j]+2, (N-2)*sizeof(float));
+        h[N-1] = src[j][1];
+        src[j] = h;
+      }
+    }
+
+    /* lane j of b0[k] is float k of signal j */
+    for (k=0; k < Nf; k += SIMD_SZ) {
+      v4sf x[SIMD_SZ];
+      for (j=0; j < SIMD_SZ; ++j) x[j] = src[j] ? *(const v4sf*)(src[j] + k) : VZERO();
+      vtranspose(x);
+      for (t=0; t < SIMD_SZ; ++t) b0[k+t] = x[t];
+    }
+
+    if (cplx) {
+      res = cfftf1_ps(N, b0, b0, b1, setup->btwiddle, setup->bifac,
+                      direction == PFFFT_FORWARD ? -1 : +1);
+    } else if (direction == PFFFT_FORWARD) {
+      res = rfftf1_ps(N, b0, b0, b1, setup->btwiddle, setup->bifac);
+    } else {
+      res = rfftb1_ps(N, b0, b0, b1, setup->btwiddle, setup->bifac);
+    }
+    tmp = (res == b0 ? b1 : b0);
+
+    /* real forward spectra are staged in tmp, everything else goes straight out */
+    if (!cplx && direction == PFFFT_FORWARD) {
+      for (j=0; j < c; ++j) dst[j] = (float*)tmp + j*N;
+    }
+    for (k=0; k < Nf; k += SIMD_SZ) {
+      v4sf x[SIMD_SZ];
+      for (t=0; t < SIMD_SZ; ++t) x[t] = res[k+t];
+      vtranspose(x);
+      for (j=0; j < c; ++j) *(v4sf*)(dst[j] + k) = x[j];
+    }
+    if (!cplx && direction == PFFFT_FORWARD) {
+      for (j=0; j < c; ++j) {
+        float *o = output[g+j];
+        o[0] = dst[j][0];
+        o[1] = dst[j][N-1];
+        memcpy(o+2, dst[j]+1, (N-2)*sizeof(float));
+      }
+    }
+  }
+}
 
 #else // defined(PFFFT_SIMD_DISABLE)
 
@@ -1921,6 +3056,17 @@ void pffft_zconvolve_accumulate_nosimd(PFFFT_Setup *s, const float *a, const flo
   }
 }
 
+#define pffft_zconvolve_sum_nosimd pffft_zconvolve_sum
+void pffft_zconvolve_sum_nosimd(PFFFT_Setup *s, int n, const float **a, const float **b,
+                                float *ab, float scaling) {
+  int i, k, Nf = 2*s->Ncvec;
+
+  for (i=0; i < Nf; ++i) ab[i] = 0;
+  for (k=0; k < n; ++k) {
+    pffft_zconvolve_accumulate_nosimd(s, a[k], b[k], ab, scaling);
+  }
+}
+
 #endif // defined(PFFFT_SIMD_DISABLE)
 
 void pffft_transform(PFFFT_Setup *setup, const float *input, float *output, float *work, pffft_direction_t direction) {
@@ -1930,3 +3076,17 @@ void pffft_transform(PFFFT_Setup *setup, const float *input, float *output, floa
 void pffft_transform_ordered(PFFFT_Setup *setup, const float *input, float *output, float *work, pffft_direction_t direction) {
   pffft_transform_internal(setup, input, output, (v4sf*)work, direction, 1);
 }
+
+void pffft_transform_batch(PFFFT_Setup *setup, int M, const float **input, float **output,
+                           float *work, pffft_direction_t direction) {
+  int m;
+#if !defined(PFFFT_SIMD_DISABLE)
+  if (setup->btwiddle) {
+    pffft_transform_batch_lanes(setup, M, input, output, work, direction);
+    return;
+  }
+#endif
+  for (m=0; m < M; ++m) {
+    pffft_transform_ordered(setup, input[m], output[m], work, direction);
+  }
+}
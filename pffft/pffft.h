@@ -57,12 +57,13 @@
 
   Restrictions:
 
-  - 1D transforms only, with 32-bit single precision.
+  - 1D transforms only, with 32-bit single precision (pffftd.h has
+  the same in double precision).
 
   - supports only transforms for inputs of length N of the form
   N=(2^a)*(3^b)*(5^c), a >= 5, b >=0, c >= 0 (32, 48, 64, 96, 128,
   144, 160, etc are all acceptable lengths). Performance is best for
-  128<=N<=8192.
+  128<=N<=8192, see pffft_large.h for much larger transforms.
 
   - all (float*) pointers in the functions below are expected to
   have an "simd-compatible" alignment, that is 16 bytes on x86 and
@@ -103,9 +104,44 @@ extern "C" {
 
     Will return NULL if N is not suitable (too large / no decomposable with simple integer
     factors..)
+
+    N must also be a multiple of pffft_min_fft_size(transform), which
+    depends on the vector width: SIMD_SZ*SIMD_SZ for complex transforms and
+    2*SIMD_SZ*SIMD_SZ for real ones, i.e. 16 / 32 with 4-float vectors, 64 /
+    128 with 8 and 256 / 512 with 16.
   */
   PFFFT_Setup *pffft_new_setup(int N, pffft_transform_t transform);
   void pffft_destroy_setup(PFFFT_Setup *);
+
+  /**
+    Bytes of memory a setup of size N takes, for pffft_new_setup_inplace.
+    0 if N is not a valid size. Never allocates.
+  */
+  size_t pffft_setup_bytes(int N, pffft_transform_t transform);
+
+  /**
+    pffft_new_setup in memory given by the caller, e.g. a block reserved up
+    front for real-time code. mem needs no particular alignment but must
+    hold pffft_setup_bytes(N, transform) bytes. Returns NULL if it doesn't
+    or N is not valid.
+
+    With tables NULL the twiddles are computed as by pffft_new_setup. Else
+    tables and nfloats must come from pffft_setup_tables of a setup of the
+    same N and transform, made by a build with the same pffft_simd_size()
+    and pffft_twiddle_recur(); they are copied, so there is no trig and no
+    allocation at all. NULL is returned if nfloats is not the table size
+    this build expects for N, but tables of a build with another
+    PFFFT_TWIDDLE_RECUR can have the right size and the wrong layout, so
+    check pffft_twiddle_recur() before using stored tables.
+
+    pffft_destroy_setup does nothing on such a setup, the memory simply
+    belongs to the caller.
+  */
+  PFFFT_Setup *pffft_new_setup_inplace(void *mem, size_t bytes, int N, pffft_transform_t transform,
+                                       const float *tables, int nfloats);
+
+  /** the twiddle tables of a setup, nfloats long, for pffft_new_setup_inplace */
+  const float *pffft_setup_tables(PFFFT_Setup *setup, int *nfloats);
   /**
     Perform a Fourier transform , The z-domain data is stored in the
     most efficient order for transforming it back, or using it for
@@ -135,6 +171,23 @@ extern "C" {
   */
   void pffft_transform_ordered(PFFFT_Setup *setup, const float *input, float *output, float *work, pffft_direction_t direction);
 
+  /**
+    Perform M transforms of the same setup in one call, input[m] ->
+    output[m], with the output ordered as for pffft_transform_ordered.
+
+    For N up to 256 the signals are processed SIMD_SZ at a time, one
+    signal per simd lane, which is a lot quicker than a loop over
+    pffft_transform_ordered for small N. Larger N falls back to that loop.
+
+    The 'work' pointer should point to an area of 2*pffft_simd_size()
+    times N (2*N for complex fft) floats, properly aligned, or be NULL to
+    use the stack.
+
+    input[m] and output[m] may alias.
+  */
+  void pffft_transform_batch(PFFFT_Setup *setup, int M, const float **input, float **output,
+                             float *work, pffft_direction_t direction);
+
   /**
     call pffft_zreorder(.., PFFFT_FORWARD) after pffft_transform(...,
     PFFFT_FORWARD) if you want to have the frequency components in
@@ -163,6 +216,18 @@ extern "C" {
   */
   void pffft_zconvolve_accumulate(PFFFT_Setup *setup, const float *dft_a, const float *dft_b, float *dft_ab, float scaling);
 
+  /**
+    Sum of n products of frequency components, same layout rules as
+    pffft_zconvolve_accumulate:
+
+    dft_ab = scaling * (dft_a[0]*dft_b[0] + ... + dft_a[n-1]*dft_b[n-1])
+
+    dft_ab is overwritten, and is only written once per element, which
+    makes this a lot quicker than n calls of pffft_zconvolve_accumulate for
+    partitioned convolution. dft_ab should not alias the inputs.
+  */
+  void pffft_zconvolve_sum(PFFFT_Setup *setup, int n, const float **dft_a, const float **dft_b, float *dft_ab, float scaling);
+
   /**
     the float buffers must have the correct alignment (16-byte boundary
     on intel and powerpc). This function may be used to obtain such
@@ -171,9 +236,16 @@ extern "C" {
   void *pffft_aligned_malloc(size_t nb_bytes);
   void pffft_aligned_free(void *);
 
-  /** return 4 or 1 wether support SSE/Altivec instructions was enable when building pffft.c */
+  /** return 4 or 1 wether support SSE/Altivec instructions was enable when building pffft.c
+      (8 or 16 for the wide vector extension builds) */
   int pffft_simd_size(void);
 
+  /** PFFFT_TWIDDLE_RECUR of the build, 1 without, as it changes the setup tables */
+  int pffft_twiddle_recur(void);
+
+  /** smallest N accepted by pffft_new_setup, valid sizes are multiples of it */
+  int pffft_min_fft_size(pffft_transform_t transform);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,155 @@
+/*
+  pffft_cache : process-wide cache of pffft setups.
+
+  Entries are only added, under a lock, and the entry count is published
+  with release ordering after the entry is complete. Lookups scan the
+  entries below the count they read, so they need no lock and never
+  block behind a setup being made.
+*/
+
+#include "pffft.h"
+#include "pffft_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#ifndef PFFFT_CACHE_MAX
+#define PFFFT_CACHE_MAX 32
+#endif
+
+typedef struct {
+  int N;
+  pffft_transform_t transform;
+  PFFFT_Setup *setup;
+  void *mem;            // block of a setup made from pffft_cache_tables
+} cache_entry;
+
+static cache_entry cache[PFFFT_CACHE_MAX];
+static atomic_int cache_count;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+PFFFT_Setup *pffft_cache_find(int N, pffft_transform_t transform) {
+  int i, n = atomic_load_explicit(&cache_count, memory_order_acquire);
+  for (i=0; i < n; ++i) {
+    if (cache[i].N == N && cache[i].transform == transform) return cache[i].setup;
+  }
+  return 0;
+}
+
+/* a new setup for entry e, from the generated tables if they have it */
+static PFFFT_Setup *cache_make(cache_entry *e, int N, pffft_transform_t transform) {
+#ifdef PFFFT_CACHE_TABLES
+  const pffft_cache_table *t;
+  PFFFT_Setup *s;
+  size_t bytes = pffft_setup_bytes(N, transform);
+  for (t = pffft_cache_tables; t->N; ++t) {
+    if (t->N != N || t->transform != transform || t->simd_size != pffft_simd_size() ||
+        t->twiddle_recur != pffft_twiddle_recur()) continue;
+    e->mem = malloc(bytes);
+    if (!e->mem) return 0;
+    s = pffft_new_setup_inplace(e->mem, bytes, N, transform, t->tables, t->nfloats);
+    if (!s) {
+      /* leave the entry empty */
+      free(e->mem);
+      e->mem = 0;
+    }
+    return s;
+  }
+#endif
+  e->mem = 0;
+  return pffft_new_setup(N, transform);
+}
+
+PFFFT_Setup *pffft_cache_get(int N, pffft_transform_t transform) {
+  PFFFT_Setup *s = pffft_cache_find(N, transform);
+  cache_entry *e;
+  int n;
+
+  if (s || !pffft_setup_bytes(N, transform)) return s;
+  pthread_mutex_lock(&cache_lock);
+  /* someone else may have made it meanwhile */
+  s = pffft_cache_find(N, transform);
+  n = atomic_load_explicit(&cache_count, memory_order_relaxed);
+  if (!s && n < PFFFT_CACHE_MAX) {
+    e = &cache[n];
+    s = cache_make(e, N, transform);
+    if (s) {
+      e->N = N;
+      e->transform = transform;
+      e->setup = s;
+      atomic_store_explicit(&cache_count, n + 1, memory_order_release);
+    }
+  }
+  pthread_mutex_unlock(&cache_lock);
+  return s;
+}
+
+int pffft_cache_preload(int N, pffft_transform_t transform) {
+  return pffft_cache_get(N, transform) ? 0 : -1;
+}
+
+PFFFT_Setup *pffft_cache_place(void *mem, size_t bytes, int N, pffft_transform_t transform) {
+  PFFFT_Setup *s = pffft_cache_find(N, transform);
+  const float *tables;
+  int nfloats;
+
+  if (!s) return 0;
+  tables = pffft_setup_tables(s, &nfloats);
+  return pffft_new_setup_inplace(mem, bytes, N, transform, tables, nfloats);
+}
+
+void pffft_cache_clear(void) {
+  int i;
+
+  pthread_mutex_lock(&cache_lock);
+  for (i=0; i < atomic_load(&cache_count); ++i) {
+    pffft_destroy_setup(cache[i].setup);
+    free(cache[i].mem);
+  }
+  atomic_store(&cache_count, 0);
+  pthread_mutex_unlock(&cache_lock);
+}
+
+#ifdef PFFFT_CACHE_GENTAB
+/* pffft_gentab [r|c]N ... : print the pffft_cache_tables[] source for those sizes */
+int main(int argc, char **argv) {
+  const float *tab;
+  int i, k, n, N;
+  pffft_transform_t transform;
+  PFFFT_Setup *s;
+
+  printf("/* generated by pffft_gentab for SIMD_SZ=%d, PFFFT_TWIDDLE_RECUR=%d, do not edit */\n",
+         pffft_simd_size(), pffft_twiddle_recur());
+  printf("#include \"pffft_cache.h\"\n");
+  for (i=1; i < argc; ++i) {
+    transform = argv[i][0] == 'r' ? PFFFT_REAL : PFFFT_COMPLEX;
+    N = atoi(argv[i] + 1);
+    s = pffft_cache_get(N, transform);
+    if (!s) {
+      fprintf(stderr, "invalid size %s\n", argv[i]);
+      return 1;
+    }
+    tab = pffft_setup_tables(s, &n);
+    printf("\nstatic const float tab_%c%d[%d] = {", argv[i][0] == 'r' ? 'r' : 'c', N, n);
+    for (k=0; k < n; ++k) {
+      /* hex floats are exact */
+      printf("%s%af,", k % 4 ? " " : "\n  ", tab[k]);
+    }
+    printf("\n};\n");
+  }
+  printf("\nconst pffft_cache_table pffft_cache_tables[] = {\n");
+  for (i=1; i < argc; ++i) {
+    N = atoi(argv[i] + 1);
+    transform = argv[i][0] == 'r' ? PFFFT_REAL : PFFFT_COMPLEX;
+    pffft_setup_tables(pffft_cache_find(N, transform), &n);
+    printf("  { %d, %s, %d, %d, %d, tab_%c%d },\n", N,
+           transform == PFFFT_REAL ? "PFFFT_REAL" : "PFFFT_COMPLEX", pffft_simd_size(),
+           pffft_twiddle_recur(), n, argv[i][0] == 'r' ? 'r' : 'c', N);
+  }
+  printf("  { 0 }\n};\n");
+  pffft_cache_clear();
+  return 0;
+}
+#endif
@@ -0,0 +1,77 @@
+/*
+  pffft_cache : process-wide cache of pffft setups, keyed by N and
+  transform type.
+
+  pffft_new_setup allocates and computes its twiddles with cos/sin, which
+  is too slow and not safe in code that runs while audio is playing, such
+  as an effect's init during an algorithm switch. Preload the sizes the
+  program needs at start up, then get them with pffft_cache_find, or
+  place a private copy into memory you already own with
+  pffft_cache_place. Neither allocates nor runs trig.
+
+  Built with -DPFFFT_CACHE_TABLES the twiddles of the sizes listed in
+  pffft_cache_tables[] are copied from there instead of computed, so not
+  even start up runs trig for them. That array is generated for a given
+  vector width by building pffft_cache.c on its own as a program:
+
+    gcc -O2 -DPFFFT_CACHE_GENTAB -o pffft_gentab pffft.c pffft_cache.c -lm -lpthread
+    ./pffft_gentab r1024 c512 > pffft_tables.c
+
+  with the same PFFFT_SIMD_* and PFFFT_TWIDDLE_RECUR flags as the target
+  build, and linking pffft_tables.c into the program. Tables from a build
+  with other flags are skipped and the twiddles computed instead. Needs
+  -lpthread.
+*/
+
+#ifndef PFFFT_CACHE_H
+#define PFFFT_CACHE_H
+
+#include "pffft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** precomputed twiddles of one setup, see pffft_setup_tables */
+  typedef struct {
+    int N;
+    pffft_transform_t transform;
+    int simd_size;      // pffft_simd_size() of the build that made it
+    int twiddle_recur;  // and its pffft_twiddle_recur()
+    int nfloats;        // length of tables
+    const float *tables;
+  } pffft_cache_table;
+
+  /** zero terminated, provided by the generated file with PFFFT_CACHE_TABLES */
+  extern const pffft_cache_table pffft_cache_tables[];
+
+  /**
+    The shared setup of size N, made and added to the cache if missing.
+    Returns NULL for invalid sizes or when the cache is full. The setup
+    is read-only and owned by the cache, don't destroy it. Making a setup
+    is not real-time safe, looking one up is.
+  */
+  PFFFT_Setup *pffft_cache_get(int N, pffft_transform_t transform);
+
+  /** same as pffft_cache_get, 0 on success, for start up code */
+  int pffft_cache_preload(int N, pffft_transform_t transform);
+
+  /** the cached setup of size N or NULL, never allocates */
+  PFFFT_Setup *pffft_cache_find(int N, pffft_transform_t transform);
+
+  /**
+    A private setup of size N in mem, copied from the cached one, see
+    pffft_new_setup_inplace. bytes must be at least
+    pffft_setup_bytes(N, transform). Returns NULL if N is not cached.
+    Never allocates nor runs trig.
+  */
+  PFFFT_Setup *pffft_cache_place(void *mem, size_t bytes, int N, pffft_transform_t transform);
+
+  /** free all cached setups, when nothing uses them any more */
+  void pffft_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFT_CACHE_H
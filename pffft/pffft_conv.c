@@ -0,0 +1,288 @@
+/*
+  pffft_conv : non-uniformly partitioned overlap-save convolution.
+
+  Level 0 has blocks of B = block samples and covers the impulse response
+  from 0 to 8B. Level l > 0 has blocks of M = B*4^l and covers 2M to 8M,
+  so its block j, complete once input sample jM+M-1 has arrived, is first
+  needed for output sample jM+2M: the worker has at least M+B samples of
+  time for it. The last level takes whatever is left of the response.
+
+  Every level keeps the spectra of its last P input blocks (the frequency
+  domain delay line) and per block does one forward transform of the last
+  2M input samples, one pffft_zconvolve_sum over the P partitions and one
+  inverse transform, of which the last M samples are valid. Level 0 goes
+  straight to the output block, the other levels write their blocks into
+  their own output ring which the audio thread adds up B samples at a
+  time.
+
+  Input and output rings are powers of two long, so positions can be
+  kept as unsigned sample counts which wrap harmlessly.
+*/
+
+#include "pffft.h"
+#include "pffft_conv.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#define CONV_MAX_LEVELS 16
+
+typedef struct {
+  PFFFT_Setup *setup;
+  int M, P, slot;       // block size, partitions, FDL slot of the next block
+  unsigned off;         // offset of the first partition in the response
+  float *H;             // P partition spectra
+  float *fdl;           // P input spectra, slot is the newest
+  float *tbuf, *work;   // 2M each
+  const float **pa, **pb;
+  float *y;             // output ring
+  unsigned ymask;
+  int cnt;              // B blocks into the current M block (audio thread)
+  atomic_uint posted;   // blocks with their input complete
+  atomic_uint done;     // blocks written to y
+} conv_level;
+
+struct PFFFT_Conv {
+  int B, nlev, pos;
+  float *x;             // input ring
+  unsigned xmask;
+  unsigned long long t; // samples in completed blocks
+  float *yblk;          // output of the last block
+  conv_level lev[CONV_MAX_LEVELS];
+  int threaded;
+  pthread_t thread;
+  sem_t work_sem, done_sem;
+  atomic_int waiting, quit;
+};
+
+static unsigned conv_pow2(unsigned n) {
+  unsigned p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+/* one block of a level, the last M samples of tbuf are the output */
+static float *conv_level_block(PFFFT_Conv *c, conv_level *lv, unsigned pos) {
+  int i, p, s, M = lv->M, P = lv->P;
+  float *spec = lv->fdl + lv->slot*2*M;
+
+  /* the 2M input samples ending at pos+M */
+  for (i=0; i < 2*M; ++i) lv->tbuf[i] = c->x[(pos - M + i) & c->xmask];
+  pffft_transform(lv->setup, lv->tbuf, spec, lv->work, PFFFT_FORWARD);
+  for (p=0, s=lv->slot; p < P; ++p) {
+    lv->pa[p] = lv->fdl + s*2*M;
+    if (--s < 0) s = P - 1;
+  }
+  if (++lv->slot == P) lv->slot = 0;
+  pffft_zconvolve_sum(lv->setup, P, lv->pa, lv->pb, lv->tbuf, 1.f/(2*M));
+  pffft_transform(lv->setup, lv->tbuf, lv->tbuf, lv->work, PFFFT_BACKWARD);
+  return lv->tbuf + M;
+}
+
+static void conv_level_run(PFFFT_Conv *c, conv_level *lv, unsigned j) {
+  unsigned i, pos = j*lv->M + lv->off;
+  float *y = conv_level_block(c, lv, j*lv->M);
+  for (i=0; i < (unsigned)lv->M; ++i) lv->y[(pos + i) & lv->ymask] = y[i];
+}
+
+/* earliest deadline first over the levels with pending blocks */
+static void *conv_worker(void *arg) {
+  PFFFT_Conv *c = (PFFFT_Conv*)arg;
+  conv_level *lv, *best;
+  unsigned j, dl, best_dl = 0;
+  int l;
+
+  for (;;) {
+    sem_wait(&c->work_sem);
+    if (atomic_load(&c->quit)) break;
+    best = 0;
+    for (l=1; l < c->nlev; ++l) {
+      lv = &c->lev[l];
+      j = atomic_load_explicit(&lv->done, memory_order_relaxed);
+      if (atomic_load_explicit(&lv->posted, memory_order_acquire) == j) continue;
+      dl = j*lv->M + lv->off;
+      if (!best || (int)(dl - best_dl) < 0) {
+        best = lv;
+        best_dl = dl;
+      }
+    }
+    if (!best) continue;
+    j = atomic_load_explicit(&best->done, memory_order_relaxed);
+    conv_level_run(c, best, j);
+    atomic_store_explicit(&best->done, j + 1, memory_order_release);
+    if (atomic_exchange(&c->waiting, 0)) sem_post(&c->done_sem);
+  }
+  return 0;
+}
+
+static int conv_level_init(conv_level *lv, const float *ir, int irlen, int B, int M, int off, int end) {
+  int p, i, n, P = (end - off + M - 1)/M;
+  unsigned yn = off ? conv_pow2(4*M + 2*B) : 0;
+  float *mem;
+
+  lv->setup = pffft_new_setup(2*M, PFFFT_REAL);
+  mem = (float*)pffft_aligned_malloc(((size_t)4*P*M + 4*M + yn)*sizeof(float));
+  lv->pa = (const float**)malloc(2*P*sizeof(float*));
+  if (!lv->setup || !mem || !lv->pa) {
+    if (mem) pffft_aligned_free(mem);
+    return -1;
+  }
+  memset(mem, 0, ((size_t)4*P*M + 4*M + yn)*sizeof(float));
+  lv->M = M;
+  lv->P = P;
+  lv->off = off;
+  lv->H = mem;
+  lv->fdl = mem + 2*P*M;
+  lv->tbuf = mem + 4*P*M;
+  lv->work = lv->tbuf + 2*M;
+  lv->y = yn ? lv->work + 2*M : 0;
+  lv->ymask = yn - 1;
+  lv->pb = lv->pa + P;
+
+  /* partition spectra, the second half of each transform is zero padding */
+  for (p=0; p < P; ++p) {
+    n = irlen - (off + p*M);
+    if (n > M) n = M;
+    memset(lv->tbuf, 0, 2*M*sizeof(float));
+    for (i=0; i < n; ++i) lv->tbuf[i] = ir[off + p*M + i];
+    pffft_transform(lv->setup, lv->tbuf, lv->H + p*2*M, lv->work, PFFFT_FORWARD);
+    lv->pb[p] = lv->H + p*2*M;
+  }
+  atomic_init(&lv->posted, 0);
+  atomic_init(&lv->done, 0);
+  return 0;
+}
+
+PFFFT_Conv *pffft_conv_new(const float *ir, int irlen, int block, int threaded) {
+  PFFFT_Conv *c;
+  int M, off, end, mmax = block;
+
+  if (block <= 0 || irlen <= 0 || (2*block) % pffft_min_fft_size(PFFFT_REAL)) {
+    return 0;
+  }
+  c = (PFFFT_Conv*)calloc(1, sizeof(PFFFT_Conv));
+  if (!c) return 0;
+  c->B = block;
+
+  /* level 0 covers [0, 8B), level l [2M, 8M), the last one the rest */
+  for (M=block, off=0; off < irlen; M *= 4, off = 2*M) {
+    end = 8*M;
+    if (4*M > PFFFT_CONV_MAX_BLOCK || c->nlev == CONV_MAX_LEVELS - 1 || end > irlen) {
+      end = irlen;
+    }
+    if (conv_level_init(&c->lev[c->nlev++], ir, irlen, block, M, off, end)) goto fail;
+    mmax = M;
+    if (end == irlen) break;
+  }
+
+  c->xmask = conv_pow2(4*mmax + 2*block) - 1;
+  c->x = (float*)pffft_aligned_malloc((c->xmask + 1 + block)*sizeof(float));
+  if (!c->x) goto fail;
+  memset(c->x, 0, (c->xmask + 1 + block)*sizeof(float));
+  c->yblk = c->x + c->xmask + 1;
+
+  if (threaded && c->nlev > 1) {
+    sem_init(&c->work_sem, 0, 0);
+    sem_init(&c->done_sem, 0, 0);
+    atomic_init(&c->waiting, 0);
+    atomic_init(&c->quit, 0);
+    if (pthread_create(&c->thread, 0, conv_worker, c)) {
+      sem_destroy(&c->work_sem);
+      sem_destroy(&c->done_sem);
+      goto fail;
+    }
+    c->threaded = 1;
+  }
+  return c;
+
+ fail:
+  pffft_conv_destroy(c);
+  return 0;
+}
+
+void pffft_conv_destroy(PFFFT_Conv *c) {
+  int l;
+
+  if (!c) return;
+  if (c->threaded) {
+    atomic_store(&c->quit, 1);
+    sem_post(&c->work_sem);
+    pthread_join(c->thread, 0);
+    sem_destroy(&c->work_sem);
+    sem_destroy(&c->done_sem);
+  }
+  for (l=0; l < c->nlev; ++l) {
+    if (c->lev[l].H) pffft_aligned_free(c->lev[l].H);
+    if (c->lev[l].setup) pffft_destroy_setup(c->lev[l].setup);
+    free((void*)c->lev[l].pa);
+  }
+  if (c->x) pffft_aligned_free(c->x);
+  free(c);
+}
+
+/* wait until level lv has written its output up to sample t+B-1 */
+static void conv_wait(PFFFT_Conv *c, conv_level *lv) {
+  unsigned need;
+
+  if (c->t + c->B <= lv->off) return;
+  need = (unsigned)((c->t + c->B - 1 - lv->off)/lv->M) + 1;
+  while ((int)(atomic_load_explicit(&lv->done, memory_order_acquire) - need) < 0) {
+    atomic_store(&c->waiting, 1);
+    if ((int)(atomic_load(&lv->done) - need) >= 0) break;
+    sem_wait(&c->done_sem);
+  }
+}
+
+/* a complete input block at t - run level 0, post the others and sum */
+static void conv_block(PFFFT_Conv *c) {
+  int i, l, B = c->B;
+  unsigned t = (unsigned)c->t;
+  conv_level *lv;
+  float *y;
+
+  y = conv_level_block(c, &c->lev[0], t);
+  for (i=0; i < B; ++i) c->yblk[i] = y[i];
+
+  for (l=1; l < c->nlev; ++l) {
+    lv = &c->lev[l];
+    if (++lv->cnt*B < lv->M) continue;
+    lv->cnt = 0;
+    if (c->threaded) {
+      atomic_fetch_add_explicit(&lv->posted, 1, memory_order_release);
+      sem_post(&c->work_sem);
+    } else {
+      conv_level_run(c, lv, atomic_load(&lv->done));
+      atomic_fetch_add(&lv->done, 1);
+    }
+  }
+  for (l=1; l < c->nlev; ++l) {
+    lv = &c->lev[l];
+    if (c->threaded) conv_wait(c, lv);
+    for (i=0; i < B; ++i) c->yblk[i] += lv->y[(t + i) & lv->ymask];
+  }
+  c->t += B;
+}
+
+void pffft_conv_process(PFFFT_Conv *c, const float *in, float *out, int n) {
+  int i, k, B = c->B;
+  unsigned t;
+
+  while (n > 0) {
+    k = B - c->pos;
+    if (k > n) k = n;
+    t = (unsigned)c->t + c->pos;
+    /* in first as in and out may alias */
+    for (i=0; i < k; ++i) c->x[(t + i) & c->xmask] = in[i];
+    memcpy(out, c->yblk + c->pos, k*sizeof(float));
+    in += k;
+    out += k;
+    n -= k;
+    c->pos += k;
+    if (c->pos == B) {
+      conv_block(c);
+      c->pos = 0;
+    }
+  }
+}
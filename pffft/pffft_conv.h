@@ -0,0 +1,59 @@
+/*
+  pffft_conv : low latency convolution with long impulse responses on top
+  of pffft.
+
+  The impulse response is split into a non-uniform partition: the head is
+  cut into blocks of the processing block size, and each further level
+  uses blocks four times longer than the one before, up to
+  PFFFT_CONV_MAX_BLOCK. Each level is a uniformly partitioned overlap-save
+  convolution with a frequency domain delay line, and the products of all
+  its partitions are summed in a single pass with pffft_zconvolve_sum.
+
+  The first level is computed in pffft_conv_process. The longer levels
+  have a deadline of at least one of their own blocks after their input is
+  complete, so in threaded mode they run on a background thread which
+  always picks the pending block with the earliest deadline, and the audio
+  thread only waits if one of them is late. Without the thread they are
+  computed in pffft_conv_process when their input is complete, which gives
+  the same output but an uneven load per call.
+
+  The output is delayed by block samples. Threaded mode needs -lpthread.
+*/
+
+#ifndef PFFFT_CONV_H
+#define PFFFT_CONV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** longest block used for the tail of the impulse response */
+#ifndef PFFFT_CONV_MAX_BLOCK
+#define PFFFT_CONV_MAX_BLOCK 8192
+#endif
+
+  /** Opaque convolution state */
+  typedef struct PFFFT_Conv PFFFT_Conv;
+
+  /**
+    Prepare the convolution of a stream with the irlen samples of ir,
+    which are copied. block must be a multiple of
+    pffft_min_fft_size(PFFFT_REAL)/2 and 2*block a valid real pffft size.
+    If threaded is non-zero the longer partitions are computed by a worker
+    thread. Returns NULL if the size is not suitable or on failure.
+  */
+  PFFFT_Conv *pffft_conv_new(const float *ir, int irlen, int block, int threaded);
+  void pffft_conv_destroy(PFFFT_Conv *c);
+
+  /**
+    Push n input samples and pull the same number of output samples, n
+    may be anything. in and out may alias. No allocation or system calls
+    are done, except for waking the worker in threaded mode.
+  */
+  void pffft_conv_process(PFFFT_Conv *c, const float *in, float *out, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFT_CONV_H
@@ -0,0 +1,339 @@
+/*
+  pffft_dct : discrete cosine / sine transforms and the MDCT on top of
+  pffft.
+
+  DCT-II (Makhoul): the even samples in order followed by the odd ones
+  reversed go through a real FFT, and X[k] = Re(exp(-i pi k / 2N) V[k]).
+  The post stage makes X[k] and X[N-k] from the same bin, so it reads the
+  ordered spectrum once. DCT-III runs the same steps backwards.
+
+  DCT-IV: the pairs x[2n] + i x[N-1-2n], split out by the DCT-II pre
+  stage, are turned by exp(-i pi (n + 1/4) / N), go through a complex FFT
+  of N/2 and are turned again by exp(-i pi k / N). Re and -Im of bin k are
+  X[2k] and X[N-1-2k].
+
+  Like pffft_real_preprocess / pffft_real_finalize the twiddle stages are
+  one pass over the data with the cos and sin in separate arrays. They are
+  written as plain loops with restrict pointers and unit stride tables so
+  GCC vectorizes them for RVV and SSE alike. The DSTs only change an
+  input order or an output sign, which those loops take as arguments.
+
+  MDCT: with the windowed block split in quarters (a, b, c, d) it is the
+  DCT-IV of (-c_r - d, a - b_r), _r meaning reversed, and the inverse
+  unfolds a DCT-IV to (v2, -v2_r, -v1_r, -v1). The window is applied in
+  the fold / unfold loops.
+*/
+
+#include "pffft.h"
+#include "pffft_dct.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if defined(__GNUC__)
+#  define RESTRICT __restrict
+#else
+#  define RESTRICT
+#endif
+
+struct PFFFT_Dct {
+  PFFFT_Setup *setup;
+  int N;
+  pffft_dct_type_t type;
+  float *twc, *tws;   // post (II) / pre (III, IV) twiddles, N/2 each
+  float *tw2c, *tw2s; // DCT-IV post twiddles, N/2 each
+  float *buf;         // FFT input / output
+  float *work;
+};
+
+struct PFFFT_Mdct {
+  PFFFT_Dct *dct;     // DCT-IV of M
+  int M;
+  float *win;         // analysis window, 2M
+  float *swin;        // synthesis window with the 2/M, 2M
+  float *fold;        // DCT-IV input / output, M
+  float *block;       // unfolded block, 2M
+  float *hist;        // last M input samples for pffft_mdct_analyze
+  float *ola;         // second half of the last block for pffft_mdct_synthesize
+};
+
+PFFFT_Dct *pffft_dct_new(int N, pffft_dct_type_t type) {
+  PFFFT_Dct *d;
+  int k, iv = (type == PFFFT_DCT_IV || type == PFFFT_DST_IV);
+  float *mem;
+
+  if (N <= 0 || (N % pffft_min_fft_size(PFFFT_REAL)) || type < PFFFT_DCT_II || type > PFFFT_DST_IV) {
+    return 0;
+  }
+  d = (PFFFT_Dct*)calloc(1, sizeof(PFFFT_Dct));
+  if (!d) return 0;
+  d->setup = iv ? pffft_new_setup(N/2, PFFFT_COMPLEX) : pffft_new_setup(N, PFFFT_REAL);
+  /* one block for the twiddles and buffers, each N floats keeps them aligned */
+  mem = (float*)pffft_aligned_malloc(4*N*sizeof(float));
+  if (!d->setup || !mem) {
+    if (mem) pffft_aligned_free(mem);
+    if (d->setup) pffft_destroy_setup(d->setup);
+    free(d);
+    return 0;
+  }
+  d->N = N;
+  d->type = type;
+  d->twc = mem;
+  d->tws = mem + N/2;
+  d->tw2c = mem + N;
+  d->tw2s = mem + 3*N/2;
+  d->buf = mem + 2*N;
+  d->work = mem + 3*N;
+
+  for (k=0; k < N/2; ++k) {
+    double a = iv ? M_PI*(k + 0.25)/N : M_PI*k/(2*N);
+    d->twc[k] = (float)cos(a);
+    d->tws[k] = (float)sin(a);
+    d->tw2c[k] = (float)cos(M_PI*k/N);
+    d->tw2s[k] = (float)sin(M_PI*k/N);
+  }
+  return d;
+}
+
+void pffft_dct_destroy(PFFFT_Dct *d) {
+  if (!d) return;
+  pffft_aligned_free(d->twc);
+  pffft_destroy_setup(d->setup);
+  free(d);
+}
+
+/*
+  DCT-II pre stage: v[n] = x[2n], v[N-1-n] = x[2n+1]. sodd is the sign of
+  the odd samples, -1 for the DST-II.
+*/
+static void dct2_pre(int N, const float *RESTRICT x, float *RESTRICT v, float sodd) {
+  int n;
+  for (n=0; n < N/2; ++n) {
+    v[n] = x[2*n];
+    v[N-1-n] = sodd*x[2*n+1];
+  }
+}
+
+/*
+  DCT-II post stage from the ordered real spectrum V. X[k] goes to
+  o[k*st], st = -1 with o at the end reverses the output for the DST-II.
+*/
+static void dct2_post(int N, const float *RESTRICT V, float *RESTRICT o, int st,
+                      const float *RESTRICT c, const float *RESTRICT s) {
+  int k;
+  o[0] = V[0];
+  o[(N/2)*st] = V[1]*(float)M_SQRT1_2;
+  for (k=1; k < N/2; ++k) {
+    float a = V[2*k], b = V[2*k+1];
+    o[k*st] = c[k]*a + s[k]*b;
+    o[(N-k)*st] = s[k]*a - c[k]*b;
+  }
+}
+
+/*
+  DCT-III pre stage: V[k] = exp(i pi k / 2N) (X[k] - i X[N-k]) / 2 in
+  ordered real spectrum layout, X[k] read from x[k*st].
+*/
+static void dct3_pre(int N, const float *RESTRICT x, int st, float *RESTRICT V,
+                     const float *RESTRICT c, const float *RESTRICT s) {
+  int k;
+  V[0] = 0.5f*x[0];
+  V[1] = x[(N/2)*st]*(float)M_SQRT1_2;
+  for (k=1; k < N/2; ++k) {
+    float p = 0.5f*x[k*st], q = 0.5f*x[(N-k)*st];
+    V[2*k] = c[k]*p + s[k]*q;
+    V[2*k+1] = s[k]*p - c[k]*q;
+  }
+}
+
+/* DCT-III post stage, the inverse of dct2_pre with sodd on the odd outputs */
+static void dct3_post(int N, const float *RESTRICT v, float *RESTRICT x, float sodd) {
+  int n;
+  for (n=0; n < N/2; ++n) {
+    x[2*n] = v[n];
+    x[2*n+1] = sodd*v[N-1-n];
+  }
+}
+
+/*
+  DCT-IV pre stage: z[n] = (x[2n] + i x[N-1-2n]) exp(-i pi (n + 1/4) / N)
+  from v, x already split by dct2_pre so that x[2n] is v[n] and
+  x[N-1-2n] is v[N/2+n], which keeps the loop unit stride. rev reverses
+  x for the DST-IV, which only swaps the two halves.
+*/
+static void dct4_pre(int N, const float *RESTRICT v, int rev, float *RESTRICT z,
+                     const float *RESTRICT c, const float *RESTRICT s) {
+  const float *RESTRICT xa = rev ? v + N/2 : v;
+  const float *RESTRICT xb = rev ? v : v + N/2;
+  int n;
+  for (n=0; n < N/2; ++n) {
+    float a = xa[n], b = xb[n];
+    z[2*n] = a*c[n] + b*s[n];
+    z[2*n+1] = b*c[n] - a*s[n];
+  }
+}
+
+/*
+  DCT-IV post stage: Y = Z[k] exp(-i pi k / N), X[2k] = Re Y and
+  X[N-1-2k] = -Im Y, the odd outputs times sodd.
+*/
+static void dct4_post(int N, const float *RESTRICT Z, float *RESTRICT x, float sodd,
+                      const float *RESTRICT c, const float *RESTRICT s) {
+  int k;
+  for (k=0; k < N/2; ++k) {
+    float a = Z[2*k], b = Z[2*k+1];
+    x[2*k] = a*c[k] + b*s[k];
+    x[N-1-2*k] = sodd*(a*s[k] - b*c[k]);
+  }
+}
+
+void pffft_dct_transform(PFFFT_Dct *d, const float *input, float *output) {
+  int N = d->N;
+  float *buf = d->buf;
+
+  switch (d->type) {
+    case PFFFT_DCT_II:
+    case PFFFT_DST_II:
+      /* DST-II(x)[k] = DCT-II((-1)^n x)[N-1-k] */
+      dct2_pre(N, input, buf, d->type == PFFFT_DST_II ? -1.f : 1.f);
+      pffft_transform_ordered(d->setup, buf, buf, d->work, PFFFT_FORWARD);
+      if (d->type == PFFFT_DST_II) dct2_post(N, buf, output + N-1, -1, d->twc, d->tws);
+      else dct2_post(N, buf, output, 1, d->twc, d->tws);
+      break;
+    case PFFFT_DCT_III:
+    case PFFFT_DST_III:
+      /* DST-III(x)[n] = (-1)^n DCT-III(x reversed)[n] */
+      if (d->type == PFFFT_DST_III) dct3_pre(N, input + N-1, -1, buf, d->twc, d->tws);
+      else dct3_pre(N, input, 1, buf, d->twc, d->tws);
+      pffft_transform_ordered(d->setup, buf, buf, d->work, PFFFT_BACKWARD);
+      dct3_post(N, buf, output, d->type == PFFFT_DST_III ? -1.f : 1.f);
+      break;
+    default:
+      /* DST-IV(x)[k] = (-1)^k DCT-IV(x reversed)[k] */
+      dct2_pre(N, input, d->work, 1.f);
+      dct4_pre(N, d->work, d->type == PFFFT_DST_IV, buf, d->twc, d->tws);
+      pffft_transform_ordered(d->setup, buf, buf, d->work, PFFFT_FORWARD);
+      dct4_post(N, buf, output, d->type == PFFFT_DST_IV ? -1.f : 1.f, d->tw2c, d->tw2s);
+      break;
+  }
+}
+
+/* modified Bessel function of the first kind, order 0 */
+static double bessel_i0(double x) {
+  double sum = 1, term = 1;
+  int k;
+  for (k=1; k < 50 && term > 1e-12*sum; ++k) {
+    term *= (x*x/4)/((double)k*k);
+    sum += term;
+  }
+  return sum;
+}
+
+PFFFT_Mdct *pffft_mdct_new(int M, pffft_mdct_window_t window) {
+  PFFFT_Mdct *m;
+  float *mem;
+  int n;
+
+  m = (PFFFT_Mdct*)calloc(1, sizeof(PFFFT_Mdct));
+  if (!m) return 0;
+  m->dct = pffft_dct_new(M, PFFFT_DCT_IV);
+  mem = (float*)pffft_aligned_malloc(9*M*sizeof(float));
+  if (!m->dct || !mem) {
+    if (mem) pffft_aligned_free(mem);
+    pffft_dct_destroy(m->dct);
+    free(m);
+    return 0;
+  }
+  m->M = M;
+  m->win = mem;
+  m->swin = mem + 2*M;
+  m->fold = mem + 4*M;
+  m->block = mem + 5*M;
+  m->hist = mem + 7*M;
+  m->ola = mem + 8*M;
+
+  if (window == PFFFT_MDCT_KBD) {
+    /* running sums of a Kaiser window of M+1 points */
+    double alpha = 4, sum = 0, tot = 0;
+    for (n=0; n <= M; ++n) {
+      double r = 2.0*n/M - 1;
+      tot += bessel_i0(M_PI*alpha*sqrt(1 - r*r));
+    }
+    for (n=0; n < M; ++n) {
+      double r = 2.0*n/M - 1;
+      sum += bessel_i0(M_PI*alpha*sqrt(1 - r*r));
+      m->win[n] = m->win[2*M-1-n] = (float)sqrt(sum/tot);
+    }
+  } else {
+    for (n=0; n < 2*M; ++n) m->win[n] = (float)sin(M_PI*(n + 0.5)/(2*M));
+  }
+  for (n=0; n < 2*M; ++n) m->swin[n] = 2*m->win[n]/M;
+  pffft_mdct_reset(m);
+  return m;
+}
+
+void pffft_mdct_destroy(PFFFT_Mdct *m) {
+  if (!m) return;
+  pffft_aligned_free(m->win);
+  pffft_dct_destroy(m->dct);
+  free(m);
+}
+
+void pffft_mdct_reset(PFFFT_Mdct *m) {
+  memset(m->hist, 0, m->M*sizeof(float));
+  memset(m->ola, 0, m->M*sizeof(float));
+}
+
+/*
+  window and fold the block lo[0..M) hi[0..M) = (a, b, c, d) to
+  (-c_r - d, a - b_r)
+*/
+static void mdct_fold(int M, const float *RESTRICT lo, const float *RESTRICT hi,
+                      const float *RESTRICT w, float *RESTRICT u) {
+  int n, h = M/2;
+  for (n=0; n < h; ++n) {
+    u[n] = -w[M+h-1-n]*hi[h-1-n] - w[M+h+n]*hi[h+n];
+    u[h+n] = w[n]*lo[n] - w[M-1-n]*lo[M-1-n];
+  }
+}
+
+/* unfold the DCT-IV result v = (v1, v2) to (v2, -v2_r, -v1_r, -v1) and window */
+static void mdct_unfold(int M, const float *RESTRICT v, const float *RESTRICT w,
+                        float *RESTRICT y) {
+  int n, h = M/2;
+  for (n=0; n < h; ++n) {
+    y[n] = w[n]*v[h+n];
+    y[h+n] = -w[h+n]*v[M-1-n];
+    y[M+n] = -w[M+n]*v[h-1-n];
+    y[M+h+n] = -w[M+h+n]*v[n];
+  }
+}
+
+void pffft_mdct_forward(PFFFT_Mdct *m, const float *input, float *coef) {
+  mdct_fold(m->M, input, input + m->M, m->win, m->fold);
+  pffft_dct_transform(m->dct, m->fold, coef);
+}
+
+void pffft_mdct_backward(PFFFT_Mdct *m, const float *coef, float *output) {
+  pffft_dct_transform(m->dct, coef, m->fold);
+  mdct_unfold(m->M, m->fold, m->swin, output);
+}
+
+void pffft_mdct_analyze(PFFFT_Mdct *m, const float *input, float *coef) {
+  mdct_fold(m->M, m->hist, input, m->win, m->fold);
+  /* before the transform as input and coef may alias */
+  memcpy(m->hist, input, m->M*sizeof(float));
+  pffft_dct_transform(m->dct, m->fold, coef);
+}
+
+void pffft_mdct_synthesize(PFFFT_Mdct *m, const float *coef, float *output) {
+  int n, M = m->M;
+
+  pffft_mdct_backward(m, coef, m->block);
+  for (n=0; n < M; ++n) output[n] = m->ola[n] + m->block[n];
+  memcpy(m->ola, m->block + M, M*sizeof(float));
+}
@@ -0,0 +1,113 @@
+/*
+  pffft_dct : discrete cosine / sine transforms and the MDCT on top of
+  pffft.
+
+  DCT-II and DCT-III of N points are one real pffft of N points, DCT-IV
+  one complex pffft of N/2 points, each between an O(N) pre and post
+  twiddle stage. The DST-II/III/IV are the same with the input signs
+  alternated or the input / output reversed. The MDCT of 2M samples is a
+  fold into M points and a DCT-IV of M.
+
+  All transforms are unscaled, with the textbook definitions:
+
+    DCT-II   X[k] = sum x[n] cos(pi/N (n + 1/2) k)
+    DCT-III  X[k] = x[0]/2 + sum(n >= 1) x[n] cos(pi/N n (k + 1/2))
+    DCT-IV   X[k] = sum x[n] cos(pi/N (n + 1/2) (k + 1/2))
+    DST-II   X[k] = sum x[n] sin(pi/N (n + 1/2) (k + 1))
+    DST-III  X[k] = (-1)^k x[N-1]/2 + sum(n < N-1) x[n] sin(pi/N (n + 1) (k + 1/2))
+    DST-IV   X[k] = sum x[n] sin(pi/N (n + 1/2) (k + 1/2))
+
+  so III(II(x)) = II(III(x)) = N/2 x and IV(IV(x)) = N/2 x.
+*/
+
+#ifndef PFFFT_DCT_H
+#define PFFFT_DCT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** Opaque DCT / DST state */
+  typedef struct PFFFT_Dct PFFFT_Dct;
+
+  typedef enum {
+    PFFFT_DCT_II,
+    PFFFT_DCT_III,
+    PFFFT_DCT_IV,
+    PFFFT_DST_II,
+    PFFFT_DST_III,
+    PFFFT_DST_IV
+  } pffft_dct_type_t;
+
+  /**
+    Prepare a transform of N points. N must be a multiple of
+    pffft_min_fft_size(PFFFT_REAL), which covers both the N point real
+    pffft of the type II/III transforms and the N/2 point complex one of
+    type IV. Returns NULL if N is not suitable or on allocation failure.
+  */
+  PFFFT_Dct *pffft_dct_new(int N, pffft_dct_type_t type);
+  void pffft_dct_destroy(PFFFT_Dct *d);
+
+  /**
+    N points from input to output, which may alias. The state holds
+    the scratch buffers, so one PFFFT_Dct must not be used by two threads
+    at once.
+  */
+  void pffft_dct_transform(PFFFT_Dct *d, const float *input, float *output);
+
+  /** Opaque MDCT state */
+  typedef struct PFFFT_Mdct PFFFT_Mdct;
+
+  /**
+    Windows meeting the Princen-Bradley condition w[n]^2 + w[n+M]^2 = 1,
+    so windowed analysis and synthesis with TDAC overlap-add reconstruct
+    the input exactly.
+  */
+  typedef enum {
+    PFFFT_MDCT_SINE,
+    PFFFT_MDCT_KBD    /* Kaiser-Bessel derived, alpha = 4 */
+  } pffft_mdct_window_t;
+
+  /**
+    Prepare an MDCT with M coefficients per block of 2M samples, with a
+    hop of M. M must be a multiple of pffft_min_fft_size(PFFFT_REAL).
+    Returns NULL if it isn't or on allocation failure.
+  */
+  PFFFT_Mdct *pffft_mdct_new(int M, pffft_mdct_window_t window);
+  void pffft_mdct_destroy(PFFFT_Mdct *m);
+
+  /** clear the overlap state of pffft_mdct_analyze / pffft_mdct_synthesize */
+  void pffft_mdct_reset(PFFFT_Mdct *m);
+
+  /**
+    M coefficients of the windowed block of 2M samples in input.
+
+      X[k] = sum w[n] x[n] cos(pi/M (n + 1/2 + M/2) (k + 1/2))
+  */
+  void pffft_mdct_forward(PFFFT_Mdct *m, const float *input, float *coef);
+
+  /**
+    2M windowed output samples from M coefficients, scaled by 2/M so that
+    overlap-adding the blocks of pffft_mdct_forward with a hop of M gives
+    back the input.
+
+      y[n] = 2/M w[n] sum X[k] cos(pi/M (n + 1/2 + M/2) (k + 1/2))
+  */
+  void pffft_mdct_backward(PFFFT_Mdct *m, const float *coef, float *output);
+
+  /**
+    Streaming versions for codecs and filterbank effects: analyze takes
+    the next M input samples and returns the M coefficients of the block
+    ending with them, synthesize takes M coefficients and returns the next
+    M output samples. Analysis followed by synthesis reproduces the input
+    delayed by M samples. Each keeps its own overlap, so one PFFFT_Mdct
+    can do both.
+  */
+  void pffft_mdct_analyze(PFFFT_Mdct *m, const float *input, float *coef);
+  void pffft_mdct_synthesize(PFFFT_Mdct *m, const float *coef, float *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFT_DCT_H
@@ -0,0 +1,173 @@
+/*
+  pffft_fixed : fixed-point FFT, see pffft_fixed.h.
+
+  A Stockham autosort FFT with radix 4, 2, 3 and 5 passes, so it takes
+  every size pffft does and needs no reordering pass. Real transforms are
+  complex ones of half the size followed by a split pass, which gives
+  the same layout as the ordered real pffft.
+
+  Block floating point: every pass notes the magnitude bits of what it
+  writes (an OR of |x|), and the next one shifts its inputs as it loads
+  them so that they have 2 (radix 2) or 3 bits of headroom left, enough
+  for the largest growth of the pass. Quiet inputs get shifted up, so
+  they keep their precision.
+
+  The kernels are in pffft_fixed_impl.h, built once for Q15 with 32-bit
+  products and once for Q31 with 64-bit products.
+*/
+
+#include "pffft_fixed.h"
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* the outputs of a pass never overlap, which the compiler can't prove */
+#if defined(_MSC_VER)
+#  define FX_INLINE(return_type) __forceinline return_type
+#  define RESTRICT __restrict
+#  define FX_IVDEP
+#else
+#  define FX_INLINE(return_type) inline return_type __attribute__ ((always_inline))
+#  define RESTRICT __restrict
+#  define FX_IVDEP _Pragma("GCC ivdep")
+#endif
+
+#define FX_MAX_STAGES 32
+
+struct PFFFT_Fixed_Setup {
+  int N, Nc;            // Nc complex points
+  pffft_transform_t transform;
+  int nstages;
+  int radix[FX_MAX_STAGES];
+  int16_t *tw15r, *tw15i, *sp15r, *sp15i;
+  int32_t *tw31r, *tw31i, *sp31r, *sp31i;
+};
+
+/* bits of magnitude: |x| <= 2^bits for every x with x ^ (x >> 31) in mask */
+#define FX_MAG(v) ((v) ^ ((v) >> 31))
+
+/* shift that leaves h bits of headroom below b */
+static int fixed_shift(int32_t mask, int h, int b) {
+  int bits = 0;
+  if (!mask) return 0;
+  while (mask) {
+    ++bits;
+    mask >>= 1;
+  }
+  return bits + h - b;
+}
+
+#define FX(name) name##_q15
+#define FX_T int16_t
+#define FX_ACC int32_t
+#define FX_Q 15
+#define FX_B 15
+#define FX_ONE 32768.0
+#define FX_RND 1
+#define FX_TWR(s) (s)->tw15r
+#define FX_TWI(s) (s)->tw15i
+#define FX_SPR(s) (s)->sp15r
+#define FX_SPI(s) (s)->sp15i
+#include "pffft_fixed_impl.h"
+#undef FX
+#undef FX_T
+#undef FX_ACC
+#undef FX_Q
+#undef FX_B
+#undef FX_ONE
+#undef FX_RND
+#undef FX_TWR
+#undef FX_TWI
+#undef FX_SPR
+#undef FX_SPI
+
+/* Q31 shifts are left unrounded, the add could overflow at full scale */
+#define FX(name) name##_q31
+#define FX_T int32_t
+#define FX_ACC int64_t
+#define FX_Q 31
+#define FX_B 31
+#define FX_ONE 2147483648.0
+#define FX_RND 0
+#define FX_TWR(s) (s)->tw31r
+#define FX_TWI(s) (s)->tw31i
+#define FX_SPR(s) (s)->sp31r
+#define FX_SPI(s) (s)->sp31i
+#include "pffft_fixed_impl.h"
+
+/* cos and sin in Qn, 1.0 saturated */
+static void fixed_twiddle(double ph, int k, int16_t *r15, int16_t *i15, int32_t *r31, int32_t *i31) {
+  double c = cos(ph), s = sin(ph);
+  r15[k] = (int16_t)(c >= 1 ? 32767 : c <= -1 ? -32767 : floor(c*32768 + 0.5));
+  i15[k] = (int16_t)(s >= 1 ? 32767 : s <= -1 ? -32767 : floor(s*32768 + 0.5));
+  r31[k] = (int32_t)(c >= 1 ? 2147483647 : c <= -1 ? -2147483647 : floor(c*2147483648.0 + 0.5));
+  i31[k] = (int32_t)(s >= 1 ? 2147483647 : s <= -1 ? -2147483647 : floor(s*2147483648.0 + 0.5));
+  /* rounding up to +1.0 overflows */
+  if (r15[k] == -32768 && c > 0) r15[k] = 32767;
+  if (i15[k] == -32768 && s > 0) i15[k] = 32767;
+}
+
+PFFFT_Fixed_Setup *pffft_fixed_new_setup(int N, pffft_transform_t transform) {
+  PFFFT_Fixed_Setup *st;
+  int n, r, m, i, k, p, ntw, Nc = transform == PFFFT_REAL ? N/2 : N;
+  static const int radices[] = { 4, 2, 3, 5 };
+
+  if (N <= 0 || N % pffft_min_fft_size(transform)) return 0;
+  st = (PFFFT_Fixed_Setup*)calloc(1, sizeof(PFFFT_Fixed_Setup));
+  if (!st) return 0;
+  st->N = N;
+  st->Nc = Nc;
+  st->transform = transform;
+
+  /* radix 4 passes first, then 2, 3 and 5 */
+  for (n=Nc, i=0; i < 4; ++i) {
+    while (n % radices[i] == 0 && st->nstages < FX_MAX_STAGES) {
+      st->radix[st->nstages++] = radices[i];
+      n /= radices[i];
+    }
+  }
+  if (n != 1) {
+    free(st);
+    return 0;
+  }
+
+  /* pass twiddles w_n^(k*p), k = 1..r-1, p < m, and the split ones w_N^k */
+  ntw = Nc + Nc/2 + 1;
+  st->tw15r = (int16_t*)malloc(2*ntw*sizeof(int16_t));
+  st->tw31r = (int32_t*)malloc(2*ntw*sizeof(int32_t));
+  if (!st->tw15r || !st->tw31r) {
+    pffft_fixed_destroy_setup(st);
+    return 0;
+  }
+  st->tw15i = st->tw15r + ntw;
+  st->tw31i = st->tw31r + ntw;
+  st->sp15r = st->tw15r + Nc;
+  st->sp15i = st->tw15i + Nc;
+  st->sp31r = st->tw31r + Nc;
+  st->sp31i = st->tw31i + Nc;
+
+  for (n=Nc, i=0, ntw=0; i < st->nstages; ++i) {
+    r = st->radix[i];
+    m = n/r;
+    for (k=1; k < r; ++k) {
+      for (p=0; p < m; ++p) {
+        fixed_twiddle(-2*M_PI*k*p/n, ntw++, st->tw15r, st->tw15i, st->tw31r, st->tw31i);
+      }
+    }
+    n = m;
+  }
+  for (k=0; k <= Nc/2; ++k) {
+    fixed_twiddle(-2*M_PI*k/N, k, st->sp15r, st->sp15i, st->sp31r, st->sp31i);
+  }
+  return st;
+}
+
+void pffft_fixed_destroy_setup(PFFFT_Fixed_Setup *st) {
+  if (!st) return;
+  free(st->tw15r);
+  free(st->tw31r);
+  free(st);
+}
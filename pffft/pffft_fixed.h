@@ -0,0 +1,58 @@
+/*
+  pffft_fixed : fixed-point (Q15 and Q31) FFT with the size set and
+  output layout of pffft.
+
+  For code that keeps its samples in int16_t / int32_t end to end, so a
+  spectral effect does not have to convert to float and back every block.
+  The transforms use block floating point: before every pass the data is
+  scaled by a power of two to use the available range without
+  overflowing, and the total is returned as an exponent.
+
+  The output is in the order of pffft_transform_ordered. With the
+  returned exponent e, output * 2^e is the unscaled transform, the same
+  values as pffft_transform_ordered would give for the same input as
+  floats. A forward and backward transform in a row give the input times
+  N, so the exponent of the round trip is e_fwd + e_bwd - log2(N) for
+  power of two sizes.
+*/
+
+#ifndef PFFFT_FIXED_H
+#define PFFFT_FIXED_H
+
+#include <stdint.h>
+#include "pffft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** Opaque fixed-point setup, holds the Q15 and Q31 twiddles */
+  typedef struct PFFFT_Fixed_Setup PFFFT_Fixed_Setup;
+
+  /**
+    Prepare a fixed-point transform of N points. N must be a valid size
+    for pffft_new_setup with the same transform type. Returns NULL
+    otherwise.
+  */
+  PFFFT_Fixed_Setup *pffft_fixed_new_setup(int N, pffft_transform_t transform);
+  void pffft_fixed_destroy_setup(PFFFT_Fixed_Setup *setup);
+
+  /**
+    Q15 transform. The work area holds 4*N values for complex transforms
+    and 2*N for real ones, i.e. twice the transform size in int16_t.
+    input and output may alias. Returns the block exponent of the output.
+    The backward transform takes an input of exponent 0; rescale by the
+    forward exponent yourself when needed.
+  */
+  int pffft_fixed_transform_q15(PFFFT_Fixed_Setup *setup, const int16_t *input, int16_t *output,
+                                int16_t *work, pffft_direction_t direction);
+
+  /** Q31 transform, same rules with int32_t data and work area */
+  int pffft_fixed_transform_q31(PFFFT_Fixed_Setup *setup, const int32_t *input, int32_t *output,
+                                int32_t *work, pffft_direction_t direction);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFT_FIXED_H
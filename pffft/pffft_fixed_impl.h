@@ -0,0 +1,282 @@
+/*
+  pffft_fixed_impl.h : the fixed-point kernels, included by pffft_fixed.c
+  once per sample type with these defined:
+
+  FX(name)   function name with the type suffix
+  FX_T       sample and twiddle type
+  FX_ACC     product type, twice as wide as FX_T
+  FX_Q       fraction bits of the twiddles
+  FX_B       magnitude bits of FX_T
+  FX_RND     non-zero to round the block floating point right shifts
+  FX_TWR, FX_TWI, FX_SPR, FX_SPI   setup tables for this type
+
+  The data are kept as separate real and imaginary arrays so that every
+  loop is unit stride, and the butterflies are inlined into loops that
+  the compiler can vectorize (RVV on the C906). Sums are done in int32_t,
+  which block floating point keeps from overflowing.
+*/
+
+/* load with the shift of the pass */
+#define FX_LD(v) ((((int32_t)(v) << lsh) + rnd) >> rsh)
+/* (ar + i ai)(wr + i wi), rounded back to the data scale */
+#define FX_MULR(ar, ai, wr, wi) (int32_t)((((FX_ACC)(ar)*(wr) - (FX_ACC)(ai)*(wi)) + ((FX_ACC)1 << (FX_Q-1))) >> FX_Q)
+#define FX_MULI(ar, ai, wr, wi) (int32_t)((((FX_ACC)(ar)*(wi) + (FX_ACC)(ai)*(wr)) + ((FX_ACC)1 << (FX_Q-1))) >> FX_Q)
+#define FX_MUL(a, c) (int32_t)((((FX_ACC)(a)*(c)) + ((FX_ACC)1 << (FX_Q-1))) >> FX_Q)
+#define FX_C(x) ((FX_T)((x)*FX_ONE + ((x) < 0 ? -0.5 : 0.5)))
+
+/* outputs k = 1..r-1 of a butterfly, times their twiddle, and stored */
+#define FX_STORE(k, vr, vi) do {                                   \
+    int32_t tr_ = FX_MULR(vr, vi, twr[((k)-1)*wm], sg*twi[((k)-1)*wm]); \
+    int32_t ti_ = FX_MULI(vr, vi, twr[((k)-1)*wm], sg*twi[((k)-1)*wm]); \
+    yr[(k)*ys] = (FX_T)tr_; yi[(k)*ys] = (FX_T)ti_;                 \
+    mask |= FX_MAG(tr_) | FX_MAG(ti_);                              \
+  } while (0)
+
+#define FX_ARGS const FX_T *RESTRICT xr, const FX_T *RESTRICT xi, int xs, \
+                FX_T *RESTRICT yr, FX_T *RESTRICT yi, int ys,             \
+                const FX_T *twr, const FX_T *twi, int wm, int sg,         \
+                int lsh, int rsh, int32_t rnd
+
+static FX_INLINE(int32_t) FX(bf2)(FX_ARGS) {
+  int32_t a0r = FX_LD(xr[0]), a0i = FX_LD(xi[0]);
+  int32_t a1r = FX_LD(xr[xs]), a1i = FX_LD(xi[xs]);
+  int32_t mask;
+
+  yr[0] = (FX_T)(a0r + a1r); yi[0] = (FX_T)(a0i + a1i);
+  mask = FX_MAG(a0r + a1r) | FX_MAG(a0i + a1i);
+  FX_STORE(1, a0r - a1r, a0i - a1i);
+  return mask;
+}
+
+static FX_INLINE(int32_t) FX(bf3)(FX_ARGS) {
+  static const FX_T c = FX_C(0.86602540378443864676);
+  int32_t a0r = FX_LD(xr[0]), a0i = FX_LD(xi[0]);
+  int32_t a1r = FX_LD(xr[xs]), a1i = FX_LD(xi[xs]);
+  int32_t a2r = FX_LD(xr[2*xs]), a2i = FX_LD(xi[2*xs]);
+  int32_t tr = a1r + a2r, ti = a1i + a2i;
+  int32_t mr = a0r - (tr >> 1), mi = a0i - (ti >> 1);
+  /* -i sin(2pi/3) (a1 - a2), sign flipped for backward */
+  int32_t sr = sg*FX_MUL(a1i - a2i, c), si = -sg*FX_MUL(a1r - a2r, c);
+  int32_t mask;
+
+  yr[0] = (FX_T)(a0r + tr); yi[0] = (FX_T)(a0i + ti);
+  mask = FX_MAG(a0r + tr) | FX_MAG(a0i + ti);
+  FX_STORE(1, mr + sr, mi + si);
+  FX_STORE(2, mr - sr, mi - si);
+  return mask;
+}
+
+static FX_INLINE(int32_t) FX(bf4)(FX_ARGS) {
+  int32_t a0r = FX_LD(xr[0]), a0i = FX_LD(xi[0]);
+  int32_t a1r = FX_LD(xr[xs]), a1i = FX_LD(xi[xs]);
+  int32_t a2r = FX_LD(xr[2*xs]), a2i = FX_LD(xi[2*xs]);
+  int32_t a3r = FX_LD(xr[3*xs]), a3i = FX_LD(xi[3*xs]);
+  int32_t t0r = a0r + a2r, t0i = a0i + a2i, t1r = a0r - a2r, t1i = a0i - a2i;
+  int32_t t2r = a1r + a3r, t2i = a1i + a3i;
+  /* -i (a1 - a3), +i for backward */
+  int32_t t3r = sg*(a1i - a3i), t3i = -sg*(a1r - a3r);
+  int32_t mask;
+
+  yr[0] = (FX_T)(t0r + t2r); yi[0] = (FX_T)(t0i + t2i);
+  mask = FX_MAG(t0r + t2r) | FX_MAG(t0i + t2i);
+  FX_STORE(1, t1r + t3r, t1i + t3i);
+  FX_STORE(2, t0r - t2r, t0i - t2i);
+  FX_STORE(3, t1r - t3r, t1i - t3i);
+  return mask;
+}
+
+static FX_INLINE(int32_t) FX(bf5)(FX_ARGS) {
+  static const FX_T c1 = FX_C(0.30901699437494742410), c2 = FX_C(-0.80901699437494742410);
+  static const FX_T s1 = FX_C(0.95105651629515357212), s2 = FX_C(0.58778525229247312917);
+  int32_t a0r = FX_LD(xr[0]), a0i = FX_LD(xi[0]);
+  int32_t a1r = FX_LD(xr[xs]), a1i = FX_LD(xi[xs]);
+  int32_t a2r = FX_LD(xr[2*xs]), a2i = FX_LD(xi[2*xs]);
+  int32_t a3r = FX_LD(xr[3*xs]), a3i = FX_LD(xi[3*xs]);
+  int32_t a4r = FX_LD(xr[4*xs]), a4i = FX_LD(xi[4*xs]);
+  int32_t t1r = a1r + a4r, t1i = a1i + a4i, t2r = a2r + a3r, t2i = a2i + a3i;
+  int32_t d1r = a1r - a4r, d1i = a1i - a4i, d2r = a2r - a3r, d2i = a2i - a3i;
+  int32_t m1r = a0r + FX_MUL(t1r, c1) + FX_MUL(t2r, c2), m1i = a0i + FX_MUL(t1i, c1) + FX_MUL(t2i, c2);
+  int32_t m2r = a0r + FX_MUL(t1r, c2) + FX_MUL(t2r, c1), m2i = a0i + FX_MUL(t1i, c2) + FX_MUL(t2i, c1);
+  /* -i (s1 d1 + s2 d2) and -i (s2 d1 - s1 d2), sign flipped for backward */
+  int32_t n1r = sg*(FX_MUL(d1i, s1) + FX_MUL(d2i, s2)), n1i = -sg*(FX_MUL(d1r, s1) + FX_MUL(d2r, s2));
+  int32_t n2r = sg*(FX_MUL(d1i, s2) - FX_MUL(d2i, s1)), n2i = -sg*(FX_MUL(d1r, s2) - FX_MUL(d2r, s1));
+  int32_t y0r = a0r + t1r + t2r, y0i = a0i + t1i + t2i;
+  int32_t mask;
+
+  yr[0] = (FX_T)y0r; yi[0] = (FX_T)y0i;
+  mask = FX_MAG(y0r) | FX_MAG(y0i);
+  FX_STORE(1, m1r + n1r, m1i + n1i);
+  FX_STORE(2, m2r + n2r, m2i + n2i);
+  FX_STORE(3, m2r - n2r, m2i - n2i);
+  FX_STORE(4, m1r - n1r, m1i - n1i);
+  return mask;
+}
+
+/*
+  one Stockham pass of radix r: x[q + s*(p + j*m)] -> y[q + s*(r*p + k)],
+  times w_n^(k*p). The inner loop runs over q, which is unit stride for
+  loads and stores. Every size pffft takes starts with two radix 4
+  passes, with s = 1 and s = 4, which are too short for that: they run
+  over p with constant strides instead, which the compiler turns into
+  interleaving loads and stores rather than gathers and scatters.
+*/
+#define FX_LOOP_Q(bf, S)                                                \
+  for (p=0; p < m; ++p) {                                               \
+    FX_IVDEP                                                            \
+    for (q=0; q < (S); ++q) {                                           \
+      mask |= bf(xr + p*(S) + q, xi + p*(S) + q, m*(S), yr + r*p*(S) + q, \
+                 yi + r*p*(S) + q, (S), twr + p, twi + p, m, sg, lsh, rsh, rnd); \
+    }                                                                   \
+  }
+#define FX_LOOPS(bf)                                                    \
+  if (s == 1) {                                                         \
+    FX_LOOP_Q(bf, 1)                                                    \
+  } else if (s == 4) {                                                  \
+    FX_LOOP_Q(bf, 4)                                                    \
+  } else {                                                              \
+    FX_LOOP_Q(bf, s)                                                    \
+  }
+
+static int32_t FX(pass)(int r, int m, int s, const FX_T *RESTRICT twr, const FX_T *RESTRICT twi,
+                        const FX_T *RESTRICT xr, const FX_T *RESTRICT xi,
+                        FX_T *RESTRICT yr, FX_T *RESTRICT yi, int sg, int sh) {
+  int p, q, lsh = sh < 0 ? -sh : 0, rsh = sh > 0 ? sh : 0;
+  int32_t rnd = FX_RND && rsh ? 1 << (rsh-1) : 0, mask = 0;
+
+  switch (r) {
+    case 2: FX_LOOPS(FX(bf2)); break;
+    case 3: FX_LOOPS(FX(bf3)); break;
+    case 4: FX_LOOPS(FX(bf4)); break;
+    default: FX_LOOPS(FX(bf5)); break;
+  }
+  return mask;
+}
+
+/*
+  complex transform of x, returns the exponent and where the result is.
+  mask has the magnitude bits of the input, and gets those of the output.
+*/
+static int FX(cplx)(const PFFFT_Fixed_Setup *st, FX_T *xr, FX_T *xi, FX_T *yr, FX_T *yi,
+                    int32_t *pmask, int sg, FX_T **resr, FX_T **resi) {
+  int i, r, n = st->Nc, s = 1, sh, e = 0, tw = 0;
+  int32_t mask = *pmask;
+  FX_T *t;
+
+  for (i=0; i < st->nstages; ++i) {
+    r = st->radix[i];
+    sh = fixed_shift(mask, r == 2 ? 2 : 3, FX_B);
+    mask = FX(pass)(r, n/r, s, FX_TWR(st) + tw, FX_TWI(st) + tw, xr, xi, yr, yi, sg, sh);
+    e += sh;
+    tw += (r-1)*(n/r);
+    n /= r;
+    s *= r;
+    t = xr; xr = yr; yr = t;
+    t = xi; xi = yi; yi = t;
+  }
+  *resr = xr;
+  *resi = xi;
+  *pmask = mask;
+  return e;
+}
+
+/*
+  real transforms: z[n] = x[2n] + i x[2n+1] has Z[k] = E[k] + i O[k] with E
+  and O the spectra of the even and odd samples, and X[k] = E[k] + w_N^k O[k].
+  The split gives 2X and the join 2Z, which the unscaled inverse expects.
+*/
+static int FX(split)(const PFFFT_Fixed_Setup *st, const FX_T *zr, const FX_T *zi,
+                     int32_t mask, FX_T *out) {
+  const FX_T *spr = FX_SPR(st), *spi = FX_SPI(st);
+  int k, Nc = st->Nc, sh = fixed_shift(mask, 3, FX_B);
+  int lsh = sh < 0 ? -sh : 0, rsh = sh > 0 ? sh : 0;
+  int32_t rnd = FX_RND && rsh ? 1 << (rsh-1) : 0;
+  int32_t ar, ai, br, bi, er, ei, odr, odi, tr, ti;
+
+  ar = FX_LD(zr[0]); ai = FX_LD(zi[0]);
+  out[0] = (FX_T)(2*(ar + ai));
+  out[1] = (FX_T)(2*(ar - ai));
+  for (k=1; k <= Nc/2; ++k) {
+    ar = FX_LD(zr[k]); ai = FX_LD(zi[k]);
+    br = FX_LD(zr[Nc-k]); bi = -FX_LD(zi[Nc-k]);
+    /* 2E = Z[k] + conj Z[Nc-k], 2O = (Z[k] - conj Z[Nc-k])/i */
+    er = ar + br; ei = ai + bi;
+    odr = ai - bi; odi = br - ar;
+    tr = FX_MULR(odr, odi, spr[k], spi[k]);
+    ti = FX_MULI(odr, odi, spr[k], spi[k]);
+    /* X[k] = E + w O, X[Nc-k] = conj(E - w O) */
+    out[2*k] = (FX_T)(er + tr); out[2*k+1] = (FX_T)(ei + ti);
+    out[2*(Nc-k)] = (FX_T)(er - tr); out[2*(Nc-k)+1] = (FX_T)(ti - ei);
+  }
+  return sh - 1;
+}
+
+static int FX(join)(const PFFFT_Fixed_Setup *st, const FX_T *in, FX_T *zr, FX_T *zi, int32_t *zmask) {
+  const FX_T *spr = FX_SPR(st), *spi = FX_SPI(st);
+  int k, Nc = st->Nc, sh, lsh, rsh;
+  int32_t rnd, mask = 0, ar, ai, br, bi, er, ei, dr, di, odr, odi;
+
+  for (k=0; k < 2*Nc; ++k) mask |= FX_MAG((int32_t)in[k]);
+  sh = fixed_shift(mask, 3, FX_B);
+  lsh = sh < 0 ? -sh : 0;
+  rsh = sh > 0 ? sh : 0;
+  rnd = FX_RND && rsh ? 1 << (rsh-1) : 0;
+
+  ar = FX_LD(in[0]); ai = FX_LD(in[1]);
+  zr[0] = (FX_T)(ar + ai);
+  zi[0] = (FX_T)(ar - ai);
+  mask = FX_MAG(ar + ai) | FX_MAG(ar - ai);
+  for (k=1; k <= Nc/2; ++k) {
+    ar = FX_LD(in[2*k]); ai = FX_LD(in[2*k+1]);
+    br = FX_LD(in[2*(Nc-k)]); bi = -FX_LD(in[2*(Nc-k)+1]);
+    /* 2E = X[k] + conj X[Nc-k], 2O = (X[k] - conj X[Nc-k]) conj(w) */
+    er = ar + br; ei = ai + bi;
+    dr = ar - br; di = ai - bi;
+    odr = FX_MULR(dr, di, spr[k], -spi[k]);
+    odi = FX_MULI(dr, di, spr[k], -spi[k]);
+    /* Z[k] = E + i O, Z[Nc-k] = conj(E - i O) */
+    zr[k] = (FX_T)(er - odi); zi[k] = (FX_T)(ei + odr);
+    zr[Nc-k] = (FX_T)(er + odi); zi[Nc-k] = (FX_T)(odr - ei);
+    mask |= FX_MAG(er - odi) | FX_MAG(ei + odr) | FX_MAG(er + odi) | FX_MAG(odr - ei);
+  }
+  *zmask = mask;
+  return sh;
+}
+
+int FX(pffft_fixed_transform)(PFFFT_Fixed_Setup *st, const FX_T *input, FX_T *output,
+                              FX_T *work, pffft_direction_t direction) {
+  int n, e, Nc = st->Nc, sg = direction == PFFFT_FORWARD ? 1 : -1;
+  FX_T *xr = work, *xi = work + Nc, *yr = work + 2*Nc, *yi = work + 3*Nc, *rr, *ri;
+  int32_t mask = 0;
+
+  if (st->transform == PFFFT_REAL && direction == PFFFT_BACKWARD) {
+    e = FX(join)(st, input, xr, xi, &mask);
+  } else {
+    /* complex input, or real input as N/2 complex */
+    for (n=0; n < Nc; ++n) {
+      xr[n] = input[2*n];
+      xi[n] = input[2*n+1];
+      mask |= FX_MAG((int32_t)input[2*n]) | FX_MAG((int32_t)input[2*n+1]);
+    }
+    e = 0;
+  }
+  e += FX(cplx)(st, xr, xi, yr, yi, &mask, sg, &rr, &ri);
+  if (st->transform == PFFFT_REAL && direction == PFFFT_FORWARD) {
+    e += FX(split)(st, rr, ri, mask, output);
+  } else {
+    for (n=0; n < Nc; ++n) {
+      output[2*n] = rr[n];
+      output[2*n+1] = ri[n];
+    }
+  }
+  return e;
+}
+
+#undef FX_LD
+#undef FX_MULR
+#undef FX_MULI
+#undef FX_MUL
+#undef FX_C
+#undef FX_STORE
+#undef FX_ARGS
+#undef FX_LOOP_Q
+#undef FX_LOOPS
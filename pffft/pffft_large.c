@@ -0,0 +1,398 @@
+/*
+  pffft_large : four-step FFT across a thread pool.
+
+  With n = N2*n1 + n2 and k = k1 + N1*k2 the transform of the N1 x N2
+  matrix x[n1][n2] is
+
+    X[k1 + N1*k2] = sum_n2 w_N2^(n2*k2) w_N^(n2*k1) sum_n1 w_N1^(n1*k1) x[n1][n2]
+
+  Pass 1 gathers LARGE_BLK columns at a time into a per-thread buffer,
+  transforms them, applies w_N^(n2*k1) and stores them back as rows of
+  the scratch matrix t[k1][n2]. Pass 2 transforms LARGE_BLK rows of t at a
+  time and scatters them to X[k1 + N1*k2]. Each block reads and writes
+  LARGE_BLK adjacent complex values per matrix row, so both passes move
+  whole cache lines, and the two passes only meet at one barrier.
+
+  The twiddles w_N^m, m = q*N1 + r, come from two tables of N1 and N2
+  entries, w_N^r * w_N^(q*N1), which keeps them accurate without a table
+  of N entries. For a column n2 of pass 1, w_N^(n2*k1) with k1 = hi*LARGE_TWB
+  + lo is built as the product of a short table over lo and one over hi,
+  so the loop over the column is two plain complex multiplies.
+*/
+
+#include "pffft_large.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* columns or rows per block */
+#define LARGE_BLK 16
+/* inner twiddle table length for pass 1 */
+#define LARGE_TWB 64
+#define LARGE_MAX_THREADS 64
+
+typedef struct {
+  PFFFT_Large *l;
+  int id;
+  float *buf;           // LARGE_BLK sub-transforms
+  float *work;
+  float *twlo, *twhi;   // pass 1 twiddles of the current column
+} large_thread;
+
+struct PFFFT_Large {
+  pffft_transform_t transform;
+  int N, Nc, N1, N2;    // Nc = N1*N2 complex points
+  PFFFT_Setup *s1, *s2;
+  float *tw1, *tw2;     // w_Nc^r, r < N1 and w_Nc^(q*N1), q < N2
+  float *rtw1, *rtw2;   // the same for w_N, real split only
+  float *tmp;           // 2*Nc floats
+  int nthreads;
+  large_thread th[LARGE_MAX_THREADS];
+  pthread_t tid[LARGE_MAX_THREADS];
+  pthread_barrier_t start, step, end;
+  pthread_mutex_t lock;
+  pthread_cond_t started;
+  int go, quit;
+  /* current job */
+  const float *in;
+  float *out;
+  pffft_direction_t dir;
+};
+
+static void large_barrier(PFFFT_Large *l, pthread_barrier_t *b) {
+  if (l->nthreads > 1) pthread_barrier_wait(b);
+}
+
+/* a*b, or a*conj(b) for the backward direction */
+static inline void large_cmul(float *a, const float *b, int conj) {
+  float br = b[0], bi = conj ? -b[1] : b[1];
+  float ar = a[0], ai = a[1];
+  a[0] = ar*br - ai*bi;
+  a[1] = ar*bi + ai*br;
+}
+
+/* w^(q*N1 + r) from the split tables */
+static inline void large_twiddle(float *w, const float *t1, const float *t2, int r, int q) {
+  w[0] = t1[2*r]; w[1] = t1[2*r+1];
+  large_cmul(w, t2 + 2*q, 0);
+}
+
+/* n entries of w_Nc^(n2*step*i), conjugated for the backward direction */
+static void large_twiddle_row(PFFFT_Large *l, float *w, int n, int n2, int step, int back) {
+  long long m;
+  int i;
+  for (i=0; i < n; ++i) {
+    m = (long long)n2*step*i % l->Nc;
+    large_twiddle(w + 2*i, l->tw1, l->tw2, (int)(m % l->N1), (int)(m / l->N1));
+    if (back) w[2*i+1] = -w[2*i+1];
+  }
+}
+
+static void large_pass1(large_thread *th, const float *src) {
+  PFFFT_Large *l = th->l;
+  int N1 = l->N1, N2 = l->N2, nblk = (N2 + LARGE_BLK - 1)/LARGE_BLK;
+  int b0 = nblk*th->id/l->nthreads, b1 = nblk*(th->id + 1)/l->nthreads;
+  int b, c0, nc, c, k, hi, lo, nhi = (N1 + LARGE_TWB - 1)/LARGE_TWB;
+  int back = l->dir == PFFFT_BACKWARD;
+  float *row, wr, wi, xr, xi;
+
+  for (b=b0; b < b1; ++b) {
+    c0 = b*LARGE_BLK;
+    nc = N2 - c0 < LARGE_BLK ? N2 - c0 : LARGE_BLK;
+    for (k=0; k < N1; ++k) {
+      const float *s = src + 2*((size_t)k*N2 + c0);
+      for (c=0; c < nc; ++c) {
+        th->buf[2*(c*N1 + k)] = s[2*c];
+        th->buf[2*(c*N1 + k)+1] = s[2*c+1];
+      }
+    }
+    for (c=0; c < nc; ++c) {
+      row = th->buf + 2*c*N1;
+      pffft_transform_ordered(l->s1, row, row, th->work, l->dir);
+      /* w_Nc^(n2*k1) */
+      large_twiddle_row(l, th->twlo, LARGE_TWB, c0 + c, 1, back);
+      large_twiddle_row(l, th->twhi, nhi, c0 + c, LARGE_TWB, back);
+      for (hi=0; hi < nhi; ++hi) {
+        float *x = row + 2*hi*LARGE_TWB;
+        int n = N1 - hi*LARGE_TWB < LARGE_TWB ? N1 - hi*LARGE_TWB : LARGE_TWB;
+        for (lo=0; lo < n; ++lo) {
+          wr = th->twlo[2*lo]*th->twhi[2*hi] - th->twlo[2*lo+1]*th->twhi[2*hi+1];
+          wi = th->twlo[2*lo]*th->twhi[2*hi+1] + th->twlo[2*lo+1]*th->twhi[2*hi];
+          xr = x[2*lo]; xi = x[2*lo+1];
+          x[2*lo] = xr*wr - xi*wi;
+          x[2*lo+1] = xr*wi + xi*wr;
+        }
+      }
+    }
+    for (k=0; k < N1; ++k) {
+      float *t = l->tmp + 2*((size_t)k*N2 + c0);
+      for (c=0; c < nc; ++c) {
+        t[2*c] = th->buf[2*(c*N1 + k)];
+        t[2*c+1] = th->buf[2*(c*N1 + k)+1];
+      }
+    }
+  }
+}
+
+static void large_pass2(large_thread *th, float *dst) {
+  PFFFT_Large *l = th->l;
+  int N1 = l->N1, N2 = l->N2, nblk = (N1 + LARGE_BLK - 1)/LARGE_BLK;
+  int b0 = nblk*th->id/l->nthreads, b1 = nblk*(th->id + 1)/l->nthreads;
+  int b, r0, nr, r, k;
+
+  for (b=b0; b < b1; ++b) {
+    r0 = b*LARGE_BLK;
+    nr = N1 - r0 < LARGE_BLK ? N1 - r0 : LARGE_BLK;
+    for (r=0; r < nr; ++r) {
+      pffft_transform_ordered(l->s2, l->tmp + 2*(size_t)(r0 + r)*N2,
+                              th->buf + 2*r*N2, th->work, l->dir);
+    }
+    for (k=0; k < N2; ++k) {
+      float *d = dst + 2*((size_t)k*N1 + r0);
+      for (r=0; r < nr; ++r) {
+        d[2*r] = th->buf[2*(r*N2 + k)];
+        d[2*r+1] = th->buf[2*(r*N2 + k)+1];
+      }
+    }
+  }
+}
+
+/*
+  real transforms: z[n] = x[2n] + i x[2n+1] has Z[k] = E[k] + i O[k] with E
+  and O the spectra of the even and odd samples, and X[k] = E[k] + w_N^k O[k].
+  Bins k and Nc-k are split or joined together, so src and dst may alias.
+  The join gives twice Z, which the unscaled inverse expects.
+*/
+static void large_real_split(large_thread *th, const float *src, float *dst, int join) {
+  PFFFT_Large *l = th->l;
+  int Nc = l->Nc, N1 = l->N1, half = Nc/2;
+  int k0 = 1 + half*th->id/l->nthreads, k1 = 1 + half*(th->id + 1)/l->nthreads;
+  int k, r, q;
+  float w[2], ar, ai, br, bi, er, ei, odr, odi;
+
+  if (th->id == 0) {
+    /* DC and Nyquist either way: Z[0] = E[0] + i O[0], X[0], X[N/2] = E[0] +- O[0] */
+    ar = src[0]; ai = src[1];
+    dst[0] = ar + ai;
+    dst[1] = ar - ai;
+  }
+  for (k=k0; k < k1; ++k) {
+    float *zk = dst + 2*k, *zm = dst + 2*(Nc - k);
+    ar = src[2*k]; ai = src[2*k+1];
+    br = src[2*(Nc-k)]; bi = -src[2*(Nc-k)+1];  // conj of bin Nc-k
+    q = k/N1;
+    r = k%N1;
+    large_twiddle(w, l->rtw1, l->rtw2, r, q);
+    if (!join) {
+      /* E = (Z[k] + conj Z[Nc-k])/2, O = (Z[k] - conj Z[Nc-k])/2i */
+      er = 0.5f*(ar + br); ei = 0.5f*(ai + bi);
+      odr = 0.5f*(ai - bi); odi = -0.5f*(ar - br);
+      /* X[k] = E + w O, X[Nc-k] = conj(E - w O) */
+      ar = w[0]*odr - w[1]*odi;
+      ai = w[0]*odi + w[1]*odr;
+      zk[0] = er + ar; zk[1] = ei + ai;
+      zm[0] = er - ar; zm[1] = -(ei - ai);
+    } else {
+      /* 2E = X[k] + conj X[Nc-k], 2O = (X[k] - conj X[Nc-k]) conj(w) */
+      er = ar + br; ei = ai + bi;
+      odr = (ar - br)*w[0] + (ai - bi)*w[1];
+      odi = (ai - bi)*w[0] - (ar - br)*w[1];
+      /* Z[k] = E + i O, Z[Nc-k] = conj(E - i O) */
+      zk[0] = er - odi; zk[1] = ei + odr;
+      zm[0] = er + odi; zm[1] = odr - ei;
+    }
+  }
+}
+
+static void large_run(large_thread *th) {
+  PFFFT_Large *l = th->l;
+  const float *src = l->in;
+
+  if (l->transform == PFFFT_REAL && l->dir == PFFFT_BACKWARD) {
+    large_real_split(th, l->in, l->out, 1);
+    large_barrier(l, &l->step);
+    src = l->out;
+  }
+  large_pass1(th, src);
+  large_barrier(l, &l->step);
+  large_pass2(th, l->out);
+  if (l->transform == PFFFT_REAL && l->dir == PFFFT_FORWARD) {
+    large_barrier(l, &l->step);
+    large_real_split(th, l->out, l->out, 0);
+  }
+}
+
+static void *large_worker(void *arg) {
+  large_thread *th = (large_thread*)arg;
+  PFFFT_Large *l = th->l;
+  int quit;
+
+  /* hold until pffft_large_new knows whether all the threads started */
+  pthread_mutex_lock(&l->lock);
+  while (!l->go) pthread_cond_wait(&l->started, &l->lock);
+  quit = l->quit;
+  pthread_mutex_unlock(&l->lock);
+  if (quit) return 0;
+
+  for (;;) {
+    pthread_barrier_wait(&l->start);
+    if (l->quit) break;
+    large_run(th);
+    pthread_barrier_wait(&l->end);
+  }
+  return 0;
+}
+
+/* 2, 3 and 5 only, and a multiple of the SIMD block */
+static int large_valid(int n) {
+  int m = n;
+  if (n < pffft_min_fft_size(PFFFT_COMPLEX) || n % pffft_min_fft_size(PFFFT_COMPLEX)) return 0;
+  while (m % 2 == 0) m /= 2;
+  while (m % 3 == 0) m /= 3;
+  while (m % 5 == 0) m /= 5;
+  return m == 1;
+}
+
+static float *large_table(int n, int step, int N) {
+  float *t = (float*)pffft_aligned_malloc(2*n*sizeof(float));
+  int i;
+  if (!t) return 0;
+  for (i=0; i < n; ++i) {
+    double ph = -2*M_PI*((double)i*step)/N;
+    t[2*i] = (float)cos(ph);
+    t[2*i+1] = (float)sin(ph);
+  }
+  return t;
+}
+
+PFFFT_Large *pffft_large_new(int N, pffft_transform_t transform, int nthreads) {
+  PFFFT_Large *l;
+  int Nc = transform == PFFFT_REAL ? N/2 : N, d, i, mx;
+
+  if (N <= 0 || (transform == PFFFT_REAL && (N & 1))) return 0;
+  l = (PFFFT_Large*)calloc(1, sizeof(PFFFT_Large));
+  if (!l) return 0;
+  l->transform = transform;
+  l->N = N;
+  l->Nc = Nc;
+  /* the most square split */
+  for (d=1; (long long)d*d <= Nc; ++d) {
+    if (Nc % d == 0 && large_valid(d) && large_valid(Nc/d)) l->N1 = d;
+  }
+  if (!l->N1) {
+    free(l);
+    return 0;
+  }
+  l->N2 = Nc/l->N1;
+
+  if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads <= 0) nthreads = 1;
+  if (nthreads > LARGE_MAX_THREADS) nthreads = LARGE_MAX_THREADS;
+
+  l->s1 = pffft_new_setup(l->N1, PFFFT_COMPLEX);
+  l->s2 = pffft_new_setup(l->N2, PFFFT_COMPLEX);
+  l->tw1 = large_table(l->N1, 1, Nc);
+  l->tw2 = large_table(l->N2, l->N1, Nc);
+  if (transform == PFFFT_REAL) {
+    l->rtw1 = large_table(l->N1, 1, N);
+    l->rtw2 = large_table(l->N2, l->N1, N);
+  }
+  l->tmp = (float*)pffft_aligned_malloc(2*(size_t)Nc*sizeof(float));
+  if (!l->s1 || !l->s2 || !l->tw1 || !l->tw2 || !l->tmp ||
+      (transform == PFFFT_REAL && (!l->rtw1 || !l->rtw2))) {
+    pffft_large_destroy(l);
+    return 0;
+  }
+
+  mx = l->N1 > l->N2 ? l->N1 : l->N2;
+  for (i=0; i < nthreads; ++i) {
+    l->th[i].l = l;
+    l->th[i].id = i;
+    l->th[i].buf = (float*)pffft_aligned_malloc((2*(LARGE_BLK + 1)*mx + 2*LARGE_TWB + 2*(mx/LARGE_TWB + 1))*sizeof(float));
+    if (!l->th[i].buf) {
+      pffft_large_destroy(l);
+      return 0;
+    }
+    l->th[i].work = l->th[i].buf + 2*LARGE_BLK*mx;
+    l->th[i].twlo = l->th[i].work + 2*mx;
+    l->th[i].twhi = l->th[i].twlo + 2*LARGE_TWB;
+  }
+
+  l->nthreads = nthreads;
+  if (nthreads > 1) {
+    pthread_mutex_init(&l->lock, 0);
+    pthread_cond_init(&l->started, 0);
+    pthread_barrier_init(&l->start, 0, nthreads);
+    pthread_barrier_init(&l->step, 0, nthreads);
+    pthread_barrier_init(&l->end, 0, nthreads);
+    for (i=1; i < nthreads; ++i) {
+      if (pthread_create(&l->tid[i], 0, large_worker, &l->th[i])) break;
+    }
+    /* release the workers, or tell them to quit if one is missing */
+    pthread_mutex_lock(&l->lock);
+    l->quit = i < nthreads;
+    l->go = 1;
+    pthread_cond_broadcast(&l->started);
+    pthread_mutex_unlock(&l->lock);
+    if (l->quit) {
+      /* none of them has touched the barriers, fall back to one thread */
+      while (--i > 0) pthread_join(l->tid[i], 0);
+      pthread_barrier_destroy(&l->start);
+      pthread_barrier_destroy(&l->step);
+      pthread_barrier_destroy(&l->end);
+      pthread_cond_destroy(&l->started);
+      pthread_mutex_destroy(&l->lock);
+      l->nthreads = 1;
+      l->quit = 0;
+    }
+  }
+  return l;
+}
+
+void pffft_large_destroy(PFFFT_Large *l) {
+  int i;
+
+  if (!l) return;
+  if (l->nthreads > 1) {
+    l->quit = 1;
+    pthread_barrier_wait(&l->start);
+    for (i=1; i < l->nthreads; ++i) pthread_join(l->tid[i], 0);
+    pthread_barrier_destroy(&l->start);
+    pthread_barrier_destroy(&l->step);
+    pthread_barrier_destroy(&l->end);
+    pthread_cond_destroy(&l->started);
+    pthread_mutex_destroy(&l->lock);
+  }
+  for (i=0; i < LARGE_MAX_THREADS; ++i) {
+    if (l->th[i].buf) pffft_aligned_free(l->th[i].buf);
+  }
+  if (l->s1) pffft_destroy_setup(l->s1);
+  if (l->s2) pffft_destroy_setup(l->s2);
+  if (l->tw1) pffft_aligned_free(l->tw1);
+  if (l->tw2) pffft_aligned_free(l->tw2);
+  if (l->rtw1) pffft_aligned_free(l->rtw1);
+  if (l->rtw2) pffft_aligned_free(l->rtw2);
+  if (l->tmp) pffft_aligned_free(l->tmp);
+  free(l);
+}
+
+void pffft_large_transform(PFFFT_Large *l, const float *input, float *output,
+                           pffft_direction_t direction) {
+  l->in = input;
+  l->out = output;
+  l->dir = direction;
+  large_barrier(l, &l->start);
+  large_run(&l->th[0]);
+  large_barrier(l, &l->end);
+}
+
+void pffft_large_split(PFFFT_Large *l, int *N1, int *N2) {
+  *N1 = l->N1;
+  *N2 = l->N2;
+}
@@ -0,0 +1,59 @@
+/*
+  pffft_large : multi-threaded four-step FFT for very large sizes.
+
+  A transform of N = N1*N2 points is done as N2 transforms of N1 points on
+  the columns, a twiddle multiplication, and N1 transforms of N2 points on
+  the rows, with N1 and N2 close to sqrt(N) so that every sub-transform is
+  in the size range where pffft is at its best and stays in cache. The
+  columns and rows are split across a pool of worker threads. The
+  transposes are done a block of columns at a time, fused with the
+  sub-transforms.
+
+  Real transforms of N points are done as complex ones of N/2 points with
+  a final split. The output is in the same order as
+  pffft_transform_ordered, and is unscaled like pffft.
+
+  This pays off for N >= 16384 or so, e.g. for spectra of whole
+  recordings. Needs -lpthread.
+*/
+
+#ifndef PFFFT_LARGE_H
+#define PFFFT_LARGE_H
+
+#include "pffft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** Opaque large transform state */
+  typedef struct PFFFT_Large PFFFT_Large;
+
+  /**
+    Prepare a transform of N points with nthreads threads in total,
+    including the calling one; 0 means one per online CPU. The complex
+    size (N, or N/2 for real transforms) must be the product of two valid
+    complex pffft sizes. Returns NULL if it is not, or on failure. The
+    scratch memory, 2*N floats plus a few blocks per thread, is allocated
+    here.
+  */
+  PFFFT_Large *pffft_large_new(int N, pffft_transform_t transform, int nthreads);
+  void pffft_large_destroy(PFFFT_Large *l);
+
+  /**
+    Forward or backward transform, ordered as pffft_transform_ordered.
+    input and output may alias, and should be aligned with
+    pffft_aligned_malloc. A setup may only be used by one caller at a
+    time.
+  */
+  void pffft_large_transform(PFFFT_Large *l, const float *input, float *output,
+                             pffft_direction_t direction);
+
+  /** sizes of the column (N1) and row (N2) sub-transforms */
+  void pffft_large_split(PFFFT_Large *l, int *N1, int *N2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFT_LARGE_H
@@ -0,0 +1,146 @@
+/*
+  pffft_stft : streaming short-time Fourier transform on top of pffft.
+
+  The last nfft input samples are kept in a linear buffer and the newest
+  hop samples are written at its end. Once a hop is complete the frame is
+  windowed, transformed, passed to the callback, transformed back and
+  added into the overlap-add buffer with the synthesis gain, and both
+  buffers move along by hop. Output is read from the start of the
+  overlap-add buffer, which no later frame touches, so the delay is always
+  nfft samples.
+*/
+
+#include "pffft.h"
+#include "pffft_stft.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+struct PFFFT_Stft {
+  PFFFT_Setup *setup;
+  int nfft, hop;
+  int pos;        // samples into the current hop
+  float *win;     // analysis window
+  float *swin;    // synthesis window with the overlap-add gain and 1/nfft
+  float *inbuf;   // last nfft input samples
+  float *olabuf;  // overlap-add accumulator, first hop is the output
+  float *frame;   // windowed frame / spectrum
+  float *work;
+  pffft_stft_callback_t callback;
+  void *ctx;
+};
+
+static double stft_window(pffft_stft_window_t window, int n, int nfft) {
+  double x = 2*M_PI*n/nfft; // periodic windows so they overlap-add flat
+  switch (window) {
+    case PFFFT_STFT_HANN: return 0.5 - 0.5*cos(x);
+    case PFFFT_STFT_SQRT_HANN: return sqrt(0.5 - 0.5*cos(x));
+    case PFFFT_STFT_HAMMING: return 0.54 - 0.46*cos(x);
+    case PFFFT_STFT_BLACKMAN_HARRIS:
+      return 0.35875 - 0.48829*cos(x) + 0.14128*cos(2*x) - 0.01168*cos(3*x);
+    default: return 1.0;
+  }
+}
+
+PFFFT_Stft *pffft_stft_new(int nfft, int hop, pffft_stft_window_t window,
+                           pffft_stft_callback_t callback, void *ctx) {
+  PFFFT_Stft *st;
+  double sum;
+  float *mem;
+  int n, k;
+
+  if (nfft <= 0 || hop <= 0 || hop >= nfft || (nfft % pffft_min_fft_size(PFFFT_REAL))) {
+    return 0;
+  }
+  st = (PFFFT_Stft*)calloc(1, sizeof(PFFFT_Stft));
+  if (!st) return 0;
+  st->setup = pffft_new_setup(nfft, PFFFT_REAL);
+  /* one block for all the buffers, each nfft floats keeps them aligned */
+  mem = (float*)pffft_aligned_malloc(6*nfft*sizeof(float));
+  if (!st->setup || !mem) {
+    if (mem) pffft_aligned_free(mem);
+    if (st->setup) pffft_destroy_setup(st->setup);
+    free(st);
+    return 0;
+  }
+  st->nfft = nfft;
+  st->hop = hop;
+  st->win = mem;
+  st->swin = mem + nfft;
+  st->inbuf = mem + 2*nfft;
+  st->olabuf = mem + 3*nfft;
+  st->frame = mem + 4*nfft;
+  st->work = mem + 5*nfft;
+  st->callback = callback;
+  st->ctx = ctx;
+
+  for (n=0; n < nfft; ++n) {
+    st->win[n] = (float)stft_window(window, n, nfft);
+  }
+  /* the frames overlapping each position in a hop add up to sum(win^2) */
+  for (n=0; n < hop; ++n) {
+    sum = 0;
+    for (k=n; k < nfft; k += hop) sum += (double)st->win[k]*st->win[k];
+    for (k=n; k < nfft; k += hop) {
+      st->swin[k] = sum > 1e-9 ? (float)(st->win[k] / (sum*nfft)) : 0.f;
+    }
+  }
+  pffft_stft_reset(st);
+  return st;
+}
+
+void pffft_stft_destroy(PFFFT_Stft *st) {
+  if (!st) return;
+  pffft_aligned_free(st->win);
+  pffft_destroy_setup(st->setup);
+  free(st);
+}
+
+void pffft_stft_reset(PFFFT_Stft *st) {
+  memset(st->inbuf, 0, st->nfft*sizeof(float));
+  memset(st->olabuf, 0, st->nfft*sizeof(float));
+  st->pos = 0;
+}
+
+/* one complete hop - analyse, call back and overlap-add the result */
+static void stft_frame(PFFFT_Stft *st, int synth) {
+  int n, nfft = st->nfft, hop = st->hop;
+  float *frame = st->frame;
+
+  for (n=0; n < nfft; ++n) frame[n] = st->inbuf[n] * st->win[n];
+  pffft_transform_ordered(st->setup, frame, frame, st->work, PFFFT_FORWARD);
+  if (st->callback) st->callback(st->ctx, frame, nfft);
+  memmove(st->inbuf, st->inbuf + hop, (nfft - hop)*sizeof(float));
+
+  if (!synth) return;
+  pffft_transform_ordered(st->setup, frame, frame, st->work, PFFFT_BACKWARD);
+  memmove(st->olabuf, st->olabuf + hop, (nfft - hop)*sizeof(float));
+  memset(st->olabuf + nfft - hop, 0, hop*sizeof(float));
+  for (n=0; n < nfft; ++n) st->olabuf[n] += frame[n] * st->swin[n];
+}
+
+void pffft_stft_process(PFFFT_Stft *st, const float *in, float *out, int nframes) {
+  int n, nfft = st->nfft, hop = st->hop;
+
+  while (nframes > 0) {
+    n = hop - st->pos;
+    if (n > nframes) n = nframes;
+    /* in first as in and out may alias */
+    memcpy(st->inbuf + nfft - hop + st->pos, in, n*sizeof(float));
+    if (out) {
+      memcpy(out, st->olabuf + st->pos, n*sizeof(float));
+      out += n;
+    }
+    in += n;
+    nframes -= n;
+    st->pos += n;
+    if (st->pos == hop) {
+      stft_frame(st, out != 0);
+      st->pos = 0;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/*
+  pffft_stft : streaming short-time Fourier transform on top of pffft.
+
+  Real input is cut into frames of nfft samples every hop samples,
+  windowed and transformed with a real pffft. Each spectrum is handed to
+  a callback which may modify it in place, then it is transformed back,
+  windowed again and overlap-added to the output (weighted overlap-add,
+  normalised for any window / hop combination).
+
+  All buffers are allocated by pffft_stft_new, so pffft_stft_process
+  does no allocation or locking and can be called straight from the
+  audio loop with any number of frames. The output is delayed by nfft
+  samples.
+*/
+
+#ifndef PFFFT_STFT_H
+#define PFFFT_STFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** Opaque STFT state */
+  typedef struct PFFFT_Stft PFFFT_Stft;
+
+  /** analysis / synthesis window, the same one is used for both */
+  typedef enum {
+    PFFFT_STFT_RECT,
+    PFFFT_STFT_HANN,
+    PFFFT_STFT_SQRT_HANN,
+    PFFFT_STFT_HAMMING,
+    PFFFT_STFT_BLACKMAN_HARRIS
+  } pffft_stft_window_t;
+
+  /**
+    Called once per frame with the spectrum of the windowed frame, in the
+    ordering of pffft_transform_ordered for a real transform: F(0) and
+    F(nfft/2) in the first two floats, then interleaved complex bins 1 to
+    nfft/2-1. The spectrum may be changed in place.
+  */
+  typedef void (*pffft_stft_callback_t)(void *ctx, float *spectrum, int nfft);
+
+  /**
+    Prepare an STFT of nfft points with a new frame every hop samples,
+    0 < hop < nfft so that the frames overlap. nfft must be a valid size
+    for a real pffft. Returns NULL if the sizes are not suitable or on
+    allocation failure.
+  */
+  PFFFT_Stft *pffft_stft_new(int nfft, int hop, pffft_stft_window_t window,
+                             pffft_stft_callback_t callback, void *ctx);
+  void pffft_stft_destroy(PFFFT_Stft *st);
+
+  /** clear the input history and the overlap-add state */
+  void pffft_stft_reset(PFFFT_Stft *st);
+
+  /**
+    Push nframes input samples and pull the same number of output
+    samples. out may be NULL for analysis only, which skips the inverse
+    transforms. in and out may alias.
+  */
+  void pffft_stft_process(PFFFT_Stft *st, const float *in, float *out, int nframes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFT_STFT_H
@@ -0,0 +1,10 @@
+/*
+  pffftd : pffft.c built in double precision, see pffftd.h.
+
+  pffft.c picks the double vector types when PFFFT_DOUBLE is defined and
+  renames its public functions to the pffftd_ ones, so there is one code
+  base for both precisions and the two link together.
+*/
+
+#define PFFFT_DOUBLE
+#include "pffft.c"
@@ -0,0 +1,68 @@
+/*
+  pffftd : pffft in double precision.
+
+  For measurement and analysis code that needs more dynamic range than
+  float over long transforms, e.g. THD+N and latency sweeps. pffftd.c
+  builds pffft.c with doubles, so the algorithms, the sizes and the
+  z-domain layouts are those of pffft.h, and every function below does
+  what its pffft_ namesake does with double in place of float.
+
+  The vectors hold 2 doubles with SSE2 and float64x2 on arm64, 4 with
+  AVX. The GCC vector extension backend holds PFFFT_SIMD_SZ doubles, 2
+  unless set to 4, 8 or 16; on RISC-V it is only used when built with
+  -DPFFFT_SIMD_VECEXT, otherwise RISC-V runs the scalar code.
+  pffftd_min_fft_size() follows: complex sizes are multiples of lanes^2
+  and real ones of 2*lanes^2. Buffers need 8*lanes byte alignment (at
+  least 16), pffftd_aligned_malloc gives it.
+
+  Both precisions can be linked into the same program.
+*/
+
+#ifndef PFFFTD_H
+#define PFFFTD_H
+
+#include "pffft.h" // pffft_direction_t, pffft_transform_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** Opaque double precision setup, read-only once made like PFFFT_Setup */
+  typedef struct PFFFTD_Setup PFFFTD_Setup;
+
+  PFFFTD_Setup *pffftd_new_setup(int N, pffft_transform_t transform);
+  void pffftd_destroy_setup(PFFFTD_Setup *);
+
+  size_t pffftd_setup_bytes(int N, pffft_transform_t transform);
+  PFFFTD_Setup *pffftd_new_setup_inplace(void *mem, size_t bytes, int N, pffft_transform_t transform,
+                                         const double *tables, int ndoubles);
+  /** the twiddle tables of a setup, ndoubles long, for pffftd_new_setup_inplace */
+  const double *pffftd_setup_tables(PFFFTD_Setup *setup, int *ndoubles);
+
+  /** 'work' holds N (2*N for complex) doubles or is NULL */
+  void pffftd_transform(PFFFTD_Setup *setup, const double *input, double *output, double *work, pffft_direction_t direction);
+  void pffftd_transform_ordered(PFFFTD_Setup *setup, const double *input, double *output, double *work, pffft_direction_t direction);
+  void pffftd_transform_batch(PFFFTD_Setup *setup, int M, const double **input, double **output,
+                              double *work, pffft_direction_t direction);
+  void pffftd_zreorder(PFFFTD_Setup *setup, const double *input, double *output, pffft_direction_t direction);
+
+  void pffftd_zconvolve_accumulate(PFFFTD_Setup *setup, const double *dft_a, const double *dft_b, double *dft_ab, double scaling);
+  void pffftd_zconvolve_sum(PFFFTD_Setup *setup, int n, const double **dft_a, const double **dft_b, double *dft_ab, double scaling);
+
+  void *pffftd_aligned_malloc(size_t nb_bytes);
+  void pffftd_aligned_free(void *);
+
+  /** doubles per vector: 1 for the scalar build, else 2, 4, 8 or 16 */
+  int pffftd_simd_size(void);
+
+  /** PFFFT_TWIDDLE_RECUR of the build, 1 without */
+  int pffftd_twiddle_recur(void);
+
+  /** smallest N accepted by pffftd_new_setup, valid sizes are multiples of it */
+  int pffftd_min_fft_size(pffft_transform_t transform);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PFFFTD_H
@@ -6,22 +6,26 @@
   How to build: 
 
   on linux, with fftw3:
-  gcc -o test_pffft -DHAVE_FFTW -msse -mfpmath=sse -O3 -Wall -W pffft.c test_pffft.c fftpack.c -L/usr/local/lib -I/usr/local/include/ -lfftw3f -lm
+  gcc -o test_pffft -DHAVE_FFTW -msse -mfpmath=sse -O3 -Wall -W pffft.c pffftd.c pffft_dct.c pffft_large.c pffft_stft.c pffft_conv.c pffft_fixed.c test_pffft.c fftpack.c fftpackd.c -L/usr/local/lib -I/usr/local/include/ -lfftw3f -lm -lpthread
 
   on macos, without fftw3:
-  clang -o test_pffft -DHAVE_VECLIB -O3 -Wall -W pffft.c test_pffft.c fftpack.c -L/usr/local/lib -I/usr/local/include/ -framework Accelerate
+  clang -o test_pffft -DHAVE_VECLIB -O3 -Wall -W pffft.c pffftd.c pffft_dct.c pffft_large.c pffft_stft.c pffft_conv.c pffft_fixed.c test_pffft.c fftpack.c fftpackd.c -L/usr/local/lib -I/usr/local/include/ -framework Accelerate
 
   on macos, with fftw3:
-  clang -o test_pffft -DHAVE_FFTW -DHAVE_VECLIB -O3 -Wall -W pffft.c test_pffft.c fftpack.c -L/usr/local/lib -I/usr/local/include/ -lfftw3f -framework Accelerate
+  clang -o test_pffft -DHAVE_FFTW -DHAVE_VECLIB -O3 -Wall -W pffft.c pffftd.c pffft_dct.c pffft_large.c pffft_stft.c pffft_conv.c pffft_fixed.c test_pffft.c fftpack.c fftpackd.c -L/usr/local/lib -I/usr/local/include/ -lfftw3f -framework Accelerate
 
   on macos, with fftw3 and Intel MKL:
-  clang -o test_pffft -I /opt/intel/mkl/include -DHAVE_FFTW -DHAVE_VECLIB -DHAVE_MKL  -O3 -Wall -W pffft.c test_pffft.c fftpack.c -L/usr/local/lib -I/usr/local/include/ -lfftw3f -framework Accelerate /opt/intel/mkl/lib/libmkl_{intel_lp64,sequential,core}.a
+  clang -o test_pffft -I /opt/intel/mkl/include -DHAVE_FFTW -DHAVE_VECLIB -DHAVE_MKL  -O3 -Wall -W pffft.c pffftd.c pffft_dct.c pffft_large.c pffft_stft.c pffft_conv.c pffft_fixed.c test_pffft.c fftpack.c fftpackd.c -L/usr/local/lib -I/usr/local/include/ -lfftw3f -framework Accelerate /opt/intel/mkl/lib/libmkl_{intel_lp64,sequential,core}.a
 
   on windows, with visual c++:
   cl /Ox -D_USE_MATH_DEFINES /arch:SSE test_pffft.c pffft.c fftpack.c
   
+  with the GCC vector extension backend at its widest, 16 floats / doubles
+  per vector, which also checks the 128-byte alignment of the pffftd buffers:
+  gcc -o test_pffft -DPFFFT_SIMD_VECEXT -DPFFFT_SIMD_SZ=16 -O3 -Wall -W pffft.c pffftd.c pffft_dct.c pffft_large.c pffft_stft.c pffft_conv.c pffft_fixed.c test_pffft.c fftpack.c fftpackd.c -lm -lpthread
+
   build without SIMD instructions:
-  gcc -o test_pffft -DPFFFT_SIMD_DISABLE -O3 -Wall -W pffft.c test_pffft.c fftpack.c -lm
+  gcc -o test_pffft -DPFFFT_SIMD_DISABLE -O3 -Wall -W pffft.c pffftd.c pffft_dct.c pffft_large.c pffft_stft.c pffft_conv.c pffft_fixed.c test_pffft.c fftpack.c fftpackd.c -lm -lpthread
 
  */
 
@@ -30,6 +34,13 @@
 
 #include "pffft.h"
 #include "fftpack.h"
+#include "pffft_dct.h"
+#include "pffftd.h"
+#include "fftpackd.h"
+#include "pffft_large.h"
+#include "pffft_stft.h"
+#include "pffft_conv.h"
+#include "pffft_fixed.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -56,6 +67,7 @@
 #endif
 
 #define MAX_OF(x,y) ((x)>(y)?(x):(y))
+#define MIN_OF(x,y) ((x)<(y)?(x):(y))
 
 double frand() {
   return rand()/(double)RAND_MAX;
@@ -245,6 +257,33 @@ void pffft_validate_N(int N, int cplx) {
 
   }
 
+  // batched transforms against single ones, with a partly filled last group
+  {
+    int k, m, M = 2*pffft_simd_size() + 1;
+    float *bin[33], *bout[33];
+    for (m=0; m < M; ++m) {
+      bin[m] = pffft_aligned_malloc(Nbytes);
+      bout[m] = pffft_aligned_malloc(Nbytes);
+      for (k=0; k < Nfloat; ++k) bin[m][k] = frand()*2-1;
+    }
+    pffft_transform_batch(s, M, (const float **)bin, bout, 0, PFFFT_FORWARD);
+    for (m=0; m < M; ++m) {
+      pffft_transform_ordered(s, bin[m], tmp, scratch, PFFFT_FORWARD);
+      if (norm_inf_rel(bout[m], tmp, Nfloat) > 1e-4) {
+        printf("%s batch forward mismatch for N=%d signal %d\n", (cplx?"CPLX":"REAL"), N, m); exit(1);
+      }
+    }
+    pffft_transform_batch(s, M, (const float **)bout, bout, 0, PFFFT_BACKWARD);
+    for (m=0; m < M; ++m) {
+      for (k=0; k < Nfloat; ++k) bout[m][k] *= 1.f/N;
+      if (norm_inf_rel(bout[m], bin[m], Nfloat) > 1e-3) {
+        printf("%s batch backward mismatch for N=%d signal %d\n", (cplx?"CPLX":"REAL"), N, m); exit(1);
+      }
+      pffft_aligned_free(bin[m]);
+      pffft_aligned_free(bout[m]);
+    }
+  }
+
   printf("%s PFFFT is OK for N=%d\n", (cplx?"CPLX":"REAL"), N); fflush(stdout);
   
   pffft_destroy_setup(s);
@@ -264,17 +303,415 @@ void pffft_validate(int cplx) {
 
   for (k = 0; Ntest[k]; ++k) {
     int N = Ntest[k];
-    if (N == 16 && !cplx) continue;
+    if (N % pffft_min_fft_size(cplx ? PFFFT_COMPLEX : PFFFT_REAL)) continue;
     pffft_validate_N(N, cplx);
   }
 #ifdef TEST_LARGE_FFTS
   for (k = 0; Ntest_large[k]; ++k) {
     int N = Ntest_large[k];
+    if (N % pffft_min_fft_size(cplx ? PFFFT_COMPLEX : PFFFT_REAL)) continue;
     pffft_validate_N(N, cplx);
   }
 #endif
 }
 
+/* pffftd against fftpack in double, to a bound float could not meet */
+double norm_inf_rel_d(const double *v, const double *w, int N) {
+  double max_w = 0, max_diff = 0;
+  int k;
+  for (k=0; k < N; ++k) {
+    max_w = MAX_OF(max_w, fabs(w[k]));
+    max_diff = MAX_OF(max_diff, fabs(w[k] - v[k]));
+  }
+  assert(max_w > 0);
+  return max_diff / max_w;
+}
+
+void pffftd_validate_N(int N, int cplx) {
+  int Nd = N*(cplx?2:1), Nbytes = Nd*sizeof(double), k;
+  double *ref, *in, *out, *tmp, *wrk, err;
+  PFFFTD_Setup *s = pffftd_new_setup(N, cplx ? PFFFT_COMPLEX : PFFFT_REAL);
+
+  if (!s) { printf("Skipping N=%d, not supported\n", N); return; }
+  ref = pffftd_aligned_malloc(Nbytes);
+  in = pffftd_aligned_malloc(Nbytes);
+  out = pffftd_aligned_malloc(Nbytes);
+  tmp = pffftd_aligned_malloc(Nbytes);
+  wrk = malloc(2*Nbytes + FFTPACK_IFAC_MAX_SIZE*sizeof(double));
+
+  for (k=0; k < Nd; ++k) ref[k] = in[k] = frand()*2-1;
+  if (!cplx) {
+    double refN;
+    drffti(N, wrk);
+    drfftf(N, ref, wrk);
+    // pffft order for real ffts, f(n/2) next to f(0)
+    refN = ref[N-1];
+    for (k=N-2; k >= 1; --k) ref[k+1] = ref[k];
+    ref[1] = refN;
+  } else {
+    dcffti(N, wrk);
+    dcfftf(N, ref, wrk);
+  }
+
+  pffftd_transform_ordered(s, in, out, 0, PFFFT_FORWARD);
+  err = norm_inf_rel_d(out, ref, Nd);
+  if (!(err < 1e-12)) {
+    printf("%s forward PFFFTD mismatch found for N=%d relative error=%g\n", (cplx?"CPLX":"REAL"), N, err);
+    exit(1);
+  }
+  pffftd_transform(s, in, tmp, 0, PFFFT_FORWARD);
+  pffftd_zreorder(s, tmp, out, PFFFT_FORWARD);
+  err = norm_inf_rel_d(out, ref, Nd);
+  if (!(err < 1e-12)) {
+    printf("%s zreorder PFFFTD mismatch found for N=%d relative error=%g\n", (cplx?"CPLX":"REAL"), N, err);
+    exit(1);
+  }
+
+  // in place, and back to the input
+  memcpy(out, in, Nbytes);
+  pffftd_transform(s, out, out, 0, PFFFT_FORWARD);
+  for (k=0; k < Nd; ++k) assert(out[k] == tmp[k]);
+  pffftd_transform(s, out, out, 0, PFFFT_BACKWARD);
+  for (k=0; k < Nd; ++k) out[k] *= 1.0/N;
+  err = norm_inf_rel_d(out, in, Nd);
+  if (!(err < 1e-12)) {
+    printf("%s IFFT PFFFTD does not match for N=%d, relative error=%g\n", (cplx?"CPLX":"REAL"), N, err);
+    exit(1);
+  }
+
+  // circular convolution of the input with itself against the ordered spectrum squared
+  memset(out, 0, Nbytes);
+  pffftd_zconvolve_accumulate(s, tmp, tmp, out, 1.0);
+  pffftd_zreorder(s, out, tmp, PFFFT_FORWARD);
+  for (k=0; k < Nd; k += 2) {
+    double ar = ref[k], ai = ref[k+1];
+    if (cplx || k > 0) {
+      ref[k] = ar*ar - ai*ai;
+      ref[k+1] = 2*ar*ai;
+    } else {
+      ref[0] = ar*ar;
+      ref[1] = ai*ai;
+    }
+  }
+  err = norm_inf_rel_d(tmp, ref, Nd);
+  if (!(err < 1e-12)) {
+    printf("%s zconvolve PFFFTD error for N=%d, relative error=%g\n", (cplx?"CPLX":"REAL"), N, err);
+    exit(1);
+  }
+
+  printf("%s PFFFTD is OK for N=%d\n", (cplx?"CPLX":"REAL"), N); fflush(stdout);
+
+  free(wrk);
+  pffftd_destroy_setup(s);
+  pffftd_aligned_free(ref);
+  pffftd_aligned_free(in);
+  pffftd_aligned_free(out);
+  pffftd_aligned_free(tmp);
+}
+
+void pffftd_validate(int cplx) {
+  static int Ntest[] = { 8, 16, 32, 64, 96, 128, 160, 192, 256, 288, 384, 5*96, 512, 576, 5*128, 800, 864, 1024, 2048, 2592, 4000, 4096, 12000, 36864, 0 };
+  int k;
+
+  for (k = 0; Ntest[k]; ++k) {
+    int N = Ntest[k];
+    if (N % pffftd_min_fft_size(cplx ? PFFFT_COMPLEX : PFFFT_REAL)) continue;
+    pffftd_validate_N(N, cplx);
+  }
+}
+
+/* DCT / DST against their definitions, and MDCT analysis / synthesis */
+double dct_ref(pffft_dct_type_t type, const float *x, int N, int k) {
+  double s = 0;
+  int n;
+  for (n=0; n < N; ++n) {
+    switch (type) {
+      case PFFFT_DCT_II: s += x[n]*cos(M_PI/N*(n + 0.5)*k); break;
+      case PFFFT_DCT_III: s += n ? x[n]*cos(M_PI/N*n*(k + 0.5)) : 0.5*x[0]; break;
+      case PFFFT_DCT_IV: s += x[n]*cos(M_PI/N*(n + 0.5)*(k + 0.5)); break;
+      case PFFFT_DST_II: s += x[n]*sin(M_PI/N*(n + 0.5)*(k + 1)); break;
+      case PFFFT_DST_III: s += n < N-1 ? x[n]*sin(M_PI/N*(n + 1)*(k + 0.5)) : ((k & 1) ? -0.5 : 0.5)*x[n]; break;
+      case PFFFT_DST_IV: s += x[n]*sin(M_PI/N*(n + 0.5)*(k + 0.5)); break;
+    }
+  }
+  return s;
+}
+
+void pffft_validate_dct(void) {
+  static int Ntest[] = { 32, 64, 96, 160, 256, 480, 512, 1024, 0 };
+  static const char *names[] = { "DCT-II", "DCT-III", "DCT-IV", "DST-II", "DST-III", "DST-IV" };
+  int i, t, k, b;
+
+  for (i = 0; Ntest[i]; ++i) {
+    int N = Ntest[i], L = 8*N;
+    float *x, *ref, *out, *in;
+    if (N % pffft_min_fft_size(PFFFT_REAL)) continue;
+    x = pffft_aligned_malloc(N*sizeof(float));
+    ref = pffft_aligned_malloc(N*sizeof(float));
+    out = pffft_aligned_malloc(L*sizeof(float));
+    in = pffft_aligned_malloc(L*sizeof(float));
+    for (t = PFFFT_DCT_II; t <= PFFFT_DST_IV; ++t) {
+      PFFFT_Dct *d = pffft_dct_new(N, t);
+      for (k=0; k < N; ++k) x[k] = frand()*2-1;
+      for (k=0; k < N; ++k) ref[k] = dct_ref(t, x, N, k);
+      pffft_dct_transform(d, x, out);
+      if (norm_inf_rel(out, ref, N) > 1e-5) {
+        printf("%s mismatch for N=%d\n", names[t], N); exit(1);
+      }
+      pffft_dct_transform(d, x, x);
+      if (norm_inf_rel(x, out, N) > 0) {
+        printf("%s in place mismatch for N=%d\n", names[t], N); exit(1);
+      }
+      pffft_dct_destroy(d);
+    }
+    for (t = PFFFT_MDCT_SINE; t <= PFFFT_MDCT_KBD; ++t) {
+      PFFFT_Mdct *m = pffft_mdct_new(N, t);
+      for (k=0; k < L; ++k) in[k] = frand()*2-1;
+      for (b=0; b < L; b += N) {
+        pffft_mdct_analyze(m, in + b, x);
+        pffft_mdct_synthesize(m, x, out + b);
+      }
+      if (norm_inf_rel(out + N, in, L - N) > 1e-5) {
+        printf("MDCT reconstruction error for M=%d\n", N); exit(1);
+      }
+      pffft_mdct_destroy(m);
+    }
+    printf("DCT/DST/MDCT are OK for N=%d\n", N); fflush(stdout);
+    pffft_aligned_free(x);
+    pffft_aligned_free(ref);
+    pffft_aligned_free(out);
+    pffft_aligned_free(in);
+  }
+}
+
+/* pffft_large against a single pffft setup, threaded and on one thread */
+void pffft_validate_large(int cplx) {
+  static int Ntest[] = { 65536, 3*65536, 1<<18, 5*(1<<16), 1<<20, 0 };
+  static int threads[] = { 1, 4, 0 };
+  pffft_transform_t type = cplx ? PFFFT_COMPLEX : PFFFT_REAL;
+  int i, j, k;
+
+  for (i = 0; Ntest[i]; ++i) {
+    int N = Ntest[i], Nf = N*(cplx?2:1), N1, N2;
+    float *in, *ref, *out, *wrk, err;
+    PFFFT_Setup *s;
+
+    if (N % pffft_min_fft_size(type)) continue;
+    s = pffft_new_setup(N, type);
+    in = pffft_aligned_malloc(Nf*sizeof(float));
+    ref = pffft_aligned_malloc(Nf*sizeof(float));
+    out = pffft_aligned_malloc(Nf*sizeof(float));
+    wrk = pffft_aligned_malloc(Nf*sizeof(float));
+    for (k=0; k < Nf; ++k) in[k] = frand()*2-1;
+    pffft_transform_ordered(s, in, ref, wrk, PFFFT_FORWARD);
+
+    for (j = 0; j < 3; ++j) {
+      PFFFT_Large *l = pffft_large_new(N, type, threads[j]);
+      if (!l) { printf("Skipping large N=%d, not supported\n", N); break; }
+      pffft_large_split(l, &N1, &N2);
+      pffft_large_transform(l, in, out, PFFFT_FORWARD);
+      err = norm_inf_rel(out, ref, Nf);
+      if (!(err < 1e-5)) {
+        printf("%s forward PFFFT_Large mismatch for N=%d (%dx%d), %d threads, relative error=%g\n",
+               (cplx?"CPLX":"REAL"), N, N1, N2, threads[j], err);
+        exit(1);
+      }
+      pffft_large_transform(l, out, out, PFFFT_BACKWARD);
+      for (k=0; k < Nf; ++k) out[k] *= 1.f/N;
+      err = norm_inf_rel(out, in, Nf);
+      if (!(err < 1e-5)) {
+        printf("%s PFFFT_Large round trip error for N=%d (%dx%d), %d threads, relative error=%g\n",
+               (cplx?"CPLX":"REAL"), N, N1, N2, threads[j], err);
+        exit(1);
+      }
+      pffft_large_destroy(l);
+    }
+    if (j == 3) { printf("%s PFFFT_Large is OK for N=%d\n", (cplx?"CPLX":"REAL"), N); fflush(stdout); }
+
+    pffft_destroy_setup(s);
+    pffft_aligned_free(in);
+    pffft_aligned_free(ref);
+    pffft_aligned_free(out);
+    pffft_aligned_free(wrk);
+  }
+}
+
+/* pffft_stft resynthesis with no processing gives back the input, nfft samples late */
+void pffft_validate_stft(void) {
+  static int Ntest[] = { 256, 512, 1024, 4096, 0 };
+  int i, k, n;
+
+  for (i = 0; Ntest[i]; ++i) {
+    int nfft = Ntest[i], hop = nfft/4, L = 16*nfft;
+    float *in, *out, err;
+    PFFFT_Stft *st;
+
+    if (nfft % pffft_min_fft_size(PFFFT_REAL)) continue;
+    if (pffft_stft_new(nfft, nfft, PFFFT_STFT_HANN, 0, 0)) {
+      printf("STFT accepted hop == nfft for nfft=%d\n", nfft); exit(1);
+    }
+    st = pffft_stft_new(nfft, hop, PFFFT_STFT_HANN, 0, 0);
+    in = malloc(L*sizeof(float));
+    out = malloc(L*sizeof(float));
+    for (k=0; k < L; ++k) in[k] = frand()*2-1;
+    // uneven chunks so the frames straddle the calls
+    for (k=0; k < L; k += n) {
+      n = MIN_OF(L - k, 1 + k % 97);
+      pffft_stft_process(st, in + k, out + k, n);
+    }
+    // the first frames only overlap-add partially
+    err = norm_inf_rel(out + 2*nfft, in + nfft, L - 2*nfft);
+    if (!(err < 1e-6)) {
+      printf("STFT reconstruction error for nfft=%d hop=%d, relative error=%g\n", nfft, hop, err); exit(1);
+    }
+    printf("STFT is OK for nfft=%d\n", nfft); fflush(stdout);
+    pffft_stft_destroy(st);
+    free(in);
+    free(out);
+  }
+}
+
+/* pffft_conv against direct convolution, with and without the worker thread */
+void pffft_validate_conv(void) {
+  static int Btest[] = { 32, 64, 256, 0 };
+  int irlen = 12000, L = 3*irlen, i, t, k, j, n;
+  float *ir = malloc(irlen*sizeof(float));
+  float *in = malloc(L*sizeof(float));
+  float *ref = malloc(L*sizeof(float));
+  float *out = malloc(L*sizeof(float));
+
+  for (k=0; k < irlen; ++k) ir[k] = (frand()*2-1) * exp(-4.0*k/irlen);
+  for (k=0; k < L; ++k) in[k] = frand()*2-1;
+  for (k=0; k < L; ++k) {
+    double sum = 0;
+    for (j=0; j < irlen && j <= k; ++j) sum += (double)ir[j]*in[k-j];
+    ref[k] = (float)sum;
+  }
+
+  for (i = 0; Btest[i]; ++i) {
+    int B = Btest[i];
+    for (t = 0; t < 2; ++t) {
+      float err;
+      PFFFT_Conv *c = pffft_conv_new(ir, irlen, B, t);
+      if (!c) { printf("Skipping convolution block=%d, not supported\n", B); break; }
+      // uneven chunks so the blocks straddle the calls
+      for (k=0; k < L; k += n) {
+        n = MIN_OF(L - k, 1 + k % 301);
+        pffft_conv_process(c, in + k, out + k, n);
+      }
+      err = norm_inf_rel(out + B, ref, L - B);
+      if (!(err < 1e-5)) {
+        printf("%s convolution error for block=%d, relative error=%g\n", (t?"threaded":"synchronous"), B, err); exit(1);
+      }
+      pffft_conv_destroy(c);
+    }
+    if (t == 2) { printf("convolution is OK for block=%d\n", B); fflush(stdout); }
+  }
+  free(ir);
+  free(in);
+  free(ref);
+  free(out);
+}
+
+/* signal to error ratio in dB of a fixed-point result with block exponent e */
+double fixed_snr_db(const float *ref, const int32_t *res, int e, int n) {
+  double sig = 0, err = 0, d;
+  int k;
+  for (k=0; k < n; ++k) {
+    d = ldexp(res[k], e) - ref[k];
+    sig += (double)ref[k]*ref[k];
+    err += d*d;
+  }
+  return err > 0 ? 10*log10(sig/err) : 999;
+}
+
+/* pffft_fixed against pffft_transform_ordered on full scale random input.
+   The thresholds are about 3 dB under the worst of the real and complex
+   transforms measured on x86, Q31 is limited by the float reference */
+void pffft_validate_fixed(void) {
+  static const struct { int N; double q15_fwd, q15_bwd, q31_fwd, q31_bwd; } Ntest[] = {
+    {    64, 60, 61, 135, 135 },
+    {    96, 58, 59, 135, 135 },
+    {   256, 57, 59, 134, 134 },
+    {   480, 56, 56, 132, 132 },
+    {  1024, 54, 55, 132, 132 },
+    {  2400, 52, 54, 132, 132 },
+    {  4096, 52, 52, 130, 130 },
+    { 16384, 51, 51, 129, 129 },
+    { 65536, 50, 50, 128, 128 },
+    { 0, 0, 0, 0, 0 }
+  };
+  int i, cplx, dir, k;
+
+  for (cplx = 0; cplx < 2; ++cplx) {
+    pffft_transform_t type = cplx ? PFFFT_COMPLEX : PFFFT_REAL;
+    for (i = 0; Ntest[i].N; ++i) {
+      int N = Ntest[i].N, nf = cplx ? 2*N : N;
+      PFFFT_Setup *s;
+      PFFFT_Fixed_Setup *f;
+      float *in, *out;
+      int16_t *in15, *out15, *work15;
+      int32_t *in31, *out31, *work31, *res;
+
+      if (N % pffft_min_fft_size(type)) continue;
+      s = pffft_new_setup(N, type);
+      f = pffft_fixed_new_setup(N, type);
+      if (!s || !f) {
+        printf("fixed-point setup failed for N=%d %s\n", N, (cplx?"CPLX":"REAL")); exit(1);
+      }
+      in = pffft_aligned_malloc(nf*sizeof(float));
+      out = pffft_aligned_malloc(nf*sizeof(float));
+      in15 = malloc(nf*sizeof(int16_t));
+      out15 = malloc(nf*sizeof(int16_t));
+      work15 = malloc(2*nf*sizeof(int16_t));
+      in31 = malloc(nf*sizeof(int32_t));
+      out31 = malloc(nf*sizeof(int32_t));
+      work31 = malloc(2*nf*sizeof(int32_t));
+      res = malloc(nf*sizeof(int32_t));
+
+      for (dir = 0; dir < 2; ++dir) {
+        pffft_direction_t d = dir ? PFFFT_BACKWARD : PFFFT_FORWARD;
+        double snr15, snr31;
+        int e;
+
+        // the backward input is taken as a spectrum in the ordered layout
+        for (k=0; k < nf; ++k) {
+          in15[k] = (int16_t)((frand()*2-1) * 32767);
+          in31[k] = in15[k] * 65536;
+          in[k] = in15[k];
+        }
+        pffft_transform_ordered(s, in, out, 0, d);
+
+        e = pffft_fixed_transform_q15(f, in15, out15, work15, d);
+        for (k=0; k < nf; ++k) res[k] = out15[k];
+        snr15 = fixed_snr_db(out, res, e, nf);
+        // Q31 input is 16 bits up
+        e = pffft_fixed_transform_q31(f, in31, out31, work31, d);
+        snr31 = fixed_snr_db(out, out31, e - 16, nf);
+
+        if (!(snr15 >= (dir ? Ntest[i].q15_bwd : Ntest[i].q15_fwd)) ||
+            !(snr31 >= (dir ? Ntest[i].q31_bwd : Ntest[i].q31_fwd))) {
+          printf("fixed-point %s %s N=%d SNR too low: Q15 %.1f dB, Q31 %.1f dB\n",
+                 (cplx?"CPLX":"REAL"), (dir?"backward":"forward"), N, snr15, snr31); exit(1);
+        }
+      }
+      printf("fixed-point %s transforms are OK for N=%d\n", (cplx?"CPLX":"REAL"), N); fflush(stdout);
+
+      free(res);
+      free(work31);
+      free(out31);
+      free(in31);
+      free(work15);
+      free(out15);
+      free(in15);
+      pffft_aligned_free(out);
+      pffft_aligned_free(in);
+      pffft_fixed_destroy_setup(f);
+      pffft_destroy_setup(s);
+    }
+  }
+}
+
 int array_output_format = 0;
 
 void show_output(const char *name, int N, int cplx, float flops, float t0, float t1, int max_iter) {
@@ -419,7 +856,9 @@ void benchmark_ffts(int N, int cplx) {
 #endif  
 
   // PFFFT benchmark
-  {
+  if (N % pffft_min_fft_size(cplx ? PFFFT_COMPLEX : PFFFT_REAL)) {
+    show_output("PFFFT", N, cplx, -1, -1, -1, -1);
+  } else {
     PFFFT_Setup *s = pffft_new_setup(N, cplx ? PFFFT_COMPLEX : PFFFT_REAL);
     if (s) {
       t0 = uclock_sec();  
@@ -446,6 +885,7 @@ void benchmark_ffts(int N, int cplx) {
 
 #ifndef PFFFT_SIMD_DISABLE
 void validate_pffft_simd(); // a small function inside pffft.c that will detect compiler bugs with respect to simd instruction 
+void validate_pffftd_simd(); // and the same for the double precision build
 #endif
 
 int main(int argc, char **argv) {
@@ -463,9 +903,18 @@ int main(int argc, char **argv) {
 
 #ifndef PFFFT_SIMD_DISABLE
   validate_pffft_simd();
+  validate_pffftd_simd();
 #endif
   pffft_validate(1);
   pffft_validate(0);
+  pffftd_validate(1);
+  pffftd_validate(0);
+  pffft_validate_dct();
+  pffft_validate_large(1);
+  pffft_validate_large(0);
+  pffft_validate_stft();
+  pffft_validate_conv();
+  pffft_validate_fixed();
   if (!array_output_format) {
     // display a nice markdown array
     for (i=0; Nvalues[i] > 0; ++i) {
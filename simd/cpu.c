@@ -0,0 +1,108 @@
+/*
+ * cpu.c - runtime CPU feature probe for kernel dispatch
+ * 10-19-26 E. Brombaugh
+ *
+ * On RISC-V the V bit of AT_HWCAP and the isa line of /proc/cpuinfo are
+ * only hints - the vendor kernels of the Duo report neither for the 0.7
+ * vector unit and an emulator may claim one it can't run. The answer comes
+ * from executing vsetvli under a SIGILL handler. x86 asks cpuid, aarch64
+ * always has NEON. SIMD_FORCE=scalar in the environment reports nothing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <setjmp.h>
+#include "cpu.h"
+
+static unsigned cpu_f;
+static int cpu_done;
+
+#if defined(__riscv)
+static sigjmp_buf probe_env;
+
+static void probe_sigill(int sig)
+{
+	(void)sig;
+	siglongjmp(probe_env, 1);
+}
+
+/*
+ * vsetvli t0, zero, e8, m1 - the same encoding in 0.7 and 1.0, given as a
+ * word so the probe builds without V in -march
+ */
+static int rvv_probe(void)
+{
+	struct sigaction sa, old;
+	volatile int ok = 0;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = probe_sigill;
+	sigaction(SIGILL, &sa, &old);
+	if(!sigsetjmp(probe_env, 1))
+	{
+		__asm__ volatile (".word 0x000072d7" ::: "t0");
+		ok = 1;
+	}
+	sigaction(SIGILL, &old, NULL);
+	return ok;
+}
+#endif
+
+unsigned cpu_features(void)
+{
+	char *force;
+
+	if(cpu_done)
+		return cpu_f;
+	cpu_done = 1;
+	cpu_f = 0;
+
+	if((force = getenv("SIMD_FORCE")) && !strcmp(force, "scalar"))
+		return cpu_f;
+
+#if defined(__riscv)
+	if(rvv_probe())
+		cpu_f |= CPU_F_RVV;
+#elif defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("sse2"))
+		cpu_f |= CPU_F_SSE2;
+	if(__builtin_cpu_supports("avx"))
+		cpu_f |= CPU_F_AVX;
+	if(__builtin_cpu_supports("avx2"))
+		cpu_f |= CPU_F_AVX2;
+	if(__builtin_cpu_supports("fma"))
+		cpu_f |= CPU_F_FMA;
+#elif defined(__aarch64__)
+	cpu_f |= CPU_F_NEON;
+#endif
+
+	return cpu_f;
+}
+
+/*
+ * names of the bits in f, for logs
+ */
+char *cpu_features_str(unsigned f, char *buf, int len)
+{
+	static const char *names[] = {"rvv", "sse2", "avx2", "fma", "neon", "avx"};
+	unsigned i;
+	int n = 0;
+
+	if(len < 1)
+		return buf;
+	buf[0] = 0;
+	for(i=0;i<sizeof(names)/sizeof(names[0]);i++)
+		if(f & (1U << i))
+		{
+			/* snprintf returns the untruncated length, stay inside buf */
+			n += snprintf(buf + n, len - n, "%s%s", n ? " " : "", names[i]);
+			if(n >= len)
+				n = len - 1;
+		}
+	if(!n)
+		snprintf(buf, len, "none");
+	return buf;
+}
@@ -0,0 +1,19 @@
+/*
+ * cpu.h - runtime CPU feature probe for kernel dispatch
+ * 10-19-26 E. Brombaugh
+ */
+
+#ifndef __cpu__
+#define __cpu__
+
+#define CPU_F_RVV	(1 << 0)		// RISC-V vector, 0.7 or 1.0
+#define CPU_F_SSE2	(1 << 1)
+#define CPU_F_AVX2	(1 << 2)
+#define CPU_F_FMA	(1 << 3)
+#define CPU_F_NEON	(1 << 4)
+#define CPU_F_AVX	(1 << 5)
+
+unsigned cpu_features(void);
+char *cpu_features_str(unsigned f, char *buf, int len);
+
+#endif
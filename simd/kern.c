@@ -0,0 +1,279 @@
+/*
+ * kern.c - vectorised DSP kernels on top of simd.h
+ * 10-19-26 E. Brombaugh
+ * 10-19-26 E. Brombaugh - built twice for runtime dispatch
+ * 10-19-26 E. Brombaugh - 8 lane AVX builds
+ *
+ * Not compiled on its own: kern_vec.c includes it with the vector flags,
+ * kern_scalar.c with SIMD_FORCE_SCALAR, each naming the ops table it
+ * defines with KERN_OPS. kern_init() in kern_dispatch.c picks one.
+ */
+
+#define KERN_IMPL
+#include <math.h>
+#include "simd.h"
+#include "cpu.h"
+#include "kern.h"
+
+#define LANES SIMD_F32_LANES
+
+/*
+ * dot product - two accumulators to cover the FMA latency, one reduction
+ * in the vector unit at the end
+ */
+static float kern_dot(const float *a, const float *b, int n)
+{
+	simd_f32 acc0 = simd_zero_f32(), acc1 = simd_zero_f32();
+	float sum;
+	int i = 0;
+
+	for(;i+2*LANES<=n;i+=2*LANES)
+	{
+		acc0 = simd_fma_f32(simd_load_f32(a + i), simd_load_f32(b + i), acc0);
+		acc1 = simd_fma_f32(simd_load_f32(a + i + LANES), simd_load_f32(b + i + LANES), acc1);
+	}
+	if(i+LANES<=n)
+	{
+		acc0 = simd_fma_f32(simd_load_f32(a + i), simd_load_f32(b + i), acc0);
+		i += LANES;
+	}
+	sum = simd_hsum_f32(simd_add_f32(acc0, acc1));
+	for(;i<n;i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+/*
+ * FIR - the lanes hold 4 consecutive outputs so each tap is one broadcast
+ * and one FMA with no reduction, which is slow on the C906. The last
+ * outputs are single dot products.
+ */
+static void kern_fir(float *y, const float *x, const float *hr, int taps, int n)
+{
+	int i = 0, k;
+
+	for(;i+LANES<=n;i+=LANES)
+	{
+		simd_f32 acc = simd_zero_f32();
+
+		for(k=0;k<taps;k++)
+			acc = simd_fma_f32(simd_set1_f32(hr[k]), simd_load_f32(x + i + k), acc);
+		simd_store_f32(y + i, acc);
+	}
+	for(;i<n;i++)
+		y[i] = kern_dot(hr, x + i, taps);
+}
+
+/*
+ * 4 biquads - the recursion runs along time so the lanes are channels,
+ * which takes 4 lane vectors. 8 lane builds use the reference.
+ */
+static void kern_biquad4_run(kern_biquad4 *bq, float *x, int n)
+{
+#if LANES == 4
+	simd_f32 b0 = simd_load_f32(bq->b0), b1 = simd_load_f32(bq->b1), b2 = simd_load_f32(bq->b2);
+	simd_f32 a1 = simd_load_f32(bq->a1), a2 = simd_load_f32(bq->a2);
+	simd_f32 z1 = simd_load_f32(bq->z1), z2 = simd_load_f32(bq->z2);
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		simd_f32 in = simd_load_f32(x + 4*i);
+		simd_f32 out = simd_fma_f32(b0, in, z1);
+
+		z1 = simd_sub_f32(simd_fma_f32(b1, in, z2), simd_mul_f32(a1, out));
+		z2 = simd_sub_f32(simd_mul_f32(b2, in), simd_mul_f32(a2, out));
+		simd_store_f32(x + 4*i, out);
+	}
+	simd_store_f32(bq->z1, z1);
+	simd_store_f32(bq->z2, z2);
+#else
+	kern_biquad4_run_ref(bq, x, n);
+#endif
+}
+
+static float kern_maxabs(const float *x, int n)
+{
+	simd_f32 m = simd_zero_f32();
+	float mx;
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+		m = simd_max_f32(m, simd_abs_f32(simd_load_f32(x + i)));
+	mx = simd_hmax_f32(m);
+	for(;i<n;i++)
+		mx = fabsf(x[i]) > mx ? fabsf(x[i]) : mx;
+	return mx;
+}
+
+static float kern_sum(const float *x, int n)
+{
+	simd_f32 acc0 = simd_zero_f32(), acc1 = simd_zero_f32();
+	float sum;
+	int i = 0;
+
+	for(;i+2*LANES<=n;i+=2*LANES)
+	{
+		acc0 = simd_add_f32(acc0, simd_load_f32(x + i));
+		acc1 = simd_add_f32(acc1, simd_load_f32(x + i + LANES));
+	}
+	if(i+LANES<=n)
+	{
+		acc0 = simd_add_f32(acc0, simd_load_f32(x + i));
+		i += LANES;
+	}
+	sum = simd_hsum_f32(simd_add_f32(acc0, acc1));
+	for(;i<n;i++)
+		sum += x[i];
+	return sum;
+}
+
+/*
+ * saturating Q15 mix of two int16 streams
+ */
+static void kern_mix_i16(int16_t *y, const int16_t *a, const int16_t *b, int16_t ga, int16_t gb, int n)
+{
+	simd_i16 vga = simd_set1_i16(ga), vgb = simd_set1_i16(gb);
+	int i = 0;
+
+	for(;i+SIMD_I16_LANES<=n;i+=SIMD_I16_LANES)
+		simd_store_i16(y + i, simd_adds_i16(simd_mulq15_i16(simd_load_i16(a + i), vga),
+			simd_mulq15_i16(simd_load_i16(b + i), vgb)));
+	kern_mix_i16_ref(y + i, a + i, b + i, ga, gb, n - i);
+}
+
+/*
+ * gain ramp - the lane gains are rebuilt from g0 every step rather than
+ * accumulated so they don't drift from the reference
+ */
+static void kern_gain_ramp(float *y, const float *x, int n, float g0, float g1)
+{
+	float d, ofs[LANES];
+	simd_f32 vofs;
+	int i = 0;
+
+	if(n <= 0)
+		return;
+	d = (g1 - g0) / n;
+	for(i=0;i<LANES;i++)
+		ofs[i] = i * d;
+	vofs = simd_load_f32(ofs);
+	for(i=0;i+LANES<=n;i+=LANES)
+	{
+		simd_f32 g = simd_add_f32(simd_set1_f32(g0 + i * d), vofs);
+		simd_store_f32(y + i, simd_mul_f32(simd_load_f32(x + i), g));
+	}
+	for(;i<n;i++)
+		y[i] = x[i] * (g0 + i * d);
+}
+
+static void kern_i16_to_f32(float *y, const int16_t *x, int n, float scale)
+{
+	simd_f32 s = simd_set1_f32(scale);
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+		simd_store_f32(y + i, simd_mul_f32(simd_load_i16_f32(x + i), s));
+	kern_i16_to_f32_ref(y + i, x + i, n - i, scale);
+}
+
+static void kern_f32_to_i16(int16_t *y, const float *x, int n, float scale)
+{
+	simd_f32 s = simd_set1_f32(scale);
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+		simd_store_f32_i16(y + i, simd_mul_f32(simd_load_f32(x + i), s));
+	kern_f32_to_i16_ref(y + i, x + i, n - i, scale);
+}
+
+static void kern_deinterleave(float *l, float *r, const float *x, int n)
+{
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+	{
+		simd_f32 a, b;
+
+		simd_load2_f32(x + 2*i, &a, &b);
+		simd_store_f32(l + i, a);
+		simd_store_f32(r + i, b);
+	}
+	kern_deinterleave_ref(l + i, r + i, x + 2*i, n - i);
+}
+
+static void kern_interleave(float *x, const float *l, const float *r, int n)
+{
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+		simd_store2_f32(x + 2*i, simd_load_f32(l + i), simd_load_f32(r + i));
+	kern_interleave_ref(x + 2*i, l + i, r + i, n - i);
+}
+
+static void kern_deinterleave_i16(float *l, float *r, const int16_t *x, int n, float scale)
+{
+	simd_f32 s = simd_set1_f32(scale);
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+	{
+		simd_f32 a, b;
+
+		simd_load2_i16_f32(x + 2*i, &a, &b);
+		simd_store_f32(l + i, simd_mul_f32(a, s));
+		simd_store_f32(r + i, simd_mul_f32(b, s));
+	}
+	kern_deinterleave_i16_ref(l + i, r + i, x + 2*i, n - i, scale);
+}
+
+static void kern_interleave_i16(int16_t *x, const float *l, const float *r, int n, float scale)
+{
+	simd_f32 s = simd_set1_f32(scale);
+	int i = 0;
+
+	for(;i+LANES<=n;i+=LANES)
+		simd_store2_f32_i16(x + 2*i, simd_mul_f32(simd_load_f32(l + i), s),
+			simd_mul_f32(simd_load_f32(r + i), s));
+	kern_interleave_i16_ref(x + 2*i, l + i, r + i, n - i, scale);
+}
+
+/*
+ * what the build of this file needs from the CPU
+ */
+#if defined(SIMD_BACKEND_RVV)
+#define KERN_NEEDS CPU_F_RVV
+#elif defined(SIMD_BACKEND_AVX) && defined(__AVX2__) && defined(__FMA__)
+#define KERN_NEEDS (CPU_F_SSE2 | CPU_F_AVX | CPU_F_AVX2 | CPU_F_FMA)
+#elif defined(SIMD_BACKEND_AVX) && defined(__FMA__)
+#define KERN_NEEDS (CPU_F_SSE2 | CPU_F_AVX | CPU_F_FMA)
+#elif defined(SIMD_BACKEND_AVX)
+#define KERN_NEEDS (CPU_F_SSE2 | CPU_F_AVX)
+#elif defined(SIMD_BACKEND_SSE) && defined(__FMA__)
+#define KERN_NEEDS (CPU_F_SSE2 | CPU_F_FMA)
+#elif defined(SIMD_BACKEND_SSE)
+#define KERN_NEEDS CPU_F_SSE2
+#elif defined(SIMD_BACKEND_NEON)
+#define KERN_NEEDS CPU_F_NEON
+#else
+#define KERN_NEEDS 0
+#endif
+
+const kern_ops KERN_OPS =
+{
+	SIMD_NAME,
+	KERN_NEEDS,
+	kern_dot,
+	kern_fir,
+	kern_biquad4_run,
+	kern_maxabs,
+	kern_sum,
+	kern_mix_i16,
+	kern_gain_ramp,
+	kern_i16_to_f32,
+	kern_f32_to_i16,
+	kern_deinterleave,
+	kern_interleave,
+	kern_deinterleave_i16,
+	kern_interleave_i16,
+};
@@ -0,0 +1,108 @@
+/*
+ * kern.h - vectorised DSP kernels on top of simd.h
+ * 10-19-26 E. Brombaugh
+ * 10-19-26 E. Brombaugh - runtime dispatch
+ *
+ * Each kernel has a plain C reference with the _ref suffix that defines
+ * what it computes. The vector versions match it to float rounding, the
+ * int16 mix is bit exact. Lengths need not be a multiple of the lanes.
+ *
+ * The kernels are called through the ops table kern_init() picks for the
+ * CPU at hand, the scalar one until then.
+ */
+
+#ifndef __kern__
+#define __kern__
+
+#include <stdint.h>
+
+/* 4 independent biquads, one per channel of 4 channel interleaved data */
+typedef struct
+{
+	float b0[4], b1[4], b2[4];
+	float a1[4], a2[4];			// a0 = 1, y = b x - a y
+	float z1[4], z2[4];			// transposed direct form II state
+} kern_biquad4;
+
+/* one build of the kernels */
+typedef struct
+{
+	const char *name;			// SIMD_NAME of the build
+	unsigned needs;				// CPU_F_ bits it needs to run
+	float (*dot)(const float *a, const float *b, int n);
+	void (*fir)(float *y, const float *x, const float *hr, int taps, int n);
+	void (*biquad4_run)(kern_biquad4 *bq, float *x, int n);
+	float (*maxabs)(const float *x, int n);
+	float (*sum)(const float *x, int n);
+	void (*mix_i16)(int16_t *y, const int16_t *a, const int16_t *b, int16_t ga, int16_t gb, int n);
+	void (*gain_ramp)(float *y, const float *x, int n, float g0, float g1);
+	void (*i16_to_f32)(float *y, const int16_t *x, int n, float scale);
+	void (*f32_to_i16)(int16_t *y, const float *x, int n, float scale);
+	void (*deinterleave)(float *l, float *r, const float *x, int n);
+	void (*interleave)(float *x, const float *l, const float *r, int n);
+	void (*deinterleave_i16)(float *l, float *r, const int16_t *x, int n, float scale);
+	void (*interleave_i16)(int16_t *x, const float *l, const float *r, int n, float scale);
+} kern_ops;
+
+extern const kern_ops kern_ops_scalar, kern_ops_vec;
+extern const kern_ops *kern_cur;
+
+/*
+ * bind the best build this CPU runs - SIMD_FORCE=scalar in the
+ * environment keeps the scalar one
+ */
+const kern_ops *kern_init(void);
+
+#ifndef KERN_IMPL
+#define kern_dot(a, b, n) kern_cur->dot(a, b, n)
+#define kern_fir(y, x, hr, taps, n) kern_cur->fir(y, x, hr, taps, n)
+#define kern_biquad4_run(bq, x, n) kern_cur->biquad4_run(bq, x, n)
+#define kern_maxabs(x, n) kern_cur->maxabs(x, n)
+#define kern_sum(x, n) kern_cur->sum(x, n)
+#define kern_mix_i16(y, a, b, ga, gb, n) kern_cur->mix_i16(y, a, b, ga, gb, n)
+#define kern_gain_ramp(y, x, n, g0, g1) kern_cur->gain_ramp(y, x, n, g0, g1)
+#define kern_i16_to_f32(y, x, n, scale) kern_cur->i16_to_f32(y, x, n, scale)
+#define kern_f32_to_i16(y, x, n, scale) kern_cur->f32_to_i16(y, x, n, scale)
+#define kern_deinterleave(l, r, x, n) kern_cur->deinterleave(l, r, x, n)
+#define kern_interleave(x, l, r, n) kern_cur->interleave(x, l, r, n)
+#define kern_deinterleave_i16(l, r, x, n, scale) kern_cur->deinterleave_i16(l, r, x, n, scale)
+#define kern_interleave_i16(x, l, r, n, scale) kern_cur->interleave_i16(x, l, r, n, scale)
+#endif
+
+/* sum of a[i] * b[i] */
+float kern_dot_ref(const float *a, const float *b, int n);
+
+/*
+ * y[i] = sum of hr[k] * x[i + k] for k < taps, i < n. hr is the impulse
+ * response time reversed and x holds n + taps - 1 samples, the oldest
+ * first. y may be x.
+ */
+void kern_fir_ref(float *y, const float *x, const float *hr, int taps, int n);
+
+/* n frames of 4 channels in place */
+void kern_biquad4_run_ref(kern_biquad4 *bq, float *x, int n);
+
+/* largest |x[i]| for metering */
+float kern_maxabs_ref(const float *x, int n);
+
+float kern_sum_ref(const float *x, int n);
+
+/* y = sat(a * ga + b * gb) with Q15 gains, y may be a or b */
+void kern_mix_i16_ref(int16_t *y, const int16_t *a, const int16_t *b, int16_t ga, int16_t gb, int n);
+
+/* y = x * gain, gain going linearly from g0 at x[0] towards g1 at x[n] */
+void kern_gain_ramp_ref(float *y, const float *x, int n, float g0, float g1);
+
+/* y = x * scale, and back rounded and saturated */
+void kern_i16_to_f32_ref(float *y, const int16_t *x, int n, float scale);
+void kern_f32_to_i16_ref(int16_t *y, const float *x, int n, float scale);
+
+/* n stereo frames L R L R ... to and from separate channels */
+void kern_deinterleave_ref(float *l, float *r, const float *x, int n);
+void kern_interleave_ref(float *x, const float *l, const float *r, int n);
+
+/* same for codec frames, with the int16 conversion and scale */
+void kern_deinterleave_i16_ref(float *l, float *r, const int16_t *x, int n, float scale);
+void kern_interleave_i16_ref(int16_t *x, const float *l, const float *r, int n, float scale);
+
+#endif
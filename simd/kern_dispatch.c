@@ -0,0 +1,18 @@
+/*
+ * kern_dispatch.c - pick the kernel build for the CPU at startup
+ * 10-19-26 E. Brombaugh
+ */
+
+#include "cpu.h"
+#include "kern.h"
+
+/* safe to call before kern_init() */
+const kern_ops *kern_cur = &kern_ops_scalar;
+
+const kern_ops *kern_init(void)
+{
+	unsigned f = cpu_features();
+
+	kern_cur = (f & kern_ops_vec.needs) == kern_ops_vec.needs ? &kern_ops_vec : &kern_ops_scalar;
+	return kern_cur;
+}
@@ -0,0 +1,168 @@
+/*
+ * kern_ref.c - plain C references of the DSP kernels
+ * 10-19-26 E. Brombaugh
+ *
+ * These define what each kernel computes, the vector versions use them
+ * for the tails.
+ */
+
+#include <math.h>
+#include "kern.h"
+
+static inline int16_t kern_sat16(int32_t x)
+{
+	return x > 32767 ? 32767 : x < -32768 ? -32768 : x;
+}
+
+static inline int16_t kern_round16(float x)
+{
+	x = x > 32767.0f ? 32767.0f : x < -32768.0f ? -32768.0f : x;
+	return lrintf(x);
+}
+
+float kern_dot_ref(const float *a, const float *b, int n)
+{
+	float sum = 0.0f;
+	int i;
+
+	for(i=0;i<n;i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+void kern_fir_ref(float *y, const float *x, const float *hr, int taps, int n)
+{
+	int i, k;
+
+	for(i=0;i<n;i++)
+	{
+		float acc = 0.0f;
+
+		for(k=0;k<taps;k++)
+			acc += hr[k] * x[i + k];
+		y[i] = acc;
+	}
+}
+
+void kern_biquad4_run_ref(kern_biquad4 *bq, float *x, int n)
+{
+	int i, c;
+
+	for(c=0;c<4;c++)
+	{
+		float z1 = bq->z1[c], z2 = bq->z2[c];
+
+		for(i=0;i<n;i++)
+		{
+			float in = x[4*i + c];
+			float out = bq->b0[c] * in + z1;
+
+			z1 = bq->b1[c] * in + z2 - bq->a1[c] * out;
+			z2 = bq->b2[c] * in - bq->a2[c] * out;
+			x[4*i + c] = out;
+		}
+		bq->z1[c] = z1;
+		bq->z2[c] = z2;
+	}
+}
+
+float kern_maxabs_ref(const float *x, int n)
+{
+	float mx = 0.0f;
+	int i;
+
+	for(i=0;i<n;i++)
+		mx = fabsf(x[i]) > mx ? fabsf(x[i]) : mx;
+	return mx;
+}
+
+float kern_sum_ref(const float *x, int n)
+{
+	float sum = 0.0f;
+	int i;
+
+	for(i=0;i<n;i++)
+		sum += x[i];
+	return sum;
+}
+
+void kern_mix_i16_ref(int16_t *y, const int16_t *a, const int16_t *b, int16_t ga, int16_t gb, int n)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+		y[i] = kern_sat16(kern_sat16((a[i] * ga + 0x4000) >> 15) +
+			kern_sat16((b[i] * gb + 0x4000) >> 15));
+}
+
+void kern_gain_ramp_ref(float *y, const float *x, int n, float g0, float g1)
+{
+	float d;
+	int i;
+
+	if(n <= 0)
+		return;
+	d = (g1 - g0) / n;
+	for(i=0;i<n;i++)
+		y[i] = x[i] * (g0 + i * d);
+}
+
+void kern_i16_to_f32_ref(float *y, const int16_t *x, int n, float scale)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+		y[i] = x[i] * scale;
+}
+
+void kern_f32_to_i16_ref(int16_t *y, const float *x, int n, float scale)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+		y[i] = kern_round16(x[i] * scale);
+}
+
+void kern_deinterleave_ref(float *l, float *r, const float *x, int n)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		l[i] = x[2*i];
+		r[i] = x[2*i + 1];
+	}
+}
+
+void kern_interleave_ref(float *x, const float *l, const float *r, int n)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		x[2*i] = l[i];
+		x[2*i + 1] = r[i];
+	}
+}
+
+void kern_deinterleave_i16_ref(float *l, float *r, const int16_t *x, int n, float scale)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		l[i] = x[2*i] * scale;
+		r[i] = x[2*i + 1] * scale;
+	}
+}
+
+void kern_interleave_i16_ref(int16_t *x, const float *l, const float *r, int n, float scale)
+{
+	int i;
+
+	for(i=0;i<n;i++)
+	{
+		x[2*i] = kern_round16(l[i] * scale);
+		x[2*i + 1] = kern_round16(r[i] * scale);
+	}
+}
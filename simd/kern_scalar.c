@@ -0,0 +1,8 @@
+/*
+ * kern_scalar.c - the DSP kernels in plain C, runs everywhere
+ * 10-19-26 E. Brombaugh
+ */
+
+#define SIMD_FORCE_SCALAR
+#define KERN_OPS kern_ops_scalar
+#include "kern.c"
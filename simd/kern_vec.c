@@ -0,0 +1,8 @@
+/*
+ * kern_vec.c - the DSP kernels for the vector unit of the build flags,
+ * give this file the vector -march / -m options of the target
+ * 10-19-26 E. Brombaugh
+ */
+
+#define KERN_OPS kern_ops_vec
+#include "kern.c"
@@ -0,0 +1,751 @@
+/*
+ * simd.h - header-only portable SIMD layer
+ * 10-19-26 E. Brombaugh
+ * 10-19-26 E. Brombaugh - 8 wide AVX backend
+ *
+ * A kernel is written once against these inlines and builds for the C906
+ * (RVV, both the 0.7 xthead and the ratified 1.0 intrinsic spellings), for
+ * the host (SSE2, or 8-wide AVX when -mavx / -mavx2 is given, with FMA
+ * when -mfma is), for the ARM core of the Duo256M (NEON) and as plain C.
+ *
+ * The vectors hold 4 floats or 8 int16, i.e. 128 bits, which is VLEN on
+ * the C906. The one exception is the AVX backend with 8 floats per
+ * simd_f32. Loops step by SIMD_F32_LANES / SIMD_I16_LANES and finish the
+ * tail in scalar code, so results do not depend on which backend was used
+ * beyond FMA contraction and the order of the reductions.
+ *
+ * Define SIMD_FORCE_SCALAR to get the plain C backend on any target.
+ */
+
+#ifndef __simd__
+#define __simd__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(SIMD_FORCE_SCALAR)
+#define SIMD_BACKEND_SCALAR
+#elif defined(__riscv_vector)
+#define SIMD_BACKEND_RVV
+#elif defined(__AVX__)
+#define SIMD_BACKEND_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SIMD_BACKEND_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_BACKEND_NEON
+#else
+#define SIMD_BACKEND_SCALAR
+#endif
+
+#if defined(SIMD_BACKEND_AVX)
+#define SIMD_F32_LANES 8
+#else
+#define SIMD_F32_LANES 4
+#endif
+#define SIMD_I16_LANES 8
+
+#define SIMD_INLINE static inline __attribute__((always_inline))
+
+/* ---------------------------------------------------------------------- */
+#if defined(SIMD_BACKEND_RVV)
+
+#include <riscv_vector.h>
+
+/*
+ * The ratified intrinsics (__riscv_v_intrinsic >= 11000, GCC 13+) carry a
+ * __riscv_ prefix. The Xuantie toolchain for rv64imafdcv0p7xthead uses the
+ * older unprefixed names, which otherwise match for everything but the
+ * reductions, vsmul and the fractional LMUL / tuple types below.
+ */
+#if defined(__riscv_v_intrinsic) && __riscv_v_intrinsic >= 11000
+#define SIMD_RVV_V1
+#define SIMD_RV(x) __riscv_##x
+#define SIMD_NAME "rvv1.0"
+#else
+#define SIMD_RV(x) x
+#define SIMD_NAME "rvv0.7"
+#endif
+
+typedef vfloat32m1_t simd_f32;
+typedef vint16m1_t simd_i16;
+
+#define SIMD_VL32 SIMD_RV(vsetvl_e32m1)(SIMD_F32_LANES)
+#define SIMD_VL16 SIMD_RV(vsetvl_e16m1)(SIMD_I16_LANES)
+
+SIMD_INLINE simd_f32 simd_zero_f32(void) { return SIMD_RV(vfmv_v_f_f32m1)(0.0f, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_set1_f32(float x) { return SIMD_RV(vfmv_v_f_f32m1)(x, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_load_f32(const float *p) { return SIMD_RV(vle32_v_f32m1)(p, SIMD_VL32); }
+SIMD_INLINE void simd_store_f32(float *p, simd_f32 v) { SIMD_RV(vse32_v_f32m1)(p, v, SIMD_VL32); }
+
+SIMD_INLINE simd_f32 simd_load_strided_f32(const float *p, ptrdiff_t stride)
+{
+	return SIMD_RV(vlse32_v_f32m1)(p, stride * sizeof(float), SIMD_VL32);
+}
+
+SIMD_INLINE void simd_store_strided_f32(float *p, ptrdiff_t stride, simd_f32 v)
+{
+	SIMD_RV(vsse32_v_f32m1)(p, stride * sizeof(float), v, SIMD_VL32);
+}
+
+SIMD_INLINE void simd_load2_f32(const float *p, simd_f32 *a, simd_f32 *b)
+{
+#if defined(SIMD_RVV_V1)
+	vfloat32m1x2_t t = __riscv_vlseg2e32_v_f32m1x2(p, SIMD_VL32);
+	*a = __riscv_vget_v_f32m1x2_f32m1(t, 0);
+	*b = __riscv_vget_v_f32m1x2_f32m1(t, 1);
+#elif defined(SIMD_RVV_SEG)
+	vlseg2e32_v_f32m1(a, b, p, SIMD_VL32);
+#else
+	/* two strided loads, see try_vec func3 for vlseg2e32 */
+	*a = vlse32_v_f32m1(p, 2 * sizeof(float), SIMD_VL32);
+	*b = vlse32_v_f32m1(p + 1, 2 * sizeof(float), SIMD_VL32);
+#endif
+}
+
+SIMD_INLINE void simd_store2_f32(float *p, simd_f32 a, simd_f32 b)
+{
+#if defined(SIMD_RVV_V1)
+	vfloat32m1x2_t t = __riscv_vundefined_f32m1x2();
+	t = __riscv_vset_v_f32m1_f32m1x2(t, 0, a);
+	t = __riscv_vset_v_f32m1_f32m1x2(t, 1, b);
+	__riscv_vsseg2e32_v_f32m1x2(p, t, SIMD_VL32);
+#elif defined(SIMD_RVV_SEG)
+	vsseg2e32_v_f32m1(p, a, b, SIMD_VL32);
+#else
+	vsse32_v_f32m1(p, 2 * sizeof(float), a, SIMD_VL32);
+	vsse32_v_f32m1(p + 1, 2 * sizeof(float), b, SIMD_VL32);
+#endif
+}
+
+SIMD_INLINE simd_f32 simd_add_f32(simd_f32 a, simd_f32 b) { return SIMD_RV(vfadd_vv_f32m1)(a, b, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_sub_f32(simd_f32 a, simd_f32 b) { return SIMD_RV(vfsub_vv_f32m1)(a, b, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_mul_f32(simd_f32 a, simd_f32 b) { return SIMD_RV(vfmul_vv_f32m1)(a, b, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_min_f32(simd_f32 a, simd_f32 b) { return SIMD_RV(vfmin_vv_f32m1)(a, b, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_max_f32(simd_f32 a, simd_f32 b) { return SIMD_RV(vfmax_vv_f32m1)(a, b, SIMD_VL32); }
+SIMD_INLINE simd_f32 simd_abs_f32(simd_f32 a) { return SIMD_RV(vfabs_v_f32m1)(a, SIMD_VL32); }
+
+/* a * b + c */
+SIMD_INLINE simd_f32 simd_fma_f32(simd_f32 a, simd_f32 b, simd_f32 c)
+{
+	return SIMD_RV(vfmacc_vv_f32m1)(c, a, b, SIMD_VL32);
+}
+
+SIMD_INLINE float simd_hsum_f32(simd_f32 a)
+{
+#if defined(SIMD_RVV_V1)
+	vfloat32m1_t s = __riscv_vfredusum_vs_f32m1_f32m1(a, simd_zero_f32(), SIMD_VL32);
+	return __riscv_vfmv_f_s_f32m1_f32(s);
+#else
+	vfloat32m1_t s = vfredsum_vs_f32m1_f32m1(a, a, simd_zero_f32(), SIMD_VL32);
+	return vfmv_f_s_f32m1_f32(s);
+#endif
+}
+
+SIMD_INLINE float simd_hmax_f32(simd_f32 a)
+{
+#if defined(SIMD_RVV_V1)
+	vfloat32m1_t s = __riscv_vfredmax_vs_f32m1_f32m1(a, a, SIMD_VL32);
+	return __riscv_vfmv_f_s_f32m1_f32(s);
+#else
+	vfloat32m1_t s = vfredmax_vs_f32m1_f32m1(a, a, a, SIMD_VL32);
+	return vfmv_f_s_f32m1_f32(s);
+#endif
+}
+
+/* 4 int16 to float, no scaling */
+SIMD_INLINE simd_f32 simd_load_i16_f32(const int16_t *p)
+{
+#if defined(SIMD_RVV_V1)
+	vint32m1_t w = __riscv_vsext_vf2_i32m1(__riscv_vle16_v_i16mf2(p, SIMD_VL32), SIMD_VL32);
+	return __riscv_vfcvt_f_x_v_f32m1(w, SIMD_VL32);
+#else
+	/* no fractional LMUL on 0.7, widen through the stack */
+	int32_t t[SIMD_F32_LANES] = {p[0], p[1], p[2], p[3]};
+	return vfcvt_f_x_v_f32m1(vle32_v_i32m1(t, SIMD_VL32), SIMD_VL32);
+#endif
+}
+
+/* round to nearest and saturate to int16 */
+SIMD_INLINE vint32m1_t simd_rvv_sat16(simd_f32 v)
+{
+	vint32m1_t w = SIMD_RV(vfcvt_x_f_v_i32m1)(v, SIMD_VL32);
+	w = SIMD_RV(vmax_vx_i32m1)(w, -32768, SIMD_VL32);
+	return SIMD_RV(vmin_vx_i32m1)(w, 32767, SIMD_VL32);
+}
+
+SIMD_INLINE void simd_store_f32_i16(int16_t *p, simd_f32 v)
+{
+#if defined(SIMD_RVV_V1)
+	vint32m1_t w = __riscv_vfcvt_x_f_v_i32m1(v, SIMD_VL32);
+	__riscv_vse16_v_i16mf2(p, __riscv_vnclip_wx_i16mf2(w, 0, __RISCV_VXRM_RNU, SIMD_VL32), SIMD_VL32);
+#else
+	int32_t t[SIMD_F32_LANES];
+	vse32_v_i32m1(t, simd_rvv_sat16(v), SIMD_VL32);
+	p[0] = t[0]; p[1] = t[1]; p[2] = t[2]; p[3] = t[3];
+#endif
+}
+
+/*
+ * 8 interleaved int16 (L R L R ...) to 4 + 4 floats. Each L/R pair is
+ * one 32 bit word, so the split is two shifts and works in both spellings.
+ */
+SIMD_INLINE void simd_load2_i16_f32(const int16_t *p, simd_f32 *a, simd_f32 *b)
+{
+	vint32m1_t w = SIMD_RV(vle32_v_i32m1)((const int32_t *)p, SIMD_VL32);
+	vint32m1_t l = SIMD_RV(vsra_vx_i32m1)(SIMD_RV(vsll_vx_i32m1)(w, 16, SIMD_VL32), 16, SIMD_VL32);
+	vint32m1_t r = SIMD_RV(vsra_vx_i32m1)(w, 16, SIMD_VL32);
+	*a = SIMD_RV(vfcvt_f_x_v_f32m1)(l, SIMD_VL32);
+	*b = SIMD_RV(vfcvt_f_x_v_f32m1)(r, SIMD_VL32);
+}
+
+SIMD_INLINE void simd_store2_f32_i16(int16_t *p, simd_f32 a, simd_f32 b)
+{
+	vint32m1_t l = SIMD_RV(vand_vx_i32m1)(simd_rvv_sat16(a), 0xffff, SIMD_VL32);
+	vint32m1_t r = SIMD_RV(vsll_vx_i32m1)(simd_rvv_sat16(b), 16, SIMD_VL32);
+	SIMD_RV(vse32_v_i32m1)((int32_t *)p, SIMD_RV(vor_vv_i32m1)(l, r, SIMD_VL32), SIMD_VL32);
+}
+
+SIMD_INLINE simd_i16 simd_set1_i16(int16_t x) { return SIMD_RV(vmv_v_x_i16m1)(x, SIMD_VL16); }
+SIMD_INLINE simd_i16 simd_load_i16(const int16_t *p) { return SIMD_RV(vle16_v_i16m1)(p, SIMD_VL16); }
+SIMD_INLINE void simd_store_i16(int16_t *p, simd_i16 v) { SIMD_RV(vse16_v_i16m1)(p, v, SIMD_VL16); }
+SIMD_INLINE simd_i16 simd_adds_i16(simd_i16 a, simd_i16 b) { return SIMD_RV(vsadd_vv_i16m1)(a, b, SIMD_VL16); }
+SIMD_INLINE simd_i16 simd_subs_i16(simd_i16 a, simd_i16 b) { return SIMD_RV(vssub_vv_i16m1)(a, b, SIMD_VL16); }
+
+/* Q15 multiply, rounded and saturated: (a * b + 0x4000) >> 15 */
+SIMD_INLINE simd_i16 simd_mulq15_i16(simd_i16 a, simd_i16 b)
+{
+#if defined(SIMD_RVV_V1)
+	return __riscv_vsmul_vv_i16m1(a, b, __RISCV_VXRM_RNU, SIMD_VL16);
+#else
+	/* rounding comes from vxrm, round-to-nearest-up after reset */
+	return vsmul_vv_i16m1(a, b, SIMD_VL16);
+#endif
+}
+
+/* ---------------------------------------------------------------------- */
+#elif defined(SIMD_BACKEND_AVX)
+
+/*
+ * 8 floats per simd_f32. AVX has no 256 bit integer ops, so simd_i16 stays
+ * the 8 lane SSE2 one and the conversions go through two 128 bit halves.
+ */
+#include <immintrin.h>
+#if defined(__FMA__)
+#define SIMD_NAME "avx+fma"
+#else
+#define SIMD_NAME "avx"
+#endif
+
+typedef __m256 simd_f32;
+typedef __m128i simd_i16;
+
+SIMD_INLINE simd_f32 simd_zero_f32(void) { return _mm256_setzero_ps(); }
+SIMD_INLINE simd_f32 simd_set1_f32(float x) { return _mm256_set1_ps(x); }
+SIMD_INLINE simd_f32 simd_load_f32(const float *p) { return _mm256_loadu_ps(p); }
+SIMD_INLINE void simd_store_f32(float *p, simd_f32 v) { _mm256_storeu_ps(p, v); }
+
+SIMD_INLINE simd_f32 simd_load_strided_f32(const float *p, ptrdiff_t stride)
+{
+	return _mm256_setr_ps(p[0], p[stride], p[2 * stride], p[3 * stride],
+		p[4 * stride], p[5 * stride], p[6 * stride], p[7 * stride]);
+}
+
+SIMD_INLINE void simd_store_strided_f32(float *p, ptrdiff_t stride, simd_f32 v)
+{
+	float t[SIMD_F32_LANES];
+	int i;
+
+	_mm256_storeu_ps(t, v);
+	for(i=0;i<SIMD_F32_LANES;i++)
+		p[i * stride] = t[i];
+}
+
+/* shuffle_ps works within 128 bit halves, so pair the halves up first */
+SIMD_INLINE void simd_load2_f32(const float *p, simd_f32 *a, simd_f32 *b)
+{
+	__m256 x = _mm256_loadu_ps(p), y = _mm256_loadu_ps(p + 8);
+	__m256 lo = _mm256_permute2f128_ps(x, y, 0x20), hi = _mm256_permute2f128_ps(x, y, 0x31);
+	*a = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+	*b = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+SIMD_INLINE void simd_store2_f32(float *p, simd_f32 a, simd_f32 b)
+{
+	__m256 lo = _mm256_unpacklo_ps(a, b), hi = _mm256_unpackhi_ps(a, b);
+	_mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+	_mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+SIMD_INLINE simd_f32 simd_add_f32(simd_f32 a, simd_f32 b) { return _mm256_add_ps(a, b); }
+SIMD_INLINE simd_f32 simd_sub_f32(simd_f32 a, simd_f32 b) { return _mm256_sub_ps(a, b); }
+SIMD_INLINE simd_f32 simd_mul_f32(simd_f32 a, simd_f32 b) { return _mm256_mul_ps(a, b); }
+SIMD_INLINE simd_f32 simd_min_f32(simd_f32 a, simd_f32 b) { return _mm256_min_ps(a, b); }
+SIMD_INLINE simd_f32 simd_max_f32(simd_f32 a, simd_f32 b) { return _mm256_max_ps(a, b); }
+SIMD_INLINE simd_f32 simd_abs_f32(simd_f32 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+/* a * b + c */
+SIMD_INLINE simd_f32 simd_fma_f32(simd_f32 a, simd_f32 b, simd_f32 c)
+{
+#if defined(__FMA__)
+	return _mm256_fmadd_ps(a, b, c);
+#else
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+SIMD_INLINE float simd_hsum_f32(simd_f32 a)
+{
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+}
+
+SIMD_INLINE float simd_hmax_f32(simd_f32 a)
+{
+	__m128 s = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+}
+
+/* two halves of 4 int32 to 8 floats */
+SIMD_INLINE simd_f32 simd_avx_cvt_f32(__m128i lo, __m128i hi)
+{
+	return _mm256_cvtepi32_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+}
+
+/* 8 int16 to float, no scaling */
+SIMD_INLINE simd_f32 simd_load_i16_f32(const int16_t *p)
+{
+	__m128i x = _mm_loadu_si128((const __m128i *)p);
+	return simd_avx_cvt_f32(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16),
+		_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+}
+
+/* round to nearest, clamped first since cvtps gives 0x80000000 on overflow */
+SIMD_INLINE __m256i simd_avx_cvt32(simd_f32 v)
+{
+	v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f));
+	return _mm256_cvtps_epi32(v);
+}
+
+SIMD_INLINE void simd_store_f32_i16(int16_t *p, simd_f32 v)
+{
+	__m256i w = simd_avx_cvt32(v);
+	_mm_storeu_si128((__m128i *)p, _mm_packs_epi32(_mm256_castsi256_si128(w), _mm256_extractf128_si256(w, 1)));
+}
+
+/* 16 interleaved int16 (L R L R ...) to 8 + 8 floats */
+SIMD_INLINE void simd_load2_i16_f32(const int16_t *p, simd_f32 *a, simd_f32 *b)
+{
+	__m128i x = _mm_loadu_si128((const __m128i *)p), y = _mm_loadu_si128((const __m128i *)(p + 8));
+	*a = simd_avx_cvt_f32(_mm_srai_epi32(_mm_slli_epi32(x, 16), 16), _mm_srai_epi32(_mm_slli_epi32(y, 16), 16));
+	*b = simd_avx_cvt_f32(_mm_srai_epi32(x, 16), _mm_srai_epi32(y, 16));
+}
+
+SIMD_INLINE void simd_store2_f32_i16(int16_t *p, simd_f32 a, simd_f32 b)
+{
+	__m256i l = simd_avx_cvt32(a), r = simd_avx_cvt32(b);
+	__m128i l0 = _mm256_castsi256_si128(l), l1 = _mm256_extractf128_si256(l, 1);
+	__m128i r0 = _mm256_castsi256_si128(r), r1 = _mm256_extractf128_si256(r, 1);
+	_mm_storeu_si128((__m128i *)p, _mm_packs_epi32(_mm_unpacklo_epi32(l0, r0), _mm_unpackhi_epi32(l0, r0)));
+	_mm_storeu_si128((__m128i *)(p + 8), _mm_packs_epi32(_mm_unpacklo_epi32(l1, r1), _mm_unpackhi_epi32(l1, r1)));
+}
+
+SIMD_INLINE simd_i16 simd_set1_i16(int16_t x) { return _mm_set1_epi16(x); }
+SIMD_INLINE simd_i16 simd_load_i16(const int16_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+SIMD_INLINE void simd_store_i16(int16_t *p, simd_i16 v) { _mm_storeu_si128((__m128i *)p, v); }
+SIMD_INLINE simd_i16 simd_adds_i16(simd_i16 a, simd_i16 b) { return _mm_adds_epi16(a, b); }
+SIMD_INLINE simd_i16 simd_subs_i16(simd_i16 a, simd_i16 b) { return _mm_subs_epi16(a, b); }
+
+/* Q15 multiply, rounded and saturated: (a * b + 0x4000) >> 15 */
+SIMD_INLINE simd_i16 simd_mulq15_i16(simd_i16 a, simd_i16 b)
+{
+	__m128i lo = _mm_mullo_epi16(a, b), hi = _mm_mulhi_epi16(a, b);
+	__m128i r = _mm_set1_epi32(0x4000);
+	__m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), r), 15);
+	__m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), r), 15);
+	return _mm_packs_epi32(p0, p1);
+}
+
+/* ---------------------------------------------------------------------- */
+#elif defined(SIMD_BACKEND_SSE)
+
+#include <emmintrin.h>
+#if defined(__FMA__)
+#include <immintrin.h>
+#define SIMD_NAME "sse+fma"
+#else
+#define SIMD_NAME "sse2"
+#endif
+
+typedef __m128 simd_f32;
+typedef __m128i simd_i16;
+
+SIMD_INLINE simd_f32 simd_zero_f32(void) { return _mm_setzero_ps(); }
+SIMD_INLINE simd_f32 simd_set1_f32(float x) { return _mm_set1_ps(x); }
+SIMD_INLINE simd_f32 simd_load_f32(const float *p) { return _mm_loadu_ps(p); }
+SIMD_INLINE void simd_store_f32(float *p, simd_f32 v) { _mm_storeu_ps(p, v); }
+
+SIMD_INLINE simd_f32 simd_load_strided_f32(const float *p, ptrdiff_t stride)
+{
+	return _mm_setr_ps(p[0], p[stride], p[2 * stride], p[3 * stride]);
+}
+
+SIMD_INLINE void simd_store_strided_f32(float *p, ptrdiff_t stride, simd_f32 v)
+{
+	float t[SIMD_F32_LANES];
+	_mm_storeu_ps(t, v);
+	p[0] = t[0]; p[stride] = t[1]; p[2 * stride] = t[2]; p[3 * stride] = t[3];
+}
+
+SIMD_INLINE void simd_load2_f32(const float *p, simd_f32 *a, simd_f32 *b)
+{
+	__m128 x = _mm_loadu_ps(p), y = _mm_loadu_ps(p + 4);
+	*a = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	*b = _mm_shuffle_ps(x, y, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+SIMD_INLINE void simd_store2_f32(float *p, simd_f32 a, simd_f32 b)
+{
+	_mm_storeu_ps(p, _mm_unpacklo_ps(a, b));
+	_mm_storeu_ps(p + 4, _mm_unpackhi_ps(a, b));
+}
+
+SIMD_INLINE simd_f32 simd_add_f32(simd_f32 a, simd_f32 b) { return _mm_add_ps(a, b); }
+SIMD_INLINE simd_f32 simd_sub_f32(simd_f32 a, simd_f32 b) { return _mm_sub_ps(a, b); }
+SIMD_INLINE simd_f32 simd_mul_f32(simd_f32 a, simd_f32 b) { return _mm_mul_ps(a, b); }
+SIMD_INLINE simd_f32 simd_min_f32(simd_f32 a, simd_f32 b) { return _mm_min_ps(a, b); }
+SIMD_INLINE simd_f32 simd_max_f32(simd_f32 a, simd_f32 b) { return _mm_max_ps(a, b); }
+SIMD_INLINE simd_f32 simd_abs_f32(simd_f32 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+/* a * b + c */
+SIMD_INLINE simd_f32 simd_fma_f32(simd_f32 a, simd_f32 b, simd_f32 c)
+{
+#if defined(__FMA__)
+	return _mm_fmadd_ps(a, b, c);
+#else
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+SIMD_INLINE float simd_hsum_f32(simd_f32 a)
+{
+	a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	a = _mm_add_ss(a, _mm_shuffle_ps(a, a, 1));
+	return _mm_cvtss_f32(a);
+}
+
+SIMD_INLINE float simd_hmax_f32(simd_f32 a)
+{
+	a = _mm_max_ps(a, _mm_movehl_ps(a, a));
+	a = _mm_max_ss(a, _mm_shuffle_ps(a, a, 1));
+	return _mm_cvtss_f32(a);
+}
+
+/* 4 int16 to float, no scaling */
+SIMD_INLINE simd_f32 simd_load_i16_f32(const int16_t *p)
+{
+	__m128i x = _mm_loadl_epi64((const __m128i *)p);
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+
+/* round to nearest, clamped first since cvtps gives 0x80000000 on overflow */
+SIMD_INLINE __m128i simd_sse_cvt32(simd_f32 v)
+{
+	v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+	return _mm_cvtps_epi32(v);
+}
+
+SIMD_INLINE void simd_store_f32_i16(int16_t *p, simd_f32 v)
+{
+	__m128i w = simd_sse_cvt32(v);
+	_mm_storel_epi64((__m128i *)p, _mm_packs_epi32(w, w));
+}
+
+/* 8 interleaved int16 (L R L R ...) to 4 + 4 floats */
+SIMD_INLINE void simd_load2_i16_f32(const int16_t *p, simd_f32 *a, simd_f32 *b)
+{
+	__m128i x = _mm_loadu_si128((const __m128i *)p);
+	*a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(x, 16), 16));
+	*b = _mm_cvtepi32_ps(_mm_srai_epi32(x, 16));
+}
+
+SIMD_INLINE void simd_store2_f32_i16(int16_t *p, simd_f32 a, simd_f32 b)
+{
+	__m128i l = simd_sse_cvt32(a), r = simd_sse_cvt32(b);
+	_mm_storeu_si128((__m128i *)p, _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
+}
+
+SIMD_INLINE simd_i16 simd_set1_i16(int16_t x) { return _mm_set1_epi16(x); }
+SIMD_INLINE simd_i16 simd_load_i16(const int16_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+SIMD_INLINE void simd_store_i16(int16_t *p, simd_i16 v) { _mm_storeu_si128((__m128i *)p, v); }
+SIMD_INLINE simd_i16 simd_adds_i16(simd_i16 a, simd_i16 b) { return _mm_adds_epi16(a, b); }
+SIMD_INLINE simd_i16 simd_subs_i16(simd_i16 a, simd_i16 b) { return _mm_subs_epi16(a, b); }
+
+/* Q15 multiply, rounded and saturated: (a * b + 0x4000) >> 15 */
+SIMD_INLINE simd_i16 simd_mulq15_i16(simd_i16 a, simd_i16 b)
+{
+	__m128i lo = _mm_mullo_epi16(a, b), hi = _mm_mulhi_epi16(a, b);
+	__m128i r = _mm_set1_epi32(0x4000);
+	__m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), r), 15);
+	__m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), r), 15);
+	return _mm_packs_epi32(p0, p1);
+}
+
+/* ---------------------------------------------------------------------- */
+#elif defined(SIMD_BACKEND_NEON)
+
+#include <arm_neon.h>
+#define SIMD_NAME "neon"
+
+typedef float32x4_t simd_f32;
+typedef int16x8_t simd_i16;
+
+SIMD_INLINE simd_f32 simd_zero_f32(void) { return vdupq_n_f32(0.0f); }
+SIMD_INLINE simd_f32 simd_set1_f32(float x) { return vdupq_n_f32(x); }
+SIMD_INLINE simd_f32 simd_load_f32(const float *p) { return vld1q_f32(p); }
+SIMD_INLINE void simd_store_f32(float *p, simd_f32 v) { vst1q_f32(p, v); }
+
+SIMD_INLINE simd_f32 simd_load_strided_f32(const float *p, ptrdiff_t stride)
+{
+	float t[SIMD_F32_LANES] = {p[0], p[stride], p[2 * stride], p[3 * stride]};
+	return vld1q_f32(t);
+}
+
+SIMD_INLINE void simd_store_strided_f32(float *p, ptrdiff_t stride, simd_f32 v)
+{
+	p[0] = vgetq_lane_f32(v, 0);
+	p[stride] = vgetq_lane_f32(v, 1);
+	p[2 * stride] = vgetq_lane_f32(v, 2);
+	p[3 * stride] = vgetq_lane_f32(v, 3);
+}
+
+SIMD_INLINE void simd_load2_f32(const float *p, simd_f32 *a, simd_f32 *b)
+{
+	float32x4x2_t t = vld2q_f32(p);
+	*a = t.val[0];
+	*b = t.val[1];
+}
+
+SIMD_INLINE void simd_store2_f32(float *p, simd_f32 a, simd_f32 b)
+{
+	float32x4x2_t t = {{a, b}};
+	vst2q_f32(p, t);
+}
+
+SIMD_INLINE simd_f32 simd_add_f32(simd_f32 a, simd_f32 b) { return vaddq_f32(a, b); }
+SIMD_INLINE simd_f32 simd_sub_f32(simd_f32 a, simd_f32 b) { return vsubq_f32(a, b); }
+SIMD_INLINE simd_f32 simd_mul_f32(simd_f32 a, simd_f32 b) { return vmulq_f32(a, b); }
+SIMD_INLINE simd_f32 simd_min_f32(simd_f32 a, simd_f32 b) { return vminq_f32(a, b); }
+SIMD_INLINE simd_f32 simd_max_f32(simd_f32 a, simd_f32 b) { return vmaxq_f32(a, b); }
+SIMD_INLINE simd_f32 simd_abs_f32(simd_f32 a) { return vabsq_f32(a); }
+
+/* a * b + c */
+SIMD_INLINE simd_f32 simd_fma_f32(simd_f32 a, simd_f32 b, simd_f32 c)
+{
+#if defined(__aarch64__)
+	return vfmaq_f32(c, a, b);
+#else
+	return vmlaq_f32(c, a, b);
+#endif
+}
+
+SIMD_INLINE float simd_hsum_f32(simd_f32 a)
+{
+	float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+	return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+SIMD_INLINE float simd_hmax_f32(simd_f32 a)
+{
+	float32x2_t s = vmax_f32(vget_low_f32(a), vget_high_f32(a));
+	return vget_lane_f32(vpmax_f32(s, s), 0);
+}
+
+/* 4 int16 to float, no scaling */
+SIMD_INLINE simd_f32 simd_load_i16_f32(const int16_t *p)
+{
+	return vcvtq_f32_s32(vmovl_s16(vld1_s16(p)));
+}
+
+/* round to nearest and saturate to int16 */
+SIMD_INLINE int16x4_t simd_neon_sat16(simd_f32 v)
+{
+#if defined(__aarch64__)
+	int32x4_t w = vcvtnq_s32_f32(v);
+#else
+	/* armv7 only truncates, add half away from zero first */
+	uint32x4_t neg = vcltq_f32(v, vdupq_n_f32(0.0f));
+	int32x4_t w = vcvtq_s32_f32(vaddq_f32(v, vbslq_f32(neg, vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f))));
+#endif
+	return vqmovn_s32(w);
+}
+
+SIMD_INLINE void simd_store_f32_i16(int16_t *p, simd_f32 v)
+{
+	vst1_s16(p, simd_neon_sat16(v));
+}
+
+/* 8 interleaved int16 (L R L R ...) to 4 + 4 floats */
+SIMD_INLINE void simd_load2_i16_f32(const int16_t *p, simd_f32 *a, simd_f32 *b)
+{
+	int16x4x2_t t = vld2_s16(p);
+	*a = vcvtq_f32_s32(vmovl_s16(t.val[0]));
+	*b = vcvtq_f32_s32(vmovl_s16(t.val[1]));
+}
+
+SIMD_INLINE void simd_store2_f32_i16(int16_t *p, simd_f32 a, simd_f32 b)
+{
+	int16x4x2_t t = {{simd_neon_sat16(a), simd_neon_sat16(b)}};
+	vst2_s16(p, t);
+}
+
+SIMD_INLINE simd_i16 simd_set1_i16(int16_t x) { return vdupq_n_s16(x); }
+SIMD_INLINE simd_i16 simd_load_i16(const int16_t *p) { return vld1q_s16(p); }
+SIMD_INLINE void simd_store_i16(int16_t *p, simd_i16 v) { vst1q_s16(p, v); }
+SIMD_INLINE simd_i16 simd_adds_i16(simd_i16 a, simd_i16 b) { return vqaddq_s16(a, b); }
+SIMD_INLINE simd_i16 simd_subs_i16(simd_i16 a, simd_i16 b) { return vqsubq_s16(a, b); }
+
+/* Q15 multiply, rounded and saturated: (a * b + 0x4000) >> 15 */
+SIMD_INLINE simd_i16 simd_mulq15_i16(simd_i16 a, simd_i16 b) { return vqrdmulhq_s16(a, b); }
+
+/* ---------------------------------------------------------------------- */
+#else /* SIMD_BACKEND_SCALAR */
+
+#define SIMD_NAME "scalar"
+
+typedef struct { float v[SIMD_F32_LANES]; } simd_f32;
+typedef struct { int16_t v[SIMD_I16_LANES]; } simd_i16;
+
+#define SIMD_F32_LOOP(r, expr) { int i; for(i=0;i<SIMD_F32_LANES;i++) r.v[i] = (expr); }
+#define SIMD_I16_LOOP(r, expr) { int i; for(i=0;i<SIMD_I16_LANES;i++) r.v[i] = (expr); }
+
+SIMD_INLINE int16_t simd_sat16(int32_t x)
+{
+	return x > 32767 ? 32767 : x < -32768 ? -32768 : x;
+}
+
+/*
+ * round half to even like the vector units - adding 1.5 * 2^23 leaves no
+ * fraction bits, the FPU does the rounding
+ */
+SIMD_INLINE int16_t simd_f32_to_i16(float x)
+{
+	x = x > 32767.0f ? 32767.0f : x < -32768.0f ? -32768.0f : x;
+	return (int16_t)((x + 12582912.0f) - 12582912.0f);
+}
+
+SIMD_INLINE simd_f32 simd_set1_f32(float x) { simd_f32 r; SIMD_F32_LOOP(r, x); return r; }
+SIMD_INLINE simd_f32 simd_zero_f32(void) { return simd_set1_f32(0.0f); }
+SIMD_INLINE simd_f32 simd_load_f32(const float *p) { simd_f32 r; SIMD_F32_LOOP(r, p[i]); return r; }
+SIMD_INLINE void simd_store_f32(float *p, simd_f32 v) { int i; for(i=0;i<SIMD_F32_LANES;i++) p[i] = v.v[i]; }
+
+SIMD_INLINE simd_f32 simd_load_strided_f32(const float *p, ptrdiff_t stride)
+{
+	simd_f32 r;
+	SIMD_F32_LOOP(r, p[i * stride]);
+	return r;
+}
+
+SIMD_INLINE void simd_store_strided_f32(float *p, ptrdiff_t stride, simd_f32 v)
+{
+	int i;
+	for(i=0;i<SIMD_F32_LANES;i++)
+		p[i * stride] = v.v[i];
+}
+
+SIMD_INLINE void simd_load2_f32(const float *p, simd_f32 *a, simd_f32 *b)
+{
+	*a = simd_load_strided_f32(p, 2);
+	*b = simd_load_strided_f32(p + 1, 2);
+}
+
+SIMD_INLINE void simd_store2_f32(float *p, simd_f32 a, simd_f32 b)
+{
+	simd_store_strided_f32(p, 2, a);
+	simd_store_strided_f32(p + 1, 2, b);
+}
+
+SIMD_INLINE simd_f32 simd_add_f32(simd_f32 a, simd_f32 b) { simd_f32 r; SIMD_F32_LOOP(r, a.v[i] + b.v[i]); return r; }
+SIMD_INLINE simd_f32 simd_sub_f32(simd_f32 a, simd_f32 b) { simd_f32 r; SIMD_F32_LOOP(r, a.v[i] - b.v[i]); return r; }
+SIMD_INLINE simd_f32 simd_mul_f32(simd_f32 a, simd_f32 b) { simd_f32 r; SIMD_F32_LOOP(r, a.v[i] * b.v[i]); return r; }
+SIMD_INLINE simd_f32 simd_min_f32(simd_f32 a, simd_f32 b) { simd_f32 r; SIMD_F32_LOOP(r, a.v[i] < b.v[i] ? a.v[i] : b.v[i]); return r; }
+SIMD_INLINE simd_f32 simd_max_f32(simd_f32 a, simd_f32 b) { simd_f32 r; SIMD_F32_LOOP(r, a.v[i] > b.v[i] ? a.v[i] : b.v[i]); return r; }
+SIMD_INLINE simd_f32 simd_abs_f32(simd_f32 a) { simd_f32 r; SIMD_F32_LOOP(r, a.v[i] < 0.0f ? -a.v[i] : a.v[i]); return r; }
+
+/* a * b + c */
+SIMD_INLINE simd_f32 simd_fma_f32(simd_f32 a, simd_f32 b, simd_f32 c)
+{
+	simd_f32 r;
+	SIMD_F32_LOOP(r, a.v[i] * b.v[i] + c.v[i]);
+	return r;
+}
+
+SIMD_INLINE float simd_hsum_f32(simd_f32 a)
+{
+	return (a.v[0] + a.v[2]) + (a.v[1] + a.v[3]);
+}
+
+SIMD_INLINE float simd_hmax_f32(simd_f32 a)
+{
+	float m = a.v[0];
+	int i;
+	for(i=1;i<SIMD_F32_LANES;i++)
+		m = a.v[i] > m ? a.v[i] : m;
+	return m;
+}
+
+/* 4 int16 to float, no scaling */
+SIMD_INLINE simd_f32 simd_load_i16_f32(const int16_t *p)
+{
+	simd_f32 r;
+	SIMD_F32_LOOP(r, (float)p[i]);
+	return r;
+}
+
+SIMD_INLINE void simd_store_f32_i16(int16_t *p, simd_f32 v)
+{
+	int i;
+	for(i=0;i<SIMD_F32_LANES;i++)
+		p[i] = simd_f32_to_i16(v.v[i]);
+}
+
+/* 8 interleaved int16 (L R L R ...) to 4 + 4 floats */
+SIMD_INLINE void simd_load2_i16_f32(const int16_t *p, simd_f32 *a, simd_f32 *b)
+{
+	SIMD_F32_LOOP((*a), (float)p[2 * i]);
+	SIMD_F32_LOOP((*b), (float)p[2 * i + 1]);
+}
+
+SIMD_INLINE void simd_store2_f32_i16(int16_t *p, simd_f32 a, simd_f32 b)
+{
+	int i;
+	for(i=0;i<SIMD_F32_LANES;i++)
+	{
+		p[2 * i] = simd_f32_to_i16(a.v[i]);
+		p[2 * i + 1] = simd_f32_to_i16(b.v[i]);
+	}
+}
+
+SIMD_INLINE simd_i16 simd_set1_i16(int16_t x) { simd_i16 r; SIMD_I16_LOOP(r, x); return r; }
+SIMD_INLINE simd_i16 simd_load_i16(const int16_t *p) { simd_i16 r; SIMD_I16_LOOP(r, p[i]); return r; }
+SIMD_INLINE void simd_store_i16(int16_t *p, simd_i16 v) { int i; for(i=0;i<SIMD_I16_LANES;i++) p[i] = v.v[i]; }
+SIMD_INLINE simd_i16 simd_adds_i16(simd_i16 a, simd_i16 b) { simd_i16 r; SIMD_I16_LOOP(r, simd_sat16(a.v[i] + b.v[i])); return r; }
+SIMD_INLINE simd_i16 simd_subs_i16(simd_i16 a, simd_i16 b) { simd_i16 r; SIMD_I16_LOOP(r, simd_sat16(a.v[i] - b.v[i])); return r; }
+
+/* Q15 multiply, rounded and saturated: (a * b + 0x4000) >> 15 */
+SIMD_INLINE simd_i16 simd_mulq15_i16(simd_i16 a, simd_i16 b)
+{
+	simd_i16 r;
+	SIMD_I16_LOOP(r, simd_sat16(((int32_t)a.v[i] * b.v[i] + 0x4000) >> 15));
+	return r;
+}
+
+#undef SIMD_F32_LOOP
+#undef SIMD_I16_LOOP
+
+#endif
+
+#endif
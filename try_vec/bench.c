@@ -0,0 +1,272 @@
+/*
+ * bench.c - cycle timing and robust statistics for try_vec
+ * 10-19-26 E. Brombaugh
+ *
+ * Counts come from perf_event_open when the kernel exposes the hardware
+ * counters, from the rdcycle/rdinstret CSRs when user mode may read them
+ * (probed under a SIGILL handler, recent kernels turn that off) and from
+ * clock_gettime as the last resort.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "bench.h"
+
+static bench_tmr_t tmr_used = BENCH_TMR_NS;
+static int perf_fd = -1, perf_ifd = -1, perf_nr;
+static bench_count tmr_ovh;
+
+/*
+ * open a hardware counter, the first one leads the group
+ */
+static int perf_open(uint64_t config, int group)
+{
+	struct perf_event_attr pe;
+
+	memset(&pe, 0, sizeof(pe));
+	pe.type = PERF_TYPE_HARDWARE;
+	pe.size = sizeof(pe);
+	pe.config = config;
+	pe.disabled = (group == -1);
+	pe.exclude_kernel = 1;
+	pe.exclude_hv = 1;
+	pe.read_format = PERF_FORMAT_GROUP;
+	return syscall(__NR_perf_event_open, &pe, 0, -1, group, 0);
+}
+
+static int perf_init(void)
+{
+	if((perf_fd = perf_open(PERF_COUNT_HW_CPU_CYCLES, -1)) < 0)
+		return 1;
+	perf_nr = 1;
+	if((perf_ifd = perf_open(PERF_COUNT_HW_INSTRUCTIONS, perf_fd)) >= 0)
+		perf_nr = 2;
+	ioctl(perf_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+	/* some kernels open the event but never count */
+	{
+		uint64_t buf[3] = {0, 0, 0};
+		volatile int i;
+		for(i=0;i<10000;i++);
+		if(read(perf_fd, buf, sizeof(buf)) < 16 || buf[1] == 0)
+		{
+			if(perf_ifd >= 0)
+				close(perf_ifd);
+			close(perf_fd);
+			perf_fd = perf_ifd = -1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+#if defined(__riscv)
+static inline uint64_t rd_cycle(void)
+{
+	uint64_t c;
+	__asm__ volatile ("rdcycle %0" : "=r"(c));
+	return c;
+}
+
+static inline uint64_t rd_instret(void)
+{
+	uint64_t c;
+	__asm__ volatile ("rdinstret %0" : "=r"(c));
+	return c;
+}
+
+static sigjmp_buf probe_env;
+
+static void probe_sigill(int sig)
+{
+	(void)sig;
+	siglongjmp(probe_env, 1);
+}
+
+/*
+ * see if the counter CSRs can be read from user mode
+ */
+static int rdcycle_init(void)
+{
+	struct sigaction sa, old;
+	volatile int ok = 0;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = probe_sigill;
+	sigaction(SIGILL, &sa, &old);
+	if(!sigsetjmp(probe_env, 1))
+	{
+		rd_cycle();
+		rd_instret();
+		ok = 1;
+	}
+	sigaction(SIGILL, &old, NULL);
+	return !ok;
+}
+#else
+static int rdcycle_init(void)
+{
+	return 1;
+}
+#endif
+
+/*
+ * pick a timer - returns the one actually used
+ */
+bench_tmr_t bench_timer_init(bench_tmr_t tmr)
+{
+	bench_count a, b;
+	double *ovh;
+	int i, n = 1001;
+
+	tmr_used = BENCH_TMR_NS;
+	if((tmr == BENCH_TMR_AUTO || tmr == BENCH_TMR_PERF) && !perf_init())
+		tmr_used = BENCH_TMR_PERF;
+	else if((tmr == BENCH_TMR_AUTO || tmr == BENCH_TMR_RDCYCLE) && !rdcycle_init())
+		tmr_used = BENCH_TMR_RDCYCLE;
+
+	/* cost of an empty measurement, taken off every sample */
+	memset(&tmr_ovh, 0, sizeof(tmr_ovh));
+	if((ovh = malloc(n * sizeof(double))))
+	{
+		bench_stats st;
+
+		for(i=0;i<n;i++)
+		{
+			bench_read(&a);
+			bench_read(&b);
+			ovh[i] = b.cycles - a.cycles;
+		}
+		bench_stats_calc(ovh, n, &st);
+		tmr_ovh.cycles = st.min;
+		for(i=0;i<n;i++)
+		{
+			bench_read(&a);
+			bench_read(&b);
+			ovh[i] = b.instret - a.instret;
+		}
+		bench_stats_calc(ovh, n, &st);
+		tmr_ovh.instret = st.min;
+		free(ovh);
+	}
+
+	return tmr_used;
+}
+
+void bench_timer_close(void)
+{
+	if(perf_ifd >= 0)
+		close(perf_ifd);
+	if(perf_fd >= 0)
+		close(perf_fd);
+	perf_fd = perf_ifd = -1;
+}
+
+const char *bench_timer_name(bench_tmr_t tmr)
+{
+	switch(tmr)
+	{
+		case BENCH_TMR_PERF: return "perf";
+		case BENCH_TMR_RDCYCLE: return "rdcycle";
+		case BENCH_TMR_NS: return "ns";
+		default: return "auto";
+	}
+}
+
+const char *bench_timer_unit(void)
+{
+	return tmr_used == BENCH_TMR_NS ? "ns" : "cycles";
+}
+
+int bench_timer_has_instret(void)
+{
+	return (tmr_used == BENCH_TMR_PERF && perf_nr == 2) || tmr_used == BENCH_TMR_RDCYCLE;
+}
+
+/*
+ * current counts
+ */
+void bench_read(bench_count *c)
+{
+	if(tmr_used == BENCH_TMR_PERF)
+	{
+		uint64_t buf[3] = {0, 0, 0};
+
+		if(read(perf_fd, buf, sizeof(buf)) < 16)
+			buf[1] = 0;
+		c->cycles = buf[1];
+		c->instret = buf[2];
+	}
+#if defined(__riscv)
+	else if(tmr_used == BENCH_TMR_RDCYCLE)
+	{
+		c->instret = rd_instret();
+		c->cycles = rd_cycle();
+	}
+#endif
+	else
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		c->cycles = 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+		c->instret = 0;
+	}
+}
+
+/*
+ * counts of an empty measurement
+ */
+void bench_overhead(bench_count *c)
+{
+	*c = tmr_ovh;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double median_sorted(const double *s, int n)
+{
+	return n & 1 ? s[n/2] : 0.5 * (s[n/2 - 1] + s[n/2]);
+}
+
+/*
+ * min / median / MAD / mean - sorts the samples
+ */
+void bench_stats_calc(double *samples, int n, bench_stats *st)
+{
+	double *dev, sum = 0;
+	int i;
+
+	memset(st, 0, sizeof(*st));
+	if(n <= 0)
+		return;
+
+	qsort(samples, n, sizeof(double), cmp_double);
+	st->min = samples[0];
+	st->median = median_sorted(samples, n);
+	for(i=0;i<n;i++)
+		sum += samples[i];
+	st->mean = sum / n;
+
+	if((dev = malloc(n * sizeof(double))))
+	{
+		for(i=0;i<n;i++)
+			dev[i] = samples[i] > st->median ? samples[i] - st->median : st->median - samples[i];
+		qsort(dev, n, sizeof(double), cmp_double);
+		st->mad = median_sorted(dev, n);
+		free(dev);
+	}
+}
@@ -0,0 +1,45 @@
+/*
+ * bench.h - cycle timing and robust statistics for try_vec
+ * 10-19-26 E. Brombaugh
+ */
+
+#ifndef __bench__
+#define __bench__
+
+#include <stdint.h>
+
+/* where the counts come from */
+typedef enum
+{
+	BENCH_TMR_AUTO,			// perf, else rdcycle, else ns
+	BENCH_TMR_PERF,			// perf_event_open cycles + instructions
+	BENCH_TMR_RDCYCLE,		// rdcycle / rdinstret CSRs
+	BENCH_TMR_NS,			// clock_gettime, no instruction count
+} bench_tmr_t;
+
+/* one reading */
+typedef struct
+{
+	uint64_t cycles;		// or ns for BENCH_TMR_NS
+	uint64_t instret;		// 0 if not available
+} bench_count;
+
+/* summary of a set of samples */
+typedef struct
+{
+	double min;
+	double median;
+	double mad;				// median absolute deviation from the median
+	double mean;
+} bench_stats;
+
+bench_tmr_t bench_timer_init(bench_tmr_t tmr);
+void bench_timer_close(void);
+const char *bench_timer_name(bench_tmr_t tmr);
+const char *bench_timer_unit(void);
+int bench_timer_has_instret(void);
+void bench_read(bench_count *c);
+void bench_overhead(bench_count *c);
+void bench_stats_calc(double *samples, int n, bench_stats *st);
+
+#endif
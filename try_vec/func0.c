@@ -34,8 +34,6 @@ void scalar_func0(float *pSrc, int fftLen)
 
 	do
 	{
-		printf("%d\n", i1);
-		
 		i2 = i1 + n2;
 		i3 = i2 + n2;
 		i4 = i3 + n2;
@@ -133,8 +131,6 @@ void vector_func0(float *pSrc, int fftLen)
 
 	do
 	{
-		printf("%d\n", i1);
-		
 		size_t vl = vsetvl_e32m1(4);
 		vfloat32m1_t va = vlse32_v_f32m1(pSrc+2*i1, 2*n2*sizeof(float), vl);
 		vfloat32m1_t vb = vlse32_v_f32m1(pSrc+2*(i1+n2*vl), 2*n2*sizeof(float), vl);
@@ -213,6 +209,7 @@ const snippet func0 =
 {
 	"Radix 8 stuff",
 	init_func0,
+	NULL,
 	scalar_func0,
 	vector_func0,
 };
@@ -26,6 +26,15 @@ int init_func1(int len)
 	return 0;
 }
 
+/*
+ * free the twiddles
+ */
+void cleanup_func1(void)
+{
+	free(twiddles);
+	twiddles = NULL;
+}
+
 /*
  * this is the original non-vector code
  */
@@ -82,7 +91,10 @@ const snippet func1 =
 {
 	"complex mult",
 	init_func1,
+	cleanup_func1,
 	scalar_func1,
 	vector_func1,
+	"complex mult",
+	"strided",
 };
 
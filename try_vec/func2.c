@@ -0,0 +1,165 @@
+/*
+ * func2.c - conformance and speed of the ../simd DSP kernels
+ * 10-19-26 E. Brombaugh
+ *
+ * Scalar is the _ref version of each kernel, vector the simd.h one. The
+ * reductions leave their result in pSrc[0], the int16 kernels go through
+ * the float <-> int16 conversions on both sides.
+ */
+
+#include "func2.h"
+#include "kern.h"
+
+#define PI (4.0F*atanf(1))
+#define FIR_TAPS 32
+
+static float hr[FIR_TAPS], *scr;
+static int16_t *s16;
+
+/* four lowpass sections at different cutoffs */
+static kern_biquad4 bq_init;
+
+/*
+ * taps, filters and scratch for all the kernels
+ */
+int init_func2(int len)
+{
+	int i;
+
+	if(2*len < FIR_TAPS)
+		return 1;
+	if(!(scr = malloc(2*len*sizeof(float))) || !(s16 = malloc(2*len*sizeof(int16_t))))
+	{
+		free(scr);
+		scr = NULL;
+		return 1;
+	}
+
+	/* windowed sinc, symmetric so time reversal doesn't matter */
+	for(i=0;i<FIR_TAPS;i++)
+	{
+		float t = i - (FIR_TAPS - 1) / 2.0F;
+		float w = 0.5F - 0.5F * cosf(2.0F * PI * (i + 0.5F) / FIR_TAPS);
+		hr[i] = w * sinf(0.25F * PI * t) / (PI * t);
+	}
+
+	memset(&bq_init, 0, sizeof(bq_init));
+	for(i=0;i<4;i++)
+	{
+		float w0 = 2.0F * PI * 0.02F * (i + 1), alpha = sinf(w0) / (2.0F * 0.707F);
+		float a0 = 1.0F + alpha, c = cosf(w0);
+
+		bq_init.b0[i] = bq_init.b2[i] = (1.0F - c) / (2.0F * a0);
+		bq_init.b1[i] = (1.0F - c) / a0;
+		bq_init.a1[i] = -2.0F * c / a0;
+		bq_init.a2[i] = (1.0F - alpha) / a0;
+	}
+
+	return 0;
+}
+
+void cleanup_func2(void)
+{
+	free(scr);
+	free(s16);
+	scr = NULL;
+	s16 = NULL;
+}
+
+/* dot product of the two halves */
+void scalar_dot(float *pSrc, int len) { pSrc[0] = kern_dot_ref(pSrc, pSrc + len, len); }
+void vector_dot(float *pSrc, int len) { pSrc[0] = kern_dot(pSrc, pSrc + len, len); }
+
+/* FIR in place over the whole buffer */
+void scalar_fir(float *pSrc, int len) { kern_fir_ref(pSrc, pSrc, hr, FIR_TAPS, 2*len - FIR_TAPS + 1); }
+void vector_fir(float *pSrc, int len) { kern_fir(pSrc, pSrc, hr, FIR_TAPS, 2*len - FIR_TAPS + 1); }
+
+/* buffer as len / 2 frames of 4 channels, from rest every call */
+void scalar_biquad(float *pSrc, int len)
+{
+	kern_biquad4 bq = bq_init;
+	kern_biquad4_run_ref(&bq, pSrc, len / 2);
+}
+
+void vector_biquad(float *pSrc, int len)
+{
+	kern_biquad4 bq = bq_init;
+	kern_biquad4_run(&bq, pSrc, len / 2);
+}
+
+void scalar_maxabs(float *pSrc, int len) { pSrc[0] = kern_maxabs_ref(pSrc, 2*len); }
+void vector_maxabs(float *pSrc, int len) { pSrc[0] = kern_maxabs(pSrc, 2*len); }
+
+void scalar_sum(float *pSrc, int len) { pSrc[0] = kern_sum_ref(pSrc, 2*len); }
+void vector_sum(float *pSrc, int len) { pSrc[0] = kern_sum(pSrc, 2*len); }
+
+/* halves to Q15, mix hot enough to clip now and then, back to float */
+void scalar_mix(float *pSrc, int len)
+{
+	kern_f32_to_i16_ref(s16, pSrc, 2*len, 32767.0F);
+	kern_mix_i16_ref(s16, s16, s16 + len, 0x6000, 0x5000, len);
+	kern_i16_to_f32_ref(pSrc, s16, len, 1.0F / 32768.0F);
+}
+
+void vector_mix(float *pSrc, int len)
+{
+	kern_f32_to_i16(s16, pSrc, 2*len, 32767.0F);
+	kern_mix_i16(s16, s16, s16 + len, 0x6000, 0x5000, len);
+	kern_i16_to_f32(pSrc, s16, len, 1.0F / 32768.0F);
+}
+
+void scalar_ramp(float *pSrc, int len) { kern_gain_ramp_ref(pSrc, pSrc, 2*len, 0.1F, 1.0F); }
+void vector_ramp(float *pSrc, int len) { kern_gain_ramp(pSrc, pSrc, 2*len, 0.1F, 1.0F); }
+
+/* buffer as len codec frames in, L and R halves out */
+void scalar_stin(float *pSrc, int len)
+{
+	kern_f32_to_i16_ref(s16, pSrc, 2*len, 32767.0F);
+	kern_deinterleave_i16_ref(pSrc, pSrc + len, s16, len, 1.0F / 32768.0F);
+}
+
+void vector_stin(float *pSrc, int len)
+{
+	kern_f32_to_i16(s16, pSrc, 2*len, 32767.0F);
+	kern_deinterleave_i16(pSrc, pSrc + len, s16, len, 1.0F / 32768.0F);
+}
+
+/* L and R halves to len codec frames and back to float */
+void scalar_stout(float *pSrc, int len)
+{
+	kern_interleave_i16_ref(s16, pSrc, pSrc + len, len, 32767.0F);
+	kern_i16_to_f32_ref(pSrc, s16, 2*len, 1.0F / 32768.0F);
+}
+
+void vector_stout(float *pSrc, int len)
+{
+	kern_interleave_i16(s16, pSrc, pSrc + len, len, 32767.0F);
+	kern_i16_to_f32(pSrc, s16, 2*len, 1.0F / 32768.0F);
+}
+
+/* split the frames and put them back with L and R swapped */
+void scalar_deint(float *pSrc, int len)
+{
+	kern_deinterleave_ref(scr, scr + len, pSrc, len);
+	kern_interleave_ref(pSrc, scr + len, scr, len);
+}
+
+void vector_deint(float *pSrc, int len)
+{
+	kern_deinterleave(scr, scr + len, pSrc, len);
+	kern_interleave(pSrc, scr + len, scr, len);
+}
+
+/*
+ * bundle them up
+ */
+const snippet func2_dot = { "dot product", init_func2, cleanup_func2, scalar_dot, vector_dot, NULL, NULL };
+const snippet func2_fir = { "FIR 32 taps", init_func2, cleanup_func2, scalar_fir, vector_fir, NULL, NULL };
+const snippet func2_biquad = { "biquad x4", init_func2, cleanup_func2, scalar_biquad, vector_biquad, NULL, NULL };
+const snippet func2_maxabs = { "max abs", init_func2, cleanup_func2, scalar_maxabs, vector_maxabs, NULL, NULL };
+const snippet func2_sum = { "sum", init_func2, cleanup_func2, scalar_sum, vector_sum, NULL, NULL };
+const snippet func2_mix = { "int16 mix", init_func2, cleanup_func2, scalar_mix, vector_mix, NULL, NULL };
+const snippet func2_ramp = { "gain ramp", init_func2, cleanup_func2, scalar_ramp, vector_ramp, NULL, NULL };
+const snippet func2_stin = { "int16 stereo in", init_func2, cleanup_func2, scalar_stin, vector_stin, NULL, NULL };
+const snippet func2_stout = { "int16 stereo out", init_func2, cleanup_func2, scalar_stout, vector_stout, NULL, NULL };
+const snippet func2_deint = { "(de)interleave", init_func2, cleanup_func2, scalar_deint, vector_deint, NULL, NULL };
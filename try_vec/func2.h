@@ -0,0 +1,14 @@
+/*
+ * func2.h - conformance and speed of the ../simd DSP kernels
+ * 10-19-26 E. Brombaugh
+ */
+ 
+#ifndef __func2__
+#define __func2__
+
+#include "main.h"
+
+extern const snippet func2_dot, func2_fir, func2_biquad, func2_maxabs, func2_sum,
+	func2_mix, func2_ramp, func2_stin, func2_stout, func2_deint;
+
+#endif
@@ -0,0 +1,338 @@
+/*
+ * func3.c - strided vs segment access for interleaved complex data
+ * 10-19-26 E. Brombaugh
+ *
+ * The same complex multiply, complex MAC and radix-8 butterfly with the
+ * real and imaginary parts split by two vlse32 per vector or by one
+ * vlseg2e32. func1 is the strided complex multiply. main.c reports which
+ * access pattern is faster at each length.
+ */
+
+#include "func3.h"
+
+#define PI (4.0F*atanf(1))
+#define C81 0.70710678118f
+
+static float *twiddles;
+
+/*
+ * load / store real and imaginary parts of vl complex values
+ */
+static inline void ld_cplx(const float *p, vfloat32m1_t *re, vfloat32m1_t *im, size_t vl, int seg)
+{
+	if(seg)
+		vlseg2e32_v_f32m1(re, im, p, vl);
+	else
+	{
+		*re = vlse32_v_f32m1(p, 2*sizeof(float), vl);
+		*im = vlse32_v_f32m1(p + 1, 2*sizeof(float), vl);
+	}
+}
+
+static inline void st_cplx(float *p, vfloat32m1_t re, vfloat32m1_t im, size_t vl, int seg)
+{
+	if(seg)
+		vsseg2e32_v_f32m1(p, re, im, vl);
+	else
+	{
+		vsse32_v_f32m1(p, 2*sizeof(float), re, vl);
+		vsse32_v_f32m1(p + 1, 2*sizeof(float), im, vl);
+	}
+}
+
+/*
+ * twiddles for the multiplies
+ */
+int init_func3(int len)
+{
+	if(!(twiddles = malloc(2*len*sizeof(float))))
+		return 1;
+
+	for(int i=0;i<len;i++)
+	{
+		twiddles[2*i] = cosf((float)i * PI * 2.0F / (float)len);
+		twiddles[2*i+1] = sinf((float)i * PI * 2.0F / (float)len);
+	}
+
+	return 0;
+}
+
+void cleanup_func3(void)
+{
+	free(twiddles);
+	twiddles = NULL;
+}
+
+/*
+ * complex multiply by the twiddles, as func1 but with segment access
+ */
+void scalar_cmul(float *pSrc, int len)
+{
+	for(int i = 0 ; i < len ; i++)
+	{
+		float re = pSrc[2*i] * twiddles[2*i] - pSrc[2*i+1] * twiddles[2*i+1];
+		float im = pSrc[2*i] * twiddles[2*i+1] + pSrc[2*i+1] * twiddles[2*i];
+		pSrc[2*i] = re;
+		pSrc[2*i+1] = im;
+	}
+}
+
+void vector_cmul_seg(float *pSrc, int len)
+{
+	size_t i = 0;
+	while(i < (size_t)len)
+	{
+		size_t vl = vsetvl_e32m1(len - i);
+		vfloat32m1_t va, vb, vc, vd;
+
+		ld_cplx(pSrc + 2*i, &va, &vb, vl, 1);
+		ld_cplx(twiddles + 2*i, &vc, &vd, vl, 1);
+
+		vfloat32m1_t vre = vfsub_vv_f32m1(vfmul_vv_f32m1(va, vc, vl), vfmul_vv_f32m1(vb, vd, vl), vl);
+		vfloat32m1_t vim = vfadd_vv_f32m1(vfmul_vv_f32m1(va, vd, vl), vfmul_vv_f32m1(vb, vc, vl), vl);
+
+		st_cplx(pSrc + 2*i, vre, vim, vl, 1);
+		i += vl;
+	}
+}
+
+/*
+ * complex MAC - the second half accumulates the first half times the
+ * twiddles
+ */
+void scalar_cmac(float *pSrc, int len)
+{
+	int n = len / 2;
+	float *acc = pSrc + 2*n;
+
+	for(int i = 0 ; i < n ; i++)
+	{
+		acc[2*i] += pSrc[2*i] * twiddles[2*i] - pSrc[2*i+1] * twiddles[2*i+1];
+		acc[2*i+1] += pSrc[2*i] * twiddles[2*i+1] + pSrc[2*i+1] * twiddles[2*i];
+	}
+}
+
+static inline void vector_cmac(float *pSrc, int len, int seg)
+{
+	int n = len / 2;
+	float *acc = pSrc + 2*n;
+	size_t i = 0;
+
+	while(i < (size_t)n)
+	{
+		size_t vl = vsetvl_e32m1(n - i);
+		vfloat32m1_t xr, xi, wr, wi, ar, ai;
+
+		ld_cplx(pSrc + 2*i, &xr, &xi, vl, seg);
+		ld_cplx(twiddles + 2*i, &wr, &wi, vl, seg);
+		ld_cplx(acc + 2*i, &ar, &ai, vl, seg);
+
+		ar = vfmacc_vv_f32m1(ar, xr, wr, vl);
+		ar = vfnmsac_vv_f32m1(ar, xi, wi, vl);
+		ai = vfmacc_vv_f32m1(ai, xr, wi, vl);
+		ai = vfmacc_vv_f32m1(ai, xi, wr, vl);
+
+		st_cplx(acc + 2*i, ar, ai, vl, seg);
+		i += vl;
+	}
+}
+
+void vector_cmac_str(float *pSrc, int len) { vector_cmac(pSrc, len, 0); }
+void vector_cmac_seg(float *pSrc, int len) { vector_cmac(pSrc, len, 1); }
+
+/*
+ * radix-8 butterfly - len / 8 forward 8 point DFTs of the points n2 apart,
+ * in place and in natural order, no twiddles
+ */
+void scalar_r8(float *pSrc, int len)
+{
+	int n2 = len >> 3;
+
+	for(int j = 0 ; j < n2 ; j++)
+	{
+		float xr[8], xi[8], ar[4], ai[4], br[4], bi[4], t;
+		int m;
+
+		for(m=0;m<8;m++)
+		{
+			xr[m] = pSrc[2*(j + m*n2)];
+			xi[m] = pSrc[2*(j + m*n2) + 1];
+		}
+
+		/* first radix-2 stage, odd half times W^1, W^2, W^3 */
+		for(m=0;m<4;m++)
+		{
+			ar[m] = xr[m] + xr[m+4];
+			ai[m] = xi[m] + xi[m+4];
+			br[m] = xr[m] - xr[m+4];
+			bi[m] = xi[m] - xi[m+4];
+		}
+		t = br[1];
+		br[1] = C81 * (t + bi[1]);
+		bi[1] = C81 * (bi[1] - t);
+		t = br[2];
+		br[2] = bi[2];
+		bi[2] = -t;
+		t = br[3];
+		br[3] = C81 * (bi[3] - t);
+		bi[3] = -C81 * (t + bi[3]);
+
+		/* two 4 point DFTs give the even and odd outputs */
+		for(m=0;m<2;m++)
+		{
+			float *vr = m ? br : ar, *vi = m ? bi : ai;
+			float c0r = vr[0] + vr[2], c0i = vi[0] + vi[2];
+			float c1r = vr[1] + vr[3], c1i = vi[1] + vi[3];
+			float c2r = vr[0] - vr[2], c2i = vi[0] - vi[2];
+			float c3r = vi[1] - vi[3], c3i = vr[3] - vr[1];
+
+			xr[m] = c0r + c1r;
+			xi[m] = c0i + c1i;
+			xr[m+4] = c0r - c1r;
+			xi[m+4] = c0i - c1i;
+			xr[m+2] = c2r + c3r;
+			xi[m+2] = c2i + c3i;
+			xr[m+6] = c2r - c3r;
+			xi[m+6] = c2i - c3i;
+		}
+
+		for(m=0;m<8;m++)
+		{
+			pSrc[2*(j + m*n2)] = xr[m];
+			pSrc[2*(j + m*n2) + 1] = xi[m];
+		}
+	}
+}
+
+/*
+ * the lanes are consecutive butterflies, each of the 8 points is one
+ * strided or segment load of vl complex values
+ */
+static inline void vector_r8(float *pSrc, int len, int seg)
+{
+	int n2 = len >> 3;
+	size_t j = 0;
+
+	while(j < (size_t)n2)
+	{
+		size_t vl = vsetvl_e32m1(n2 - j);
+		float *p = pSrc + 2*j;
+		vfloat32m1_t x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+		vfloat32m1_t x4r, x4i, x5r, x5i, x6r, x6i, x7r, x7i;
+		vfloat32m1_t a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i;
+		vfloat32m1_t b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i, t;
+		vfloat32m1_t c0r, c0i, c1r, c1i, c2r, c2i, c3r, c3i;
+
+		ld_cplx(p, &x0r, &x0i, vl, seg);
+		ld_cplx(p + 2*n2, &x1r, &x1i, vl, seg);
+		ld_cplx(p + 4*n2, &x2r, &x2i, vl, seg);
+		ld_cplx(p + 6*n2, &x3r, &x3i, vl, seg);
+		ld_cplx(p + 8*n2, &x4r, &x4i, vl, seg);
+		ld_cplx(p + 10*n2, &x5r, &x5i, vl, seg);
+		ld_cplx(p + 12*n2, &x6r, &x6i, vl, seg);
+		ld_cplx(p + 14*n2, &x7r, &x7i, vl, seg);
+
+		/* first radix-2 stage, odd half times W^1, W^2, W^3 */
+		a0r = vfadd_vv_f32m1(x0r, x4r, vl); a0i = vfadd_vv_f32m1(x0i, x4i, vl);
+		a1r = vfadd_vv_f32m1(x1r, x5r, vl); a1i = vfadd_vv_f32m1(x1i, x5i, vl);
+		a2r = vfadd_vv_f32m1(x2r, x6r, vl); a2i = vfadd_vv_f32m1(x2i, x6i, vl);
+		a3r = vfadd_vv_f32m1(x3r, x7r, vl); a3i = vfadd_vv_f32m1(x3i, x7i, vl);
+		b0r = vfsub_vv_f32m1(x0r, x4r, vl); b0i = vfsub_vv_f32m1(x0i, x4i, vl);
+		b1r = vfsub_vv_f32m1(x1r, x5r, vl); b1i = vfsub_vv_f32m1(x1i, x5i, vl);
+		b2r = vfsub_vv_f32m1(x2r, x6r, vl); b2i = vfsub_vv_f32m1(x2i, x6i, vl);
+		b3r = vfsub_vv_f32m1(x3r, x7r, vl); b3i = vfsub_vv_f32m1(x3i, x7i, vl);
+
+		t = b1r;
+		b1r = vfmul_vf_f32m1(vfadd_vv_f32m1(t, b1i, vl), C81, vl);
+		b1i = vfmul_vf_f32m1(vfsub_vv_f32m1(b1i, t, vl), C81, vl);
+		t = b2r;
+		b2r = b2i;
+		b2i = vfneg_v_f32m1(t, vl);
+		t = b3r;
+		b3r = vfmul_vf_f32m1(vfsub_vv_f32m1(b3i, t, vl), C81, vl);
+		b3i = vfmul_vf_f32m1(vfadd_vv_f32m1(t, b3i, vl), -C81, vl);
+
+		/* 4 point DFT of the even half */
+		c0r = vfadd_vv_f32m1(a0r, a2r, vl); c0i = vfadd_vv_f32m1(a0i, a2i, vl);
+		c1r = vfadd_vv_f32m1(a1r, a3r, vl); c1i = vfadd_vv_f32m1(a1i, a3i, vl);
+		c2r = vfsub_vv_f32m1(a0r, a2r, vl); c2i = vfsub_vv_f32m1(a0i, a2i, vl);
+		c3r = vfsub_vv_f32m1(a1i, a3i, vl); c3i = vfsub_vv_f32m1(a3r, a1r, vl);
+		st_cplx(p, vfadd_vv_f32m1(c0r, c1r, vl), vfadd_vv_f32m1(c0i, c1i, vl), vl, seg);
+		st_cplx(p + 8*n2, vfsub_vv_f32m1(c0r, c1r, vl), vfsub_vv_f32m1(c0i, c1i, vl), vl, seg);
+		st_cplx(p + 4*n2, vfadd_vv_f32m1(c2r, c3r, vl), vfadd_vv_f32m1(c2i, c3i, vl), vl, seg);
+		st_cplx(p + 12*n2, vfsub_vv_f32m1(c2r, c3r, vl), vfsub_vv_f32m1(c2i, c3i, vl), vl, seg);
+
+		/* and of the odd half */
+		c0r = vfadd_vv_f32m1(b0r, b2r, vl); c0i = vfadd_vv_f32m1(b0i, b2i, vl);
+		c1r = vfadd_vv_f32m1(b1r, b3r, vl); c1i = vfadd_vv_f32m1(b1i, b3i, vl);
+		c2r = vfsub_vv_f32m1(b0r, b2r, vl); c2i = vfsub_vv_f32m1(b0i, b2i, vl);
+		c3r = vfsub_vv_f32m1(b1i, b3i, vl); c3i = vfsub_vv_f32m1(b3r, b1r, vl);
+		st_cplx(p + 2*n2, vfadd_vv_f32m1(c0r, c1r, vl), vfadd_vv_f32m1(c0i, c1i, vl), vl, seg);
+		st_cplx(p + 10*n2, vfsub_vv_f32m1(c0r, c1r, vl), vfsub_vv_f32m1(c0i, c1i, vl), vl, seg);
+		st_cplx(p + 6*n2, vfadd_vv_f32m1(c2r, c3r, vl), vfadd_vv_f32m1(c2i, c3i, vl), vl, seg);
+		st_cplx(p + 14*n2, vfsub_vv_f32m1(c2r, c3r, vl), vfsub_vv_f32m1(c2i, c3i, vl), vl, seg);
+
+		j += vl;
+	}
+}
+
+void vector_r8_str(float *pSrc, int len) { vector_r8(pSrc, len, 0); }
+void vector_r8_seg(float *pSrc, int len) { vector_r8(pSrc, len, 1); }
+
+/*
+ * bundle them up
+ */
+const snippet func3_cmul_seg =
+{
+	"complex mult segment",
+	init_func3,
+	cleanup_func3,
+	scalar_cmul,
+	vector_cmul_seg,
+	"complex mult",
+	"segment",
+};
+
+const snippet func3_cmac_str =
+{
+	"complex MAC strided",
+	init_func3,
+	cleanup_func3,
+	scalar_cmac,
+	vector_cmac_str,
+	"complex MAC",
+	"strided",
+};
+
+const snippet func3_cmac_seg =
+{
+	"complex MAC segment",
+	init_func3,
+	cleanup_func3,
+	scalar_cmac,
+	vector_cmac_seg,
+	"complex MAC",
+	"segment",
+};
+
+const snippet func3_r8_str =
+{
+	"radix-8 butterfly strided",
+	init_func3,
+	cleanup_func3,
+	scalar_r8,
+	vector_r8_str,
+	"radix-8 butterfly",
+	"strided",
+};
+
+const snippet func3_r8_seg =
+{
+	"radix-8 butterfly segment",
+	init_func3,
+	cleanup_func3,
+	scalar_r8,
+	vector_r8_seg,
+	"radix-8 butterfly",
+	"segment",
+};
@@ -0,0 +1,13 @@
+/*
+ * func3.h - strided vs segment access for interleaved complex data
+ * 10-19-26 E. Brombaugh
+ */
+ 
+#ifndef __func3__
+#define __func3__
+
+#include "main.h"
+
+extern const snippet func3_cmul_seg, func3_cmac_str, func3_cmac_seg, func3_r8_str, func3_r8_seg;
+
+#endif
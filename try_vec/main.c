@@ -1,16 +1,25 @@
 /*
  * try_vec.c - try out vectorizing ideas on fragments from r8 fft
  * 09-25-25 E. Brombaugh
+ * 10-19-26 E. Brombaugh - cycle timing, repetitions, length sweeps, CSV/JSON
+ * 10-19-26 E. Brombaugh - DSP kernels from ../simd
+ * 10-19-26 E. Brombaugh - strided vs segment access, winner per length
+ * 10-19-26 E. Brombaugh - runtime kernel dispatch
+ * 10-19-26 E. Brombaugh - fresh input for every timed call
  */
- 
+
 #include <getopt.h>
-#include <sys/time.h>
 #include "main.h"
+#include "bench.h"
+#include "cpu.h"
+#include "kern.h"
 #include "func0.h"
 #include "func1.h"
+#include "func2.h"
+#include "func3.h"
 
 /* version */
-const char *swVersionStr = "V0.1";
+const char *swVersionStr = "V0.2";
 
 /* build time */
 const char *bdate = __DATE__;
@@ -21,8 +30,41 @@ const snippet *snfuncs[] =
 {
 	&func0,
 	&func1,
+	&func2_dot,
+	&func2_fir,
+	&func2_biquad,
+	&func2_maxabs,
+	&func2_sum,
+	&func2_mix,
+	&func2_ramp,
+	&func2_stin,
+	&func2_stout,
+	&func2_deint,
+	&func3_cmul_seg,
+	&func3_cmac_str,
+	&func3_cmac_seg,
+	&func3_r8_str,
+	&func3_r8_seg,
+};
+
+/* output formats */
+enum
+{
+	OUT_TEXT,
+	OUT_CSV,
+	OUT_JSON,
 };
 
+/* results of one snippet at one length */
+typedef struct
+{
+	int func_idx, len;
+	bench_stats scl, vec;
+	double scl_ins, vec_ins;	// median instructions per call
+	double err_max, err_rms;	// relative to the reference peak / rms
+	int pass;
+} result;
+
 /*
  * utility function
  */
@@ -33,6 +75,251 @@ void dump_vec(vfloat32m1_t v, size_t vl)
 	printf("%f %f %f %f\n", tmp[0], tmp[1], tmp[2], tmp[3]);
 }
 
+/*
+ * parse a length range - "64", "64:4096" doubles, "64:1024:64" steps by 64
+ */
+static int parse_lens(char *arg, int *start, int *end, int *step)
+{
+	int n = sscanf(arg, "%d:%d:%d", start, end, step);
+
+	if(n < 1 || *start <= 0)
+		return 1;
+	if(n < 2)
+		*end = *start;
+	if(n < 3)
+		*step = 0;
+	return *end < *start || *step < 0;
+}
+
+/*
+ * time one function - samples are per call, less the timer overhead. The
+ * snippets work in place, so each of the inner calls gets its own copy of
+ * the input in buf (inner * len complex values) rather than the output of
+ * the call before.
+ */
+static void time_func(void (*fn)(float *, int), float *buf, const float *src, int len,
+	int inner, double *cyc, double *ins, int idx)
+{
+	bench_count a, b, ovh;
+	int j;
+
+	bench_overhead(&ovh);
+	for(j=0;j<inner;j++)
+		memcpy(buf + j * len * 2, src, len * 2 * sizeof(float));
+	bench_read(&a);
+	for(j=0;j<inner;j++)
+		fn(buf + j * len * 2, len);
+	bench_read(&b);
+	cyc[idx] = ((double)(b.cycles - a.cycles) - ovh.cycles) / inner;
+	ins[idx] = ((double)(b.instret - a.instret) - ovh.instret) / inner;
+}
+
+/*
+ * max and rms error of the vector version, relative to the reference
+ */
+static void calc_err(const float *r_out, const float *u_out, int len, int verbose,
+	double *err_max, double *err_rms)
+{
+	double e, emax = 0, esum = 0, rmax = 0, rsum = 0;
+	int i;
+
+	for(i=0;i<2*len;i++)
+	{
+		e = fabs((double)r_out[i] - u_out[i]);
+		if(!(e <= emax))
+			emax = e;	// also catches NaN
+		esum += e * e;
+		rmax = fabs(r_out[i]) > rmax ? fabs(r_out[i]) : rmax;
+		rsum += (double)r_out[i] * r_out[i];
+
+		if(verbose && (i & 1))
+		{
+			fprintf(stdout, "%5d: (% 9.4f,% 9.4f) - (% 9.4f,% 9.4f) = (% 9.2e,% 9.2e)\n",
+				i/2,
+				r_out[i-1], r_out[i],
+				u_out[i-1], u_out[i],
+				r_out[i-1] - u_out[i-1], r_out[i] - u_out[i]
+			);
+		}
+	}
+	*err_max = rmax > 0 ? emax / rmax : emax;
+	*err_rms = rsum > 0 ? sqrt(esum / rsum) : sqrt(esum / (2*len));
+}
+
+/*
+ * run one snippet at one length
+ */
+static int run_one(int func_idx, int len, int warm, int reps, int inner, int verbose,
+	double tol_max, double tol_rms, result *res)
+{
+	const snippet *sn = snfuncs[func_idx];
+	float *t_in, *r_out, *u_out, *t_buf;
+	double *s_cyc, *s_ins, *v_cyc, *v_ins;
+	bench_stats st;
+	int i, rv = 1;
+
+	memset(res, 0, sizeof(*res));
+	res->func_idx = func_idx;
+	res->len = len;
+
+	t_in = malloc(len * 2 * sizeof(float));
+	r_out = malloc(len * 2 * sizeof(float));
+	u_out = malloc(len * 2 * sizeof(float));
+	t_buf = malloc((size_t)inner * len * 2 * sizeof(float));
+	s_cyc = malloc(reps * 4 * sizeof(double));
+	if(!t_in || !r_out || !u_out || !t_buf || !s_cyc)
+		goto err;
+	s_ins = s_cyc + reps;
+	v_cyc = s_ins + reps;
+	v_ins = v_cyc + reps;
+
+	/* repeatable full scale input */
+	srand48(len);
+	for(i=0;i<2*len;i++)
+		t_in[i] = 2.0 * drand48() - 1.0;
+
+	if(sn->init(len))
+	{
+		fprintf(stderr, "Init of Func %d failed at length %d\n", func_idx, len);
+		goto err;
+	}
+
+	/* accuracy on one fresh call each */
+	memcpy(r_out, t_in, len * 2 * sizeof(float));
+	sn->scalar(r_out, len);
+	memcpy(u_out, t_in, len * 2 * sizeof(float));
+	sn->vector(u_out, len);
+	calc_err(r_out, u_out, len, verbose, &res->err_max, &res->err_rms);
+	res->pass = res->err_max <= tol_max && res->err_rms <= tol_rms;
+
+	/* warm up caches, branch predictors and the clock governor */
+	for(i=0;i<warm;i++)
+	{
+		time_func(sn->scalar, t_buf, t_in, len, inner, s_cyc, s_ins, 0);
+		time_func(sn->vector, t_buf, t_in, len, inner, v_cyc, v_ins, 0);
+	}
+
+	/* interleave so that drift hits both the same way */
+	for(i=0;i<reps;i++)
+	{
+		time_func(sn->scalar, t_buf, t_in, len, inner, s_cyc, s_ins, i);
+		time_func(sn->vector, t_buf, t_in, len, inner, v_cyc, v_ins, i);
+	}
+
+	bench_stats_calc(s_cyc, reps, &res->scl);
+	bench_stats_calc(v_cyc, reps, &res->vec);
+	bench_stats_calc(s_ins, reps, &st);
+	res->scl_ins = st.median;
+	bench_stats_calc(v_ins, reps, &st);
+	res->vec_ins = st.median;
+	rv = 0;
+
+err:
+	if(sn->cleanup)
+		sn->cleanup();
+	free(s_cyc);
+	free(t_buf);
+	free(u_out);
+	free(r_out);
+	free(t_in);
+	return rv;
+}
+
+/*
+ * print one result
+ */
+static void print_result(int fmt, result *r, int first)
+{
+	const char *name = snfuncs[r->func_idx]->name, *unit = bench_timer_unit();
+	double speedup = r->vec.median > 0 ? r->scl.median / r->vec.median : 0;
+
+	switch(fmt)
+	{
+		case OUT_CSV:
+			if(first)
+				printf("func,name,len,unit,scl_min,scl_median,scl_mad,vec_min,vec_median,vec_mad,"
+					"scl_instr,vec_instr,speedup,err_max,err_rms,pass\n");
+			printf("%d,\"%s\",%d,%s,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.0f,%.0f,%.3f,%.3e,%.3e,%d\n",
+				r->func_idx, name, r->len, unit,
+				r->scl.min, r->scl.median, r->scl.mad,
+				r->vec.min, r->vec.median, r->vec.mad,
+				r->scl_ins, r->vec_ins, speedup, r->err_max, r->err_rms, r->pass);
+			break;
+
+		case OUT_JSON:
+			printf("%s  {\"func\": %d, \"name\": \"%s\", \"len\": %d, \"unit\": \"%s\",\n",
+				first ? "" : ",\n", r->func_idx, name, r->len, unit);
+			printf("   \"scalar\": {\"min\": %.1f, \"median\": %.1f, \"mad\": %.1f, \"instr\": %.0f},\n",
+				r->scl.min, r->scl.median, r->scl.mad, r->scl_ins);
+			printf("   \"vector\": {\"min\": %.1f, \"median\": %.1f, \"mad\": %.1f, \"instr\": %.0f},\n",
+				r->vec.min, r->vec.median, r->vec.mad, r->vec_ins);
+			printf("   \"speedup\": %.3f, \"err_max\": %.3e, \"err_rms\": %.3e, \"pass\": %s}",
+				speedup, r->err_max, r->err_rms, r->pass ? "true" : "false");
+			break;
+
+		default:
+			printf("Func %d: %s, length %d\n", r->func_idx, name, r->len);
+			printf("  Scalar: median %10.1f  MAD %8.1f  min %10.1f %s", r->scl.median,
+				r->scl.mad, r->scl.min, unit);
+			if(bench_timer_has_instret())
+				printf(", %.0f instr", r->scl_ins);
+			printf("\n  Vector: median %10.1f  MAD %8.1f  min %10.1f %s", r->vec.median,
+				r->vec.mad, r->vec.min, unit);
+			if(bench_timer_has_instret())
+				printf(", %.0f instr", r->vec_ins);
+			printf("\n  Speedup: %.2fx  Err max %.2e rms %.2e  %s\n", speedup,
+				r->err_max, r->err_rms, r->pass ? "PASS" : "FAIL");
+			break;
+	}
+}
+
+/*
+ * for each group and length run with more than one access pattern, which
+ * vector version was fastest - to stderr when stdout is CSV / JSON
+ */
+static void print_patterns(int fmt, const result *hist, int n)
+{
+	FILE *f = fmt == OUT_TEXT ? stdout : stderr;
+	int i, j, hdr = 0;
+
+	for(i=0;i<n;i++)
+	{
+		const snippet *si = snfuncs[hist[i].func_idx];
+		int best = i, cnt = 1, seen = 0;
+
+		if(!si->group)
+			continue;
+
+		/* only the first of each group / length pair */
+		for(j=0;j<i && !seen;j++)
+			seen = snfuncs[hist[j].func_idx]->group && hist[j].len == hist[i].len &&
+				!strcmp(snfuncs[hist[j].func_idx]->group, si->group);
+		if(seen)
+			continue;
+
+		for(j=i+1;j<n;j++)
+			if(snfuncs[hist[j].func_idx]->group && hist[j].len == hist[i].len &&
+				!strcmp(snfuncs[hist[j].func_idx]->group, si->group))
+			{
+				cnt++;
+				if(hist[j].vec.median < hist[best].vec.median)
+					best = j;
+			}
+		if(cnt < 2)
+			continue;
+
+		if(!hdr)
+			fprintf(f, "Access patterns, vector median in %s:\n", bench_timer_unit());
+		hdr = 1;
+		fprintf(f, "  %s, length %d:", si->group, hist[i].len);
+		for(j=i;j<n;j++)
+			if(snfuncs[hist[j].func_idx]->group && hist[j].len == hist[i].len &&
+				!strcmp(snfuncs[hist[j].func_idx]->group, si->group))
+				fprintf(f, " %s %.1f", snfuncs[hist[j].func_idx]->pattern, hist[j].vec.median);
+		fprintf(f, " -> %s\n", snfuncs[hist[best].func_idx]->pattern);
+	}
+}
+
 /*
  * top-level test harness
  */
@@ -40,133 +327,156 @@ int main(int argc, char **argv)
 {
 	extern char *optarg;
 	int opt;
-	int len = 64, i, verbose = 0, result = 1;
-	int max_idx = sizeof(snfuncs) / sizeof(snippet *), func_idx = 0;
-	float *t_in;		// array of test input data
-	float *r_out;		// array of reference output
-	float *u_out;		// array of UUT output
-	struct timeval tv1, tv2;
-	unsigned long time_scl, time_vec;
-	
+	int len = 64, len_end = 64, len_step = 0, verbose = 0, result_code = 0;
+	int max_idx = sizeof(snfuncs) / sizeof(snippet *), func_idx = 0, all = 0;
+	int warm = 10, reps = 101, inner = 1, fmt = OUT_TEXT, first = 1;
+	double tol_max = 1e-5, tol_rms = 1e-6;
+	bench_tmr_t tmr = BENCH_TMR_AUTO;
+	result res, *hist = NULL, *tmp;
+	int nhist = 0;
+
 	/* parse options */
-	while((opt = getopt(argc, argv, "f:l:vVh")) != EOF)
+	while((opt = getopt(argc, argv, "f:l:w:r:i:t:o:e:E:vVh")) != EOF)
 	{
 		switch(opt)
 		{
 			case 'f':
 				/* function to test */
-				func_idx = atoi(optarg);
+				if(!strcmp(optarg, "all"))
+				{
+					all = 1;
+					func_idx = 0;
+				}
+				else
+					func_idx = atoi(optarg);
 				break;
 
 			case 'l':
-				/* length of test */
-				len = atoi(optarg);
+				/* length or range of lengths */
+				if(parse_lens(optarg, &len, &len_end, &len_step))
+				{
+					fprintf(stderr, "Bad length range %s\n", optarg);
+					exit(1);
+				}
+				break;
+
+			case 'w':
+				warm = atoi(optarg);
+				break;
+
+			case 'r':
+				reps = atoi(optarg);
+				if(reps < 1)
+					reps = 1;
+				break;
+
+			case 'i':
+				inner = atoi(optarg);
+				if(inner < 1)
+					inner = 1;
+				break;
+
+			case 't':
+				if(!strcmp(optarg, "perf"))
+					tmr = BENCH_TMR_PERF;
+				else if(!strcmp(optarg, "rdcycle"))
+					tmr = BENCH_TMR_RDCYCLE;
+				else if(!strcmp(optarg, "ns"))
+					tmr = BENCH_TMR_NS;
+				break;
+
+			case 'o':
+				if(!strcmp(optarg, "csv"))
+					fmt = OUT_CSV;
+				else if(!strcmp(optarg, "json"))
+					fmt = OUT_JSON;
+				break;
+
+			case 'e':
+				tol_max = atof(optarg);
+				break;
+
+			case 'E':
+				tol_rms = atof(optarg);
 				break;
 
 			case 'v':
 				verbose = 1;
 				break;
-			
+
 			case 'V':
 				fprintf(stderr, "%s version %s\n", argv[0], swVersionStr);
 				exit(0);
-			
+
 			case 'h':
 			case '?':
 				fprintf(stderr, "USAGE: %s [options]\n", argv[0]);
 				fprintf(stderr, "Version %s, %s %s\n", swVersionStr, bdate, btime);
-				fprintf(stderr, "Options: -f <function> Default: %d\n", func_idx);
-				fprintf(stderr, "         -l <length>   Default: %d\n", len);
+				fprintf(stderr, "Options: -f <function>|all  Default: %d\n", func_idx);
+				fprintf(stderr, "         -l <len>[:<end>[:<step>]] Default: %d, doubles w/o step\n", len);
+				fprintf(stderr, "         -w <warm-up runs>  Default: %d\n", warm);
+				fprintf(stderr, "         -r <repetitions>   Default: %d\n", reps);
+				fprintf(stderr, "         -i <calls/sample>  Default: %d\n", inner);
+				fprintf(stderr, "         -t perf|rdcycle|ns Default: best available\n");
+				fprintf(stderr, "         -o text|csv|json   Default: text\n");
+				fprintf(stderr, "         -e <max err tol>   Default: %g\n", tol_max);
+				fprintf(stderr, "         -E <rms err tol>   Default: %g\n", tol_rms);
 				fprintf(stderr, "         -v enables verbose progress messages\n");
 				fprintf(stderr, "         -V prints the tool version\n");
 				fprintf(stderr, "         -h prints this help\n");
 				exit(1);
 		}
 	}
-	
+
 	/* make sure we're not trying to run an illegal snippet */
-	if(func_idx >= max_idx)
+	if(!all && (func_idx < 0 || func_idx >= max_idx))
 	{
 		fprintf(stderr, "Illegal function\n");
-		goto t_err;
-	}
-	
-	/* create all the data arrays */
-	if(!(t_in = malloc(len * 2 * sizeof(float))))
-		goto t_err;
-	if(!(r_out = malloc(len * 2 * sizeof(float))))
-		goto r_err;
-	if(!(u_out = malloc(len * 2 * sizeof(float))))
-		goto u_err;
-	
-	/* fill the test array */
-	for(i=0;i<len;i++)
-	{
-		t_in[2*i] = (float)i;
-		t_in[2*i + 1] = (float)i * -1.0f;
+		return 1;
 	}
-	
+
 	/* announce */
-	fprintf(stderr, "Testing Func %d: %s\n", func_idx, snfuncs[func_idx]->name);
-	
-	/* init the funcs */
-	if(snfuncs[func_idx]->init(len))
+	tmr = bench_timer_init(tmr);
 	{
-		fprintf(stderr, "Init of Func %d failed\n");
-		goto f_err;
+		char fstr[64];
+		fprintf(stderr, "CPU: %s, kernels: %s\n",
+			cpu_features_str(cpu_features(), fstr, sizeof(fstr)), kern_init()->name);
 	}
-	
-	/* reference */
-	memcpy(r_out, t_in, len * 2 * sizeof(float));
-	gettimeofday(&tv1, NULL);
-	snfuncs[func_idx]->scalar(r_out, len);
-	gettimeofday(&tv2, NULL);
-	time_scl = 1000000 * tv1.tv_sec + tv1.tv_usec;
-	time_scl = (1000000 * tv2.tv_sec + tv2.tv_usec) - time_scl;
-	
-	/* uut */
-	memcpy(u_out, t_in, len * 2 * sizeof(float));
-	gettimeofday(&tv1, NULL);
-	snfuncs[func_idx]->vector(u_out, len);
-	gettimeofday(&tv2, NULL);
-	time_vec = 1000000 * tv1.tv_sec + tv1.tv_usec;
-	time_vec = (1000000 * tv2.tv_sec + tv2.tv_usec) - time_vec;
-	
-	/* check results */
-	float i_err, q_err;
-	float i_acc = 0, q_acc = 0;
-	for(i=0;i<len;i++)
+	fprintf(stderr, "Timer: %s (%s), %d warm-up, %d reps of %d calls\n",
+		bench_timer_name(tmr), bench_timer_unit(), warm, reps, inner);
+
+	if(fmt == OUT_JSON)
+		printf("[\n");
+	for(; func_idx < max_idx; func_idx++)
 	{
-		i_err = r_out[2*i] - u_out[2*i];
-		q_err = r_out[2*i+1] - u_out[2*i+1];
-		
-		if(verbose)
+		int l;
+
+		for(l=len; l<=len_end; l = len_step ? l + len_step : 2*l)
 		{
-			fprintf(stdout, "%5d: (% 7.2f,% 7.2f) - (% 7.2f,% 7.2f) = (% 7.2f,% 7.2f)\n",
-				i,
-				r_out[2*i], r_out[2*i+1],
-				u_out[2*i], u_out[2*i+1],
-				i_err, q_err
-			);
+			if(run_one(func_idx, l, warm, reps, inner, verbose, tol_max, tol_rms, &res))
+			{
+				result_code = 1;
+				continue;
+			}
+			print_result(fmt, &res, first);
+			first = 0;
+			if((tmp = realloc(hist, (nhist + 1) * sizeof(result))))
+			{
+				hist = tmp;
+				hist[nhist++] = res;
+			}
+			if(!res.pass)
+				result_code = 1;
 		}
-		
-		i_acc += i_err;
-		q_acc += q_err;
+		if(!all)
+			break;
 	}
-	fprintf(stderr, "Accum. Err = (% 7.2f,% 7.2f)\n", i_acc, q_acc);
-	fprintf(stderr, "Scalar time: %ld us\n", time_scl);
-	fprintf(stderr, "Vector time: %ld us\n", time_vec);
-	fprintf(stderr, "Speedup: %5.2f %%\n", 100.0f *(((float)time_scl / (float)time_vec) - 1.0f));
-	
+	if(fmt == OUT_JSON)
+		printf("\n]\n");
+	print_patterns(fmt, hist, nhist);
+	free(hist);
+
 	/* clean up */
-	result = 0;
-f_err:
-	free(u_out);
-u_err:
-	free(r_out);
-r_err:
-	free(t_in);
-t_err:
-	return result;
-	
+	bench_timer_close();
+	return result_code;
 }
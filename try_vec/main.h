@@ -13,12 +13,21 @@
 #include <math.h>
 #include <riscv_vector.h>
 
+/*
+ * a code fragment in scalar and vector form - add new ones to snfuncs[] in
+ * main.c. init is called for every length before timing, cleanup (may be
+ * NULL) after it. Snippets of the same group that differ only in the memory
+ * access pattern of the vector version are compared against each other.
+ */
 typedef struct
 {
 	char *name;
 	int (*init)(int len);
+	void (*cleanup)(void);
 	void (*scalar)(float *pSrc, int len);
 	void (*vector)(float *pSrc, int len);
+	char *group;				// may be NULL
+	char *pattern;				// e.g. "strided", "segment"
 } snippet;
 
 void dump_vec(vfloat32m1_t v, size_t vl);
@@ -0,0 +1,15 @@
+#!/bin/sh
+# bench_widths.sh - compare pffft vector widths on the target
+# build the binaries first with 'make widths' and copy them over with this
+# script. Each line is the average time for one transform.
+for type in c r; do
+	for size in 1024 4096 16384 65536; do
+		for w in 0 4 8 16; do
+			if [ -x ./tst_pffft_$w ]; then
+				printf "width %2s: " $w
+				./tst_pffft_$w $size $type | tr '\n' ' '
+				echo
+			fi
+		done
+	done
+done
@@ -1,43 +1,98 @@
 /*
  * main.c - top level of tst_pffft for cv1800b
  * 09-16-25 E. Brombaugh
+ * 10-19-26 E. Brombaugh - fail on a bad cached setup placement
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <stdint.h>
 #include <math.h>
 #include "pffft.h"
+#include "pffft_fixed.h"
+#include "pffft_cache.h"
 
 #define ITER 100
 
+/*
+ * microseconds now
+ */
+static unsigned long get_us(void)
+{
+	struct timeval tv;
+	
+	gettimeofday(&tv,NULL);
+	return 1000000 * tv.tv_sec + tv.tv_usec;
+}
+
+/*
+ * signal to error ratio of a fixed-point result with block exponent e
+ * against the float one
+ */
+static float snr_db(const float *ref, const int32_t *res, int e, int n)
+{
+	double sig = 0, err = 0, d;
+	int i;
+	
+	for(i=0;i<n;i++)
+	{
+		d = ldexp(res[i], e) - ref[i];
+		sig += (double)ref[i]*ref[i];
+		err += d*d;
+	}
+	return err > 0 ? 10*log10(sig/err) : 999;
+}
+
 int main(int argc, char **argv)
 {
 	int cnt = ITER;
 	struct timeval tv;
 	unsigned long time_in_micros;
 	PFFFT_Setup *pffft_setup;
+	PFFFT_Fixed_Setup *fixed_setup;
+	PFFFT_Setup *placed;
+	void *setup_mem;
+	size_t setup_sz;
 	float *in, *work, *out;
+	int16_t *in15, *out15, *work15;
+	int32_t *in31, *out31, *work31, *res;
 	float flops, tavg;
-	int fftsz = 1024;
+	int fftsz = 1024, nf, e, i, rv = 0;
+	pffft_transform_t type = PFFFT_COMPLEX;
 	
 	if(argc > 1)
 		fftsz = atoi(argv[1]);
 	
+	/* optional 2nd arg 'r' for a real transform */
+	if(argc > 2 && argv[2][0] == 'r')
+		type = PFFFT_REAL;
+	
+	/* sizes must be a multiple of SIMD_SZ^2 (2*SIMD_SZ^2 for real) */
+	if(fftsz <= 0 || fftsz % pffft_min_fft_size(type))
+	{
+		fprintf(stderr, "FFT size %d is not a multiple of %d\n", fftsz,
+			pffft_min_fft_size(type));
+		exit(1);
+	}
+	
 	/* init a transform */
-	pffft_setup = pffft_new_setup(fftsz, PFFFT_COMPLEX);
+	pffft_setup = pffft_new_setup(fftsz, type);
 	if(!pffft_setup)
 	{
 		fprintf(stderr, "Unsupported FFT size %d\n", fftsz);
 		exit(1);
 	}
 	
-	flops = 5.0F*fftsz*log((float)fftsz)/M_LN2;
-	printf("FFT size %d => %f float ops\n", fftsz, flops);
+	/* real transforms take half the work */
+	flops = (type == PFFFT_REAL ? 2.5F : 5.0F)*fftsz*log((float)fftsz)/M_LN2;
+	printf("%s FFT size %d => %f float ops, SIMD size %d\n",
+		type == PFFFT_REAL ? "Real" : "Complex", fftsz, flops,
+		pffft_simd_size());
 	
-	/* create arrays */
-	in = (float *)malloc(sizeof(float)*2*fftsz);
-	work = (float *)malloc(sizeof(float)*2*fftsz);
-	out = (float *)malloc(sizeof(float)*2*fftsz);
+	/* create arrays - aligned for the widest vectors */
+	in = (float *)pffft_aligned_malloc(sizeof(float)*2*fftsz);
+	work = (float *)pffft_aligned_malloc(sizeof(float)*2*fftsz);
+	out = (float *)pffft_aligned_malloc(sizeof(float)*2*fftsz);
 	
 	/* init the input array with some data */
 	srand48(345353);
@@ -62,10 +117,90 @@ int main(int argc, char **argv)
 	printf("Average time = %f us/xfrm\n", tavg);
 	printf("%f MFLOPS\n", flops/tavg );
 	
+	/* fixed-point versions - same size set and output layout */
+	fixed_setup = pffft_fixed_new_setup(fftsz, type);
+	nf = type == PFFFT_REAL ? fftsz : 2*fftsz;
+	in15 = (int16_t *)malloc(sizeof(int16_t)*nf);
+	out15 = (int16_t *)malloc(sizeof(int16_t)*nf);
+	work15 = (int16_t *)malloc(sizeof(int16_t)*2*nf);
+	in31 = (int32_t *)malloc(sizeof(int32_t)*nf);
+	out31 = (int32_t *)malloc(sizeof(int32_t)*nf);
+	work31 = (int32_t *)malloc(sizeof(int32_t)*2*nf);
+	res = (int32_t *)malloc(sizeof(int32_t)*nf);
+	
+	/* full scale audio-like input, float reference from the same samples */
+	for(i=0;i<nf;i++)
+	{
+		in15[i] = (int16_t)((in[i] - 0.5F) * 65535.0F);
+		in31[i] = in15[i] * 65536;
+		in[i] = in15[i];
+	}
+	pffft_transform_ordered(pffft_setup, in, out, work, PFFFT_FORWARD);
+	
+	time_in_micros = get_us();
+	for(cnt=0;cnt<ITER;cnt++)
+		e = pffft_fixed_transform_q15(fixed_setup, in15, out15, work15, PFFFT_FORWARD);
+	tavg = (float)(get_us() - time_in_micros) / (float)ITER;
+	for(i=0;i<nf;i++)
+		res[i] = out15[i];
+	printf("Q15: %f us/xfrm, SNR %.1f dB\n", tavg, snr_db(out, res, e, nf));
+	
+	time_in_micros = get_us();
+	for(cnt=0;cnt<ITER;cnt++)
+		e = pffft_fixed_transform_q31(fixed_setup, in31, out31, work31, PFFFT_FORWARD);
+	tavg = (float)(get_us() - time_in_micros) / (float)ITER;
+	/* Q31 input is 16 bits up */
+	printf("Q31: %f us/xfrm, SNR %.1f dB\n", tavg, snr_db(out, out31, e - 16, nf));
+	
+	/* setup cost - computed vs copied from the cache into our own memory */
+	time_in_micros = get_us();
+	for(cnt=0;cnt<ITER;cnt++)
+		pffft_destroy_setup(pffft_new_setup(fftsz, type));
+	tavg = (float)(get_us() - time_in_micros) / (float)ITER;
+	printf("pffft_new_setup: %f us\n", tavg);
+	
+	pffft_cache_preload(fftsz, type);
+	setup_sz = pffft_setup_bytes(fftsz, type);
+	setup_mem = malloc(setup_sz);
+	placed = NULL;
+	time_in_micros = get_us();
+	for(cnt=0;setup_mem && cnt<ITER;cnt++)
+		placed = pffft_cache_place(setup_mem, setup_sz, fftsz, type);
+	tavg = (float)(get_us() - time_in_micros) / (float)ITER;
+	if(!placed)
+	{
+		fprintf(stderr, "pffft_cache_place failed for size %d\n", fftsz);
+		rv = 1;
+	}
+	else
+	{
+		printf("pffft_cache_place: %f us, %d bytes\n", tavg, (int)setup_sz);
+		pffft_transform_ordered(placed, in, work, 0, PFFFT_FORWARD);
+		for(i=0;i<nf;i++)
+			if(work[i] != out[i])
+				break;
+		if(i != nf)
+		{
+			printf("placed setup gives a different result at %d\n", i);
+			rv = 1;
+		}
+	}
+	free(setup_mem);
+	pffft_cache_clear();
+	
 	/* cleanup */
-	free(out);
-	free(work);
-	free(in);
+	free(res);
+	free(work31);
+	free(out31);
+	free(in31);
+	free(work15);
+	free(out15);
+	free(in15);
+	pffft_fixed_destroy_setup(fixed_setup);
+	pffft_aligned_free(out);
+	pffft_aligned_free(work);
+	pffft_aligned_free(in);
 	pffft_destroy_setup(pffft_setup);
-
+	
+	return rv;
 }
\ No newline at end of file
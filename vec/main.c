@@ -1,41 +1,31 @@
 /*
  * vector tests
  */
-#include <riscv_vector.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "simd.h"
+#include "cpu.h"
+#include "kern.h"
+
+#ifdef __riscv_vector
+#include <riscv_vector.h>
+#endif
 
 static inline float vector_dot_product(const float *a, const float *b, size_t n)
 {
-	if (n == 0)
-		return 0.0f;
-
-	/* vlmax = min(n, implementation VLmax) */
-	size_t vlmax = vsetvl_e32m1(n);
-
-	/* vector accumulator initialized to zero (uses vlmax lanes) */
-	vfloat32m1_t vacc = vfmv_v_f_f32m1(0.0f, vlmax);
-
+	simd_f32 vacc = simd_zero_f32();
+	float result;
 	size_t i = 0;
-	while (i < n) {
-		size_t vl = vsetvl_e32m1(n - i);
-		vfloat32m1_t va = vle32_v_f32m1(a + i, vl);
-		vfloat32m1_t vb = vle32_v_f32m1(b + i, vl);
-		/* vacc += va * vb */
-		vacc = vfmacc_vv_f32m1(vacc, va, vb, vl);
-		i += vl;
-	}
 
-	/* Reduce accumulator by storing lanes to memory and summing them */
-	float *tmp = (float *)malloc(vlmax * sizeof(float));
+	/* vacc += va * vb, SIMD_F32_LANES at a time */
+	for(; i + SIMD_F32_LANES <= n; i += SIMD_F32_LANES)
+		vacc = simd_fma_f32(simd_load_f32(a + i), simd_load_f32(b + i), vacc);
 
-	/* store vacc lanes to tmp (vl = vlmax) */
-	vse32_v_f32m1(tmp, vacc, vlmax);
+	/* reduce in the vector unit, then the tail */
+	result = simd_hsum_f32(vacc);
+	for(; i < n; i++)
+		result += a[i] * b[i];
 
-	float result = 0.0f;
-	for (size_t j = 0; j < vlmax; ++j) result += tmp[j];
-
-	free(tmp);
 	return result;
 }
 
@@ -47,12 +37,21 @@ int main()
 	printf("__riscv_v_intrinsic is not defined\n");
 #endif
 	
+#ifdef __riscv_vector
 	size_t vl = vsetvl_e32m1(8);
 	printf("Test VL: %zu\n", vl);
+#endif
+	printf("SIMD backend: %s\n", SIMD_NAME);
 	
-	const float a[8] = {1,1,1,1,1,1,1,1};
-	const float b[8] = {2,2,2,2,2,2,2,2};
-	printf("Test dot: %f\n", vector_dot_product(a, b, 8));
+	const float a[9] = {1,1,1,1,1,1,1,1,1};
+	const float b[9] = {2,2,2,2,2,2,2,2,2};
+	printf("Test dot: %f\n", vector_dot_product(a, b, 9));
+
+	/* the same through the kernels picked at run time */
+	char fstr[64];
+	printf("CPU features: %s\n", cpu_features_str(cpu_features(), fstr, sizeof(fstr)));
+	printf("Kernels: %s\n", kern_init()->name);
+	printf("Kernel dot: %f\n", kern_dot(a, b, 9));
 
 	return 0;
 }